@@ -0,0 +1,161 @@
+#ifndef BASICLEDCONTROLLER_H
+#define BASICLEDCONTROLLER_H
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include "BoardSpec.h"
+#include "Calibration.h"
+#include "LEDController.h"
+
+// Fixed-size controller for one board type: channel state lives in std::array
+// and frame size, header and loop bounds are compile-time constants, so the
+// randomize and pack loops unroll and the packet needs no heap allocation.
+// It covers the per-frame hot path only; LEDController stays the editable
+// model (ids, config files, spectra), and copyFrom() takes a snapshot of it.
+//
+// randomize() follows the rules and draw order of
+// LEDController::generateRandomFrame(), so both give the same frame for the
+// same RNG state.
+template <typename Board>
+class BasicLEDController
+{
+public:
+    static constexpr size_t kChannels = Board::kChannels;
+    static constexpr size_t kHeaderSize = Board::kHeader.size();
+    static constexpr size_t kPacketSize = kHeaderSize + kChannels;
+    using Frame = std::array<unsigned char, kChannels>;
+    using Packet = std::array<unsigned char, kPacketSize>;
+
+    BasicLEDController()
+    {
+        for (size_t i = 0; i < kChannels; ++i)
+        {
+            valid_[i] = Board::kLeds[i].peak != 0;
+            weight_[i] = std::max(Board::kLeds[i].maxRad, 0.0f) / 255.0f;
+            table_[i] = identityTable();
+        }
+    }
+
+    // Intensities, limits, locks, power budget and calibration of the first kChannels LEDs
+    void copyFrom(const LEDController &controller)
+    {
+        const size_t n = std::min(kChannels, controller.getLedCount());
+        for (size_t i = 0; i < n; ++i)
+        {
+            const LED &led = controller.getByIndex(i);
+            intensity_[i] = led.getIntensity();
+            min_[i] = led.getMinIntensity();
+            max_[i] = led.getMaxIntensity();
+            locked_[i] = led.isLocked();
+        }
+        powerBudget_ = controller.getPowerBudget();
+        setCalibration(*controller.getCalibration());
+    }
+
+    void setCalibration(const Calibration &calibration)
+    {
+        const size_t n = std::min(kChannels, calibration.getChannelCount());
+        for (size_t i = 0; i < n; ++i)
+            std::copy_n(calibration.getTable(i), 256, table_[i].begin());
+    }
+
+    void setIntensity(size_t channel, unsigned char value) { intensity_[channel] = value; }
+    void setLimits(size_t channel, unsigned char min, unsigned char max)
+    {
+        min_[channel] = min;
+        max_[channel] = max;
+    }
+    void setLocked(size_t channel, bool locked) { locked_[channel] = locked; }
+    void setPowerBudget(float budget) { powerBudget_ = budget; }
+    const Frame &getIntensities() const { return intensity_; }
+
+    // Same contract as LEDController::randomizeAll(), power of the calibrated bytes
+    bool randomize(std::mt19937 &rng)
+    {
+        float available = powerBudget_;
+        float power = 0;
+        for (size_t i = 0; i < kChannels; ++i)
+        {
+            const auto &table = table_[i];
+            if (!valid_[i] || locked_[i])
+            {
+                available -= weight_[i] * table[intensity_[i]];
+                continue;
+            }
+            const int lo = std::min(min_[i], max_[i]);
+            const int span = max_[i] - lo;
+            const int extra = span > 0 ? static_cast<int>(rng() % static_cast<uint32_t>(span + 1)) : 0;
+            intensity_[i] = static_cast<unsigned char>(lo + extra);
+            available -= weight_[i] * table[lo];
+            power += weight_[i] * std::max(table[intensity_[i]] - table[lo], 0);
+        }
+        if (powerBudget_ <= 0 || power <= available)
+            return true;
+
+        const float scale = available > 0 ? available / power : 0.0f;
+        for (size_t i = 0; i < kChannels; ++i)
+        {
+            if (!valid_[i] || locked_[i] || weight_[i] <= 0)
+                continue;
+            const auto &table = table_[i];
+            const int lo = std::min(min_[i], max_[i]);
+            const float limit = std::max(table[intensity_[i]] - table[lo], 0) * scale;
+            const int drawn = intensity_[i];
+            int v = lo + static_cast<int>((drawn - lo) * scale); // 线性表时即为结果
+            while (v > lo && table[v] - table[lo] > limit)
+                --v;
+            while (v < drawn && table[v + 1] - table[lo] <= limit)
+                ++v;
+            intensity_[i] = static_cast<unsigned char>(v);
+        }
+        return available >= 0;
+    }
+
+    // Header followed by the calibrated intensities
+    void pack(Packet &out) const
+    {
+        for (size_t i = 0; i < kHeaderSize; ++i)
+            out[i] = Board::kHeader[i];
+        for (size_t i = 0; i < kChannels; ++i)
+            out[kHeaderSize + i] = table_[i][intensity_[i]];
+    }
+
+    // sink(const unsigned char *, size_t), e.g. SerialInterface::sendData
+    template <typename Sink>
+    bool send(Sink &&sink, Packet &scratch) const
+    {
+        pack(scratch);
+        return sink(scratch.data(), scratch.size());
+    }
+
+private:
+    static std::array<unsigned char, 256> identityTable()
+    {
+        std::array<unsigned char, 256> t{};
+        for (size_t v = 0; v < 256; ++v)
+            t[v] = static_cast<unsigned char>(v);
+        return t;
+    }
+
+    Frame intensity_{};
+    Frame min_{};
+    Frame max_ = filled(255);
+    std::array<bool, kChannels> locked_{};
+    std::array<bool, kChannels> valid_{};
+    std::array<float, kChannels> weight_{};
+    std::array<std::array<unsigned char, 256>, kChannels> table_;
+    float powerBudget_ = 0;
+
+    static constexpr Frame filled(unsigned char value)
+    {
+        Frame f{};
+        f.fill(value);
+        return f;
+    }
+};
+
+using Lights30Controller = BasicLEDController<Lights30Board>;
+
+#endif // BASICLEDCONTROLLER_H
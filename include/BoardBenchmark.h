@@ -0,0 +1,12 @@
+#ifndef BOARDBENCHMARK_H
+#define BOARDBENCHMARK_H
+#include <string>
+#include <vector>
+
+// Tool mode: LightsDebugger boardbench [frames] [budget]
+// Times randomize + calibrate + packetize per frame on the dynamic
+// LEDController and on BasicLEDController<Lights30Board>, after checking that
+// both produce identical packets from the same seed.
+int runBoardBenchmark(const std::vector<std::string> &args);
+
+#endif // BOARDBENCHMARK_H
@@ -0,0 +1,56 @@
+#ifndef BOARDSPEC_H
+#define BOARDSPEC_H
+#include <array>
+#include <cstddef>
+#include "FramePacket.h"
+
+// Compile-time description of an LED board: channel table and packet header.
+// LEDController builds its LED list from one at run time; BasicLEDController
+// (see BasicLEDController.h) takes one as a template parameter.
+struct BoardChannel
+{
+    int id;
+    float peak;   // nm; 0 = not fitted, 1-3 = R/G/B, -1 = white
+    float maxRad; // radiation at intensity 255, 0 if unknown
+};
+
+// The current 30-channel board
+struct Lights30Board
+{
+    static constexpr size_t kChannels = 30;
+    static constexpr std::array<unsigned char, 2> kHeader = {FramePacket::kHeader0, FramePacket::kHeader1};
+    static constexpr std::array<BoardChannel, kChannels> kLeds = {{
+        {1, 405, 35000},
+        {2, 430, 50000},
+        {3, 450, 55000},
+        {4, 490, 27500},
+        {5, 505, 55000},
+        {6, 525, 37500},
+        {7, 545, 13000},
+        {8, 570, 8500},
+        {9, 590, 13000},
+        {10, 610, 65000},
+        {11, 625, 65000},
+        {12, 645, 65000},
+        {13, 660, 65000},
+        {14, 680, 50000},
+        {15, 750, 32500},
+        {16, 770, 30000},
+        {17, 800, 21000},
+        {18, 870, 0},
+        {19, 970, 0},
+        {20, 1050, 0},
+        {21, 1200, 0},
+        {22, 1300, 0},
+        {23, 1450, 0},
+        {24, 1550, 0},
+        {25, 1600, 0},
+        {26, 0, 0},
+        {27, 1, 0},  // RED LED
+        {28, 2, 0},  // GREEN LED
+        {29, 3, 0},  // BLUE LED
+        {30, -1, -1} // white LED
+    }};
+};
+
+#endif // BOARDSPEC_H
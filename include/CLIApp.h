@@ -3,20 +3,45 @@
 #include "LEDController.h"
 #include "SerialInterface.h"
 #include "CommandParser.h"
+#include "ControlServer.h"
+#include "ControlProtocol.h"
+#include "FrameRing.h"
+#include "Recorder.h"
+#include "FrameProtocol.h"
+#include "Sequencer.h"
+#include "CoroutineExecutor.h"
+#include "LightSequences.h"
+#include "ChannelSelector.h"
+#include "StateJournal.h"
+#include "TemporalDither.h"
+#include "FlightRecorder.h"
+#include "Clock.h"
+#include "FileWatcher.h"
+#include "TerminalView.h"
 #include <string>
 #include <vector>
 #include <map>
 #include <functional>
 #include <fstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
 
 class CLIApp
 {
 public:
-    CLIApp();
+    // restoreState: apply the state journal from the previous session.
+    // clock drives do/stream/sequencer timing and black box timestamps; a
+    // VirtualClock runs timed commands in simulated time.
+    explicit CLIApp(bool restoreState = true, Clock &clock = Clock::system());
+    ~CLIApp();
     void run();
 
 private:
     void setupCommands();
+    bool executeLine(const std::string &line);
+    bool dispatchLine(const std::string &line);
     void handleEmpty(const std::vector<std::string> &args);
     void handleSetCom(const std::vector<std::string> &args);
     void handleLS(const std::vector<std::string> &args);
@@ -24,6 +49,9 @@ private:
     void handleSetA(const std::vector<std::string> &args);
     void handleSetMA(const std::vector<std::string> &args);
     void handleSetM(const std::vector<std::string> &args);
+    void handleSetMin(const std::vector<std::string> &args);
+    void handleBudget(const std::vector<std::string> &args);
+    void handleSpectrum(const std::vector<std::string> &args);
     void handleRandom(const std::vector<std::string> &args);
     void handleSend(const std::vector<std::string> &args);
     void handleDo(const std::vector<std::string> &args);
@@ -36,27 +64,157 @@ private:
     void handleUnlock(const std::vector<std::string> &args);
     void handleRecord(const std::vector<std::string> &args);
     void handleReplay(const std::vector<std::string> &args);
+    void handleStream(const std::vector<std::string> &args);
+    void handleServe(const std::vector<std::string> &args);
+    void handleRing(const std::vector<std::string> &args);
+    void handleCalib(const std::vector<std::string> &args);
+    void handleLog(const std::vector<std::string> &args);
+    void handleProto(const std::vector<std::string> &args);
+    void handleTune(const std::vector<std::string> &args);
+    void handleSeq(const std::vector<std::string> &args);
+    void handleInteg(const std::vector<std::string> &args);
+    void handleTrace(const std::vector<std::string> &args);
+    void handleCo(const std::vector<std::string> &args);
+    void handleSel(const std::vector<std::string> &args);
+    void handleOp(const std::vector<std::string> &args);
+    void handleJournal(const std::vector<std::string> &args);
+    void handleDither(const std::vector<std::string> &args);
+    void handleSampler(const std::vector<std::string> &args);
+    void handleBlackbox(const std::vector<std::string> &args);
+    void handleClock(const std::vector<std::string> &args);
+    void handleSeed(const std::vector<std::string> &args);
+    void handleReload(const std::vector<std::string> &args);
+    void handleWatch(const std::vector<std::string> &args);
 
     // helpers
-    void maybeRecordPacket(const std::vector<unsigned char> &packet);
-    bool readNextReplayPacket(std::vector<unsigned char> &packet);
+    bool sendPacket(const std::vector<unsigned char> &packet, uint64_t version);
+    bool sendPacket(const unsigned char *packet, size_t size, uint64_t version);
+    bool sendCurrentFrame();
+    // After a failed write: dumps the black box once per run of failures, releasing lock first
+    void dumpBlackboxOnFailure(std::unique_lock<std::mutex> &lock);
+    // Compiles selector and evaluates it on the current state; prints the error on failure
+    bool selectLeds(const std::string &selector, ChannelMask &mask);
+    void applyBulk(const std::string &selector, LEDController::BulkOp op, float a, float b, const std::string &what);
+    bool readNextReplayPacket(std::vector<unsigned char> &packet, uint64_t &version);
+    // Text recording frames from..to (0-based, inclusive); prints the error on failure
+    bool loadRecording(const std::string &path, uint64_t from, uint64_t to, std::vector<unsigned char> &packets,
+                       std::vector<uint64_t> &versions);
+    void releaseLockedDither(); // locked LEDs are never dithered
+    size_t submitFrames(const unsigned char *frames, size_t count, size_t frameSize);
+    void streamLoop();
+    void stopStream();
+    void ringLoop();
+    void stopRing();
+    // Hot reload: the watcher thread parses and validates a changed file
+    // (rejected files keep the old config), the command thread applies it
+    bool stageReload(bool calibration, const std::string &path, std::string &message);
+    void applyPendingReload(); // command thread only; one atomic load when nothing is staged
+    void startWatcher();
+    void watchLoop();
+    void stopWatch();
+    // State owned by the command thread (the ring mapping, stream rate,
+    // sequence length, locks), copied by the dashboard under commandMutex_
+    struct DashboardState
+    {
+        ChannelMask locked = 0;
+        int streamHz = 0; // 0: not streaming
+        bool ringOpen = false;
+        uint64_t ringPending = 0;
+        uint64_t ringOverruns = 0;
+        bool seqRunning = false;
+        uint64_t seqPosition = 0;
+        size_t seqFrames = 0;
+        size_t coActive = 0;
+    };
+    void readDashboardState(DashboardState &state); // caller holds commandMutex_
+    void drawDashboard(TerminalView &view, const std::vector<unsigned char> &frame, uint64_t version,
+                       const DashboardState &state, double sendRate, double outputRate);
 
+    Clock &clock_;
     LEDController controller_;
     SerialInterface serial_;
     CommandParser parser_;
     std::string lastUsedPort_;
     std::string configFile_ = "led_config.cfg";
+    std::string calibFile_ = "led_calib.cfg";
+    ChannelSelector::Named selectors_;
+    std::string journalFile_ = "session.journal";
+    StateJournal journal_;
+    double recoveryMs_ = 0;
     std::map<std::string, std::function<void(const std::vector<std::string> &)>> commands;
 
     // recording state
-    bool isRecording_ = false;
-    std::string recordFilePath_ = "record.txt";
-    std::ofstream recordFile_;
+    Recorder recorder_;
 
     // replay state
     bool isReplaying_ = false;
     std::string replayFilePath_ = "record.txt";
     std::ifstream replayFile_;
+    uint64_t replayNext_ = 0; // index of the next frame in the file
+    uint64_t replayLast_ = 0; // last frame to replay (inclusive)
+
+    // streaming state
+    std::mutex sendMutex_; // serial_, recorder_ and the wire state are shared with the stream thread
+    FrameProtocol::Format wireFormat_ = FrameProtocol::Format::Raw8;
+    uint8_t frameCounter_ = 0;
+    std::vector<unsigned char> wire_; // reused encode buffer
+    FlightRecorder blackbox_;         // last sent frames, always on
+    std::atomic<bool> blackboxDumped_{false};
+    std::string blackboxFile_ = "blackbox.txt";
+    std::string blackboxErrorFile_ = "blackbox-error.txt";
+    std::string blackboxCrashFile_ = "blackbox-crash.txt";
+    std::thread streamThread_;
+    std::atomic<bool> isStreaming_{false};
+    std::atomic<uint64_t> streamFrames_{0};
+    std::atomic<uint64_t> streamErrors_{0};
+    std::atomic<uint64_t> streamIntervalSumUs_{0};
+    std::atomic<uint64_t> streamIntervalMaxUs_{0};
+    int streamHz_ = 50;
+    uint64_t streamCommand_ = 0; // command that started the stream, for the black box
+    std::atomic<uint64_t> framesSent_{0}; // every send path, for the dashboard
+    std::atomic<uint64_t> sendFailures_{0};
+    TemporalDither dither_{controller_.getLedCount()}; // fractional levels on streamed frames
+
+    // control server state
+    std::timed_mutex commandMutex_; // console and remote clients run commands one at a time
+    ControlServer server_;
+
+    // shared-memory ingress state
+    FrameRing ring_;
+    std::thread ringThread_;
+    std::atomic<bool> isRingRunning_{false};
+    std::atomic<uint64_t> ringSent_{0};
+    std::atomic<uint64_t> ringErrors_{0};
+    uint64_t ringCommand_ = 0;
+
+    // exposure-synchronized sequencer state
+    Sequencer sequencer_;
+    std::mt19937 seqRng_{std::random_device{}()}; // random sequences, reseeded by 'seed'
+
+    // hot reload state
+    FileWatcher watcher_;
+    std::mutex reloadMutex_; // staged results and lastReload_
+    std::shared_ptr<const LEDController::Limits> pendingLimits_;
+    std::shared_ptr<const Calibration> pendingCalibration_;
+    std::atomic<bool> reloadPending_{false};
+    std::atomic<uint64_t> reloadsApplied_{0};
+    std::atomic<uint64_t> reloadsRejected_{0};
+    std::string lastReload_;
+
+    // live dashboard state
+    std::thread watchThread_;
+    std::atomic<bool> isWatching_{false};
+    std::atomic<bool> watchRedraw_{false}; // screen was cleared, redraw every cell
+    int watchHz_ = 10;
+    std::vector<std::string> watchLabels_; // "id peak" per LED, fixed while watching
+
+    // timeline tracing state
+    std::string traceFile_ = "trace.json";
+
+    // concurrent coroutine sequences, all on one loop thread
+    CoroutineExecutor coroutines_;
+    std::shared_ptr<SequenceOverlay> overlay_;
+    size_t coSpawned_ = 0;
 };
 
 #endif // CLIAPP_H
@@ -0,0 +1,34 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+#include <cstddef>
+#include <vector>
+
+// Per-channel 256-entry lookup tables mapping a requested intensity to the
+// byte sent on the wire. Tables are stored back to back so a whole frame is
+// calibrated with one gather: out[i] = table[i * 256 + in[i]].
+class Calibration
+{
+public:
+    explicit Calibration(size_t channels);
+
+    size_t getChannelCount() const;
+
+    void setIdentity(size_t channel);
+    void setTable(size_t channel, const unsigned char *table);
+    // out = 255 * (in / 255)^gamma
+    void setGamma(size_t channel, float gamma);
+    // Inverse radiometric curve: emitted power ~ maxRadiation * (byte / 255)^gamma,
+    // so byte = 255 * ((in / 255) * reference / maxRadiation)^(1 / gamma). With the
+    // same reference on every channel, equal inputs give equal radiant power.
+    void setRadiometric(size_t channel, float gamma, float maxRadiation, float reference);
+
+    const unsigned char *getTable(size_t channel) const;
+    bool isIdentity() const;
+
+    void apply(const unsigned char *in, unsigned char *out, size_t count) const;
+
+private:
+    std::vector<unsigned char> tables_;
+};
+
+#endif // CALIBRATION_H
@@ -0,0 +1,55 @@
+#ifndef CHANNELSELECTOR_H
+#define CHANNELSELECTOR_H
+#include "LEDController.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// LED selector expressions compiled to channel bitmasks (see ChannelMask).
+//
+//   expr  := term { , term }             union
+//   term  := factor { & factor }         intersection
+//   factor:= ! factor | ( expr ) | atom
+//   atom  := l<a> | l<a>-l<b> | <a>nm | <a>-<b>nm | @<name>
+//          | all | none | valid | visible | uv | nir | rgb | white
+//          | locked | unlocked | on | off
+//
+// e.g. "l1-l10", "l3,l7,l9", "400-600nm", "visible&!locked". Wavelength atoms
+// match real peaks only (not the RGB/white codes); visible is 380-750 nm
+// (750 excluded), uv below 400 nm and nir from 750 nm. Static atoms are
+// folded into masks at compile time; locked/unlocked/on/off are read from
+// the controller on every evaluation, so a named "!locked" follows later
+// lock commands. @name inlines the named selector as defined at compile time.
+// A mask holds 64 channels; compile() rejects controllers with more LEDs.
+class ChannelSelector
+{
+public:
+    using Named = std::map<std::string, ChannelSelector>;
+
+    bool compile(const std::string &expression, const LEDController &controller, const Named &named,
+                 std::string &error);
+    ChannelMask evaluate(const LEDController &controller) const;
+    const std::string &getText() const;
+
+private:
+    enum class Op : uint8_t
+    {
+        Mask, // push a constant mask
+        Locked,
+        On,
+        Not,
+        And,
+        Or
+    };
+    struct Instr
+    {
+        Op op;
+        ChannelMask mask;
+    };
+    static constexpr size_t kMaxDepth = 32;
+
+    std::vector<Instr> program_; // postfix
+    std::string text_;
+};
+
+#endif // CHANNELSELECTOR_H
@@ -0,0 +1,53 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Time source for the controller and send paths (do, stream, sequencer, black
+// box timestamps). Clock::system() sleeps for real; a VirtualClock only moves
+// when a sleeper asks it to, so hour-long timed sequences finish in
+// milliseconds with reproducible timestamps. Measurements of real cost
+// (tracing, benchmarks, journal recovery) stay on std::chrono directly.
+class Clock
+{
+public:
+    using TimePoint = std::chrono::steady_clock::time_point;
+    using Duration = std::chrono::steady_clock::duration;
+
+    virtual ~Clock() = default;
+
+    virtual TimePoint now() const = 0;
+    // Plain sleep with OS timer granularity
+    virtual void sleepUntil(TimePoint deadline) = 0;
+    // Precise wait: sleeps in short slices, so running turning false ends it
+    // early, then spins the last timer tick. Returns running.
+    virtual bool waitUntil(TimePoint deadline, const std::atomic<bool> &running) = 0;
+    virtual std::chrono::system_clock::time_point toWallClock(TimePoint t) const = 0;
+    virtual bool isVirtual() const = 0;
+
+    void sleepFor(Duration d) { sleepUntil(now() + d); }
+
+    static Clock &system();
+};
+
+// Simulated time starting at 0 (shown as 1970-01-01 00:00:00 UTC). Sleeping
+// advances the clock to the deadline and returns at once. With one thread
+// sleeping on it the run is deterministic; concurrent sleepers share one
+// timeline that only moves forward.
+class VirtualClock : public Clock
+{
+public:
+    TimePoint now() const override;
+    void sleepUntil(TimePoint deadline) override;
+    bool waitUntil(TimePoint deadline, const std::atomic<bool> &running) override;
+    std::chrono::system_clock::time_point toWallClock(TimePoint t) const override;
+    bool isVirtual() const override;
+
+    void advance(Duration d);
+
+private:
+    std::atomic<int64_t> nowNs_{0};
+};
+
+#endif // CLOCK_H
@@ -0,0 +1,30 @@
+#ifndef CONTROLCLIENT_H
+#define CONTROLCLIENT_H
+#include <cstdint>
+#include <string>
+#include "ControlProtocol.h"
+
+// Client side of the local control server, for embedding programs and the load test.
+class ControlClient
+{
+public:
+    ControlClient();
+    ~ControlClient();
+
+    bool connect(uint16_t port = ControlProtocol::kDefaultPort);
+    void close();
+    bool isConnected() const;
+
+    // Sends one command line, returns true if the server answered OK
+    bool sendCommand(const std::string &line);
+    // Sends count frames of frameSize bytes in one message, returns frames sent (-1 on error)
+    long long sendFrames(const unsigned char *frames, uint32_t count, unsigned char frameSize);
+
+private:
+    bool readReply(std::string &reply);
+
+    class ControlClientImpl;
+    ControlClientImpl *impl_;
+};
+
+#endif // CONTROLCLIENT_H
@@ -0,0 +1,32 @@
+#ifndef CONTROLPROTOCOL_H
+#define CONTROLPROTOCOL_H
+#include <cstdint>
+
+// Wire format of the local control server.
+//
+// Text message : any CLI command line terminated by '\n' (first byte != 0).
+//                Reply: "OK\n" or "ERR\n".
+// Frame batch  : FrameBatchHeader followed by count * frameSize intensity bytes
+//                (no 0xDA 0xAD header, one byte per LED).
+//                Reply: "OK <frames sent>\n" or "ERR\n".
+namespace ControlProtocol
+{
+    constexpr uint16_t kDefaultPort = 7070;
+    constexpr unsigned char kBatchMagic0 = 0x00;
+    constexpr unsigned char kBatchMagic1 = 'F';
+    constexpr uint32_t kMaxBatchFrames = 65536;
+
+#pragma pack(push, 1)
+    struct FrameBatchHeader
+    {
+        unsigned char magic0;    // kBatchMagic0
+        unsigned char magic1;    // kBatchMagic1
+        unsigned char frameSize; // bytes per frame, must match the LED count
+        unsigned char reserved;
+        uint32_t count; // little endian
+    };
+#pragma pack(pop)
+    static_assert(sizeof(FrameBatchHeader) == 8, "FrameBatchHeader must be 8 bytes");
+}
+
+#endif // CONTROLPROTOCOL_H
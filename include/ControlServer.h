@@ -0,0 +1,53 @@
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Localhost TCP server that lets other programs drive the controller with the
+// same text commands as the console, or submit batches of binary frames.
+class ControlServer
+{
+public:
+    // Executes one command line, returns false for unknown/invalid commands
+    using CommandHandler = std::function<bool(const std::string &)>;
+    // Sends count frames of frameSize bytes, returns how many were sent
+    using FrameHandler = std::function<size_t(const unsigned char *, size_t, size_t)>;
+
+    ControlServer();
+    ~ControlServer();
+
+    bool start(uint16_t port, CommandHandler onCommand, FrameHandler onFrames);
+    void stop();
+    bool isRunning() const;
+
+    uint16_t getPort() const;
+    size_t getClientCount() const;
+    uint64_t getCommandCount() const;
+    uint64_t getFrameCount() const;
+
+private:
+    void acceptLoop();
+    void clientLoop(uintptr_t client);
+
+    class ControlServerImpl;
+    ControlServerImpl *impl_;
+
+    std::atomic<bool> running_{false};
+    uint16_t port_ = 0;
+    CommandHandler onCommand_;
+    FrameHandler onFrames_;
+    std::thread acceptThread_;
+    mutable std::mutex clientsMutex_;
+    std::condition_variable clientsDone_;
+    std::vector<uintptr_t> clients_; // client threads are detached, tracked here
+    std::atomic<uint64_t> commandCount_{0};
+    std::atomic<uint64_t> frameCount_{0};
+};
+
+#endif // CONTROLSERVER_H
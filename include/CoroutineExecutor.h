@@ -0,0 +1,203 @@
+#ifndef COROUTINEEXECUTOR_H
+#define COROUTINEEXECUTOR_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// Runs many timed sequences as C++20 coroutines on one loop thread.
+//
+// A sequence is a function returning CoroutineExecutor::Task; inside it,
+//   co_await executor.sleepUntil(t) / sleepFor(d)   waits on the timer heap
+//   co_await signal                                 waits for AsyncSignal::notify()
+//   bool ok = co_await executor.send(packet)        hands the write to the send
+//                                                   thread, resumes when it is done
+// The loop sleeps on a high-resolution waitable timer until shortly before
+// the earliest deadline and yield-spins the rest, so one core serves
+// thousands of sequences with sub-millisecond lateness. Serial writes never
+// run on the loop thread.
+class CoroutineExecutor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    // Writes one packet, called on the send thread
+    using SendHandler = std::function<bool(const unsigned char *, size_t)>;
+
+    class Task
+    {
+    public:
+        struct promise_type
+        {
+            CoroutineExecutor *executor = nullptr;
+
+            Task get_return_object()
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            std::suspend_always initial_suspend() noexcept { return {}; } // started by spawn()
+            auto final_suspend() noexcept
+            {
+                struct Finish
+                {
+                    bool await_ready() noexcept { return false; }
+                    void await_suspend(std::coroutine_handle<promise_type> h) noexcept { h.promise().executor->retire(h); }
+                    void await_resume() noexcept {}
+                };
+                return Finish{};
+            }
+            void return_void() {}
+            void unhandled_exception() {} // a failing sequence just ends
+        };
+
+        Task(Task &&other) noexcept : handle_(other.handle_) { other.handle_ = nullptr; }
+        Task(const Task &) = delete;
+        ~Task()
+        {
+            if (handle_)
+                handle_.destroy();
+        }
+
+    private:
+        friend class CoroutineExecutor;
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    // Timer lateness (resume time minus deadline) over all sleeps
+    struct Stats
+    {
+        uint64_t resumes = 0;
+        uint64_t sends = 0;
+        uint64_t sendErrors = 0;
+        double meanUs = 0, p50Us = 0, p99Us = 0, maxUs = 0;
+    };
+
+    CoroutineExecutor();
+    ~CoroutineExecutor();
+
+    bool start(SendHandler onSend);
+    // Stops the loop and destroys all unfinished sequences
+    void stop();
+    bool isRunning() const;
+
+    // Thread-safe: queues the sequence and starts it on the loop thread.
+    // Returns false (and drops the sequence) when the executor is not running.
+    bool spawn(Task task);
+    // Thread-safe: runs fn on the loop thread
+    void post(std::function<void()> fn);
+
+    size_t getActiveCount() const;
+    Stats getStats() const;
+    void resetStats();
+
+    struct SleepAwaiter
+    {
+        CoroutineExecutor &executor;
+        Clock::time_point deadline;
+        bool await_ready() const { return deadline <= Clock::now(); }
+        void await_suspend(std::coroutine_handle<> h) { executor.addTimer(deadline, h); }
+        void await_resume() const {}
+    };
+    SleepAwaiter sleepUntil(Clock::time_point deadline) { return {*this, deadline}; }
+    SleepAwaiter sleepFor(Clock::duration delay) { return {*this, Clock::now() + delay}; }
+
+    struct SendAwaiter
+    {
+        CoroutineExecutor &executor;
+        std::vector<unsigned char> packet;
+        bool result = false;
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> h) { executor.queueSend(this, h); }
+        bool await_resume() const { return result; }
+    };
+    SendAwaiter send(std::vector<unsigned char> packet) { return {*this, std::move(packet)}; }
+
+private:
+    friend class AsyncSignal;
+
+    struct Timer
+    {
+        Clock::time_point deadline;
+        uint64_t order; // FIFO among equal deadlines
+        std::coroutine_handle<> handle;
+        bool operator>(const Timer &other) const
+        {
+            return deadline != other.deadline ? deadline > other.deadline : order > other.order;
+        }
+    };
+    struct SendJob
+    {
+        SendAwaiter *awaiter;
+        std::coroutine_handle<> handle;
+    };
+
+    void loop();
+    void sendLoop();
+    void addTimer(Clock::time_point deadline, std::coroutine_handle<> h);
+    void queueSend(SendAwaiter *awaiter, std::coroutine_handle<> h);
+    void retire(std::coroutine_handle<Task::promise_type> h);
+    void recordLateness(Clock::duration late);
+
+    class CoroutineExecutorImpl;
+    CoroutineExecutorImpl *impl_;
+
+    std::atomic<bool> running_{false};
+    std::thread loopThread_;
+    SendHandler onSend_;
+
+    // loop thread only
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    uint64_t timerOrder_ = 0;
+
+    mutable std::mutex postMutex_; // also guards live_
+    std::unordered_set<void *> live_; // coroutine frames owned by the executor
+    std::vector<std::function<void()>> posted_;
+    std::atomic<bool> hasPosted_{false}; // lets the spin wait see posts without locking
+
+    std::thread sendThread_;
+    std::mutex sendMutex_;
+    std::condition_variable sendReady_;
+    std::deque<SendJob> sendQueue_;
+
+    // lateness histogram, 1 us buckets, last bucket collects everything longer
+    static constexpr size_t kHistogramBuckets = 20001;
+    std::unique_ptr<std::atomic<uint64_t>[]> histogram_;
+    std::atomic<uint64_t> resumes_{0};
+    std::atomic<uint64_t> latenessSumNs_{0};
+    std::atomic<uint64_t> latenessMaxNs_{0};
+    std::atomic<uint64_t> sends_{0};
+    std::atomic<uint64_t> sendErrors_{0};
+};
+
+// Wakes every sequence waiting on it; notify() may be called from any thread
+class AsyncSignal
+{
+public:
+    explicit AsyncSignal(CoroutineExecutor &executor) : executor_(executor) {}
+
+    void notify();
+
+    struct Awaiter
+    {
+        AsyncSignal &signal;
+        bool await_ready() const { return false; }
+        void await_suspend(std::coroutine_handle<> h) { signal.waiters_.push_back(h); }
+        void await_resume() const {}
+    };
+    Awaiter operator co_await() { return {*this}; }
+
+private:
+    CoroutineExecutor &executor_;
+    std::vector<std::coroutine_handle<>> waiters_; // loop thread only
+};
+
+#endif // COROUTINEEXECUTOR_H
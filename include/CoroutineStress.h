@@ -0,0 +1,12 @@
+#ifndef COROUTINESTRESS_H
+#define COROUTINESTRESS_H
+#include <string>
+#include <vector>
+
+// Tool mode: LightsDebugger costress [max sequences] [seconds per step]
+// Runs 1, 10, 100, ... periodic sequences (1-20 ms periods, every tenth frame
+// sent through a no-op writer, 1% waiting on a shared signal) on one
+// CoroutineExecutor and reports timer lateness per sequence count.
+int runCoroutineStress(const std::vector<std::string> &args);
+
+#endif // COROUTINESTRESS_H
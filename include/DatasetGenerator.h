@@ -0,0 +1,31 @@
+#ifndef DATASETGENERATOR_H
+#define DATASETGENERATOR_H
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Tool mode: LightsDebugger gen <count> <file> [seed] [threads]
+// Writes random frames (honoring led_config.cfg limits) and their modelled
+// spectra. Frames are generated in fixed-size chunks, each with its own seed,
+// so the output only depends on seed, not on the thread count.
+//
+// File layout: DatasetHeader, then count frames of `channels` bytes (frame
+// column), then count spectra of `points` float32 (spectrum column).
+struct DatasetHeader
+{
+    char magic[4]; // "LDGN"
+    uint32_t version;
+    uint64_t count;
+    uint64_t seed;
+    uint32_t channels;
+    uint32_t points;
+    float startNm;
+    float stepNm;
+    uint64_t framesOffset;
+    uint64_t spectraOffset;
+};
+static_assert(sizeof(DatasetHeader) == 56, "DatasetHeader must be 56 bytes");
+
+int runGenTool(const std::vector<std::string> &args);
+
+#endif // DATASETGENERATOR_H
@@ -0,0 +1,11 @@
+#ifndef ENCODERBENCHMARK_H
+#define ENCODERBENCHMARK_H
+#include <string>
+#include <vector>
+
+// Tool mode: LightsDebugger encbench [leds] [frames]
+// Encodes the same random frames with every wire format into a preallocated
+// buffer and reports ns/frame and output MB/s per encoder.
+int runEncoderBenchmark(const std::vector<std::string> &args);
+
+#endif // ENCODERBENCHMARK_H
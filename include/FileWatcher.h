@@ -0,0 +1,38 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Watches a few files for changes on a background thread. Each file's
+// directory is watched with ReadDirectoryChangesW (overlapped, no polling);
+// directories that do not support it (some network shares) fall back to
+// checking the last-write time every 500 ms. Editors write a file in several
+// steps or replace it by rename, so a change is reported once the file has
+// been quiet for settleMs.
+class FileWatcher
+{
+public:
+    // Runs on the watcher thread with the path as passed to start()
+    using ChangeHandler = std::function<void(const std::string &path)>;
+    // Runs on the watcher thread about every 50 ms, after pending changes are
+    // reported; must not block
+    using TickHandler = std::function<void()>;
+
+    FileWatcher();
+    ~FileWatcher();
+
+    bool start(const std::vector<std::string> &paths, ChangeHandler onChange, uint32_t settleMs = 200,
+               TickHandler onTick = nullptr);
+    void stop();
+    bool isRunning() const;
+    std::vector<std::string> getPaths() const;
+    size_t getPolledCount() const; // files watched by polling
+
+private:
+    class FileWatcherImpl;
+    FileWatcherImpl *impl_;
+};
+
+#endif // FILEWATCHER_H
@@ -0,0 +1,72 @@
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "RecordingFormat.h"
+#include "Clock.h"
+
+// Always-on RAM ring of the last N sent packets with their send time and the
+// command that produced them, dumped on demand as a replayable text recording
+// (see RecordingFormat.h) whose lines carry "; <time> <command>" comments.
+// Recording a frame is a timestamp and a 32-byte copy into a preallocated slot.
+//
+// record() and snapshot() are not synchronized: callers serialize them (CLIApp
+// calls both under its send lock). noteCommand() is thread-safe.
+class FlightRecorder
+{
+public:
+    struct Frame
+    {
+        int64_t timeNs; // since the clock's epoch
+        uint64_t version;
+        uint64_t command; // id from noteCommand(), 0 = none
+        uint32_t size;
+        unsigned char packet[RecordingFormat::kPacketSize];
+    };
+
+    explicit FlightRecorder(size_t capacity = 4096);
+
+    // Timestamps come from this clock (default Clock::system()); a virtual
+    // clock's times are dumped as UTC so they are reproducible
+    void setClock(const Clock &clock);
+
+    void record(const unsigned char *packet, size_t size, uint64_t version, uint64_t command);
+    // Remembers a command line for attribution, returns its id
+    uint64_t noteCommand(const std::string &line);
+
+    // Recorded frames, oldest first
+    std::vector<Frame> snapshot() const;
+    // Writes frames as a text recording; returns false with error on failure
+    bool dump(const std::vector<Frame> &frames, const std::string &path, std::string &error) const;
+
+    // Best-effort dump of the ring to path on an unhandled exception (SEH) or
+    // std::terminate; one recorder per process
+    void installCrashDump(const std::string &path);
+
+    size_t getCapacity() const;
+    uint64_t getRecorded() const; // total since start, including overwritten frames
+
+private:
+    static constexpr size_t kCommandSlots = 256;
+
+    void writeFrames(std::FILE *file, const Frame *frames, size_t count, bool lockCommands) const;
+    void crashDump() const;
+    friend struct FlightRecorderCrashHook;
+
+    const Clock *clock_ = &Clock::system();
+    std::vector<Frame> ring_;
+    uint64_t head_ = 0;
+
+    mutable std::mutex commandMutex_;
+    uint64_t nextCommand_ = 1;
+    std::vector<std::string> commands_; // id % kCommandSlots
+    std::vector<uint64_t> commandIds_;
+
+    std::string crashPath_;
+};
+
+#endif // FLIGHTRECORDER_H
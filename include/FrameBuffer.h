@@ -0,0 +1,30 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Seqlock-protected front buffer holding the last published frame.
+// One writer (the command thread) publishes, any number of readers
+// (e.g. the streaming thread) take consistent copies without locking.
+class FrameBuffer
+{
+public:
+    explicit FrameBuffer(size_t size);
+
+    size_t size() const;
+
+    // Publish a new frame, returns its version (starts at 1).
+    uint64_t publish(const unsigned char *data);
+
+    // Copy the current frame into out (size() bytes), returns its version.
+    uint64_t read(unsigned char *out) const;
+
+    uint64_t version() const;
+
+private:
+    std::atomic<uint64_t> seq_{0};
+    std::vector<std::atomic<unsigned char>> data_;
+};
+
+#endif // FRAMEBUFFER_H
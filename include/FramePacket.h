@@ -0,0 +1,24 @@
+#ifndef FRAMEPACKET_H
+#define FRAMEPACKET_H
+#include <cstddef>
+#include <vector>
+
+class Calibration;
+
+// Serial packet layout: 0xDA 0xAD header followed by one byte per LED.
+namespace FramePacket
+{
+    constexpr unsigned char kHeader0 = 0xDA;
+    constexpr unsigned char kHeader1 = 0xAD;
+    constexpr size_t kHeaderSize = 2;
+
+    // Builds the packet for one frame of `size` intensity bytes
+    void build(const unsigned char *frame, size_t size, std::vector<unsigned char> &packet);
+
+    // Packetizes count frames of frameSize bytes back to back into batch, passing
+    // each frame through calibration (nullptr sends raw bytes)
+    void buildBatch(const unsigned char *frames, size_t count, size_t frameSize, const Calibration *calibration,
+                    std::vector<unsigned char> &batch);
+}
+
+#endif // FRAMEPACKET_H
@@ -0,0 +1,226 @@
+#ifndef FRAMEPROTOCOL_H
+#define FRAMEPROTOCOL_H
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Wire encodings of one frame. Every packet starts with 0xDA and a format byte:
+//
+//   8     DA AD + one byte per LED (the original format, what recordings store)
+//   10    DA A2 + 10-bit intensities packed MSB first, 4 LEDs in 5 bytes
+//   12    DA A4 + 12-bit intensities packed MSB first, 2 LEDs in 3 bytes
+//   8c/10c/12c  the same with a trailer: frame counter byte, then CRC-16/CCITT
+//         (poly 0x1021, init 0xFFFF, big endian) over everything before it
+//
+// Packed formats pad the last byte with zero bits. The encoders are templates
+// on bit depth and trailer, so each variant compiles to its own loop writing
+// straight into a caller-provided buffer.
+namespace FrameProtocol
+{
+    enum class Format : uint8_t
+    {
+        Raw8,
+        Raw8Crc,
+        Packed10,
+        Packed10Crc,
+        Packed12,
+        Packed12Crc,
+        Count
+    };
+
+    constexpr unsigned char kHeader0 = 0xDA;
+
+    constexpr std::array<uint16_t, 256> makeCrcTable()
+    {
+        std::array<uint16_t, 256> table{};
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            uint16_t crc = static_cast<uint16_t>(i << 8);
+            for (int b = 0; b < 8; ++b)
+                crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+            table[i] = crc;
+        }
+        return table;
+    }
+    inline constexpr std::array<uint16_t, 256> kCrcTable = makeCrcTable();
+
+    constexpr uint16_t crcUpdate(uint16_t crc, unsigned char byte)
+    {
+        return static_cast<uint16_t>((crc << 8) ^ kCrcTable[((crc >> 8) ^ byte) & 0xFF]);
+    }
+
+    template <unsigned Bits, bool Trailer>
+    struct Encoder
+    {
+        static_assert(Bits >= 8 && Bits <= 16, "bit depth must be 8-16");
+
+        static constexpr unsigned kBits = Bits;
+        static constexpr uint16_t kMaxLevel = static_cast<uint16_t>((1u << Bits) - 1);
+        static constexpr unsigned char kHeader1 =
+            (Bits == 8 && !Trailer) ? 0xAD : static_cast<unsigned char>(0xA0 + (Bits - 8) + (Trailer ? 1 : 0));
+        static constexpr size_t kTrailerSize = Trailer ? 3 : 0;
+
+        static constexpr size_t payloadSize(size_t leds) { return (leds * Bits + 7) / 8; }
+        static constexpr size_t packetSize(size_t leds) { return 2 + payloadSize(leds) + kTrailerSize; }
+
+        // 8-bit level to this depth by bit replication: 0 -> 0, 255 -> kMaxLevel
+        static constexpr uint16_t widen(unsigned char v)
+        {
+            if constexpr (Bits == 8)
+                return v;
+            else
+                return static_cast<uint16_t>((v << (Bits - 8)) | (v >> (16 - Bits)));
+        }
+
+        // levels are Bits-wide (higher bits are ignored); out holds packetSize(leds) bytes.
+        // One pass over the input; the CRC then runs over the just-written bytes.
+        template <typename Level>
+        static size_t encode(const Level *levels, size_t leds, uint8_t counter, unsigned char *out)
+        {
+            unsigned char *p = out;
+            *p++ = kHeader0;
+            *p++ = kHeader1;
+            auto level = [&](size_t i) -> uint32_t
+            {
+                if constexpr (sizeof(Level) == 1)
+                    return widen(static_cast<unsigned char>(levels[i]));
+                else
+                    return levels[i] & kMaxLevel;
+            };
+            size_t i = 0;
+            if constexpr (Bits == 8)
+            {
+                if constexpr (sizeof(Level) == 1)
+                {
+                    std::memcpy(p, levels, leds);
+                    p += leds;
+                    i = leds;
+                }
+            }
+            else if constexpr (Bits == 10)
+            {
+                for (; i + 4 <= leds; i += 4, p += 5) // 4 LEDs -> 5 bytes
+                {
+                    const uint64_t v = (uint64_t(level(i)) << 30) | (level(i + 1) << 20) | (level(i + 2) << 10) | level(i + 3);
+                    p[0] = static_cast<unsigned char>(v >> 32);
+                    p[1] = static_cast<unsigned char>(v >> 24);
+                    p[2] = static_cast<unsigned char>(v >> 16);
+                    p[3] = static_cast<unsigned char>(v >> 8);
+                    p[4] = static_cast<unsigned char>(v);
+                }
+            }
+            else if constexpr (Bits == 12)
+            {
+                for (; i + 2 <= leds; i += 2, p += 3) // 2 LEDs -> 3 bytes
+                {
+                    const uint32_t v = (level(i) << 12) | level(i + 1);
+                    p[0] = static_cast<unsigned char>(v >> 16);
+                    p[1] = static_cast<unsigned char>(v >> 8);
+                    p[2] = static_cast<unsigned char>(v);
+                }
+            }
+            // Remaining LEDs (all of them for other depths) through a bit accumulator
+            uint32_t acc = 0;
+            unsigned pending = 0; // low bits of acc not yet written
+            for (; i < leds; ++i)
+            {
+                acc = (acc << Bits) | level(i);
+                pending += Bits;
+                while (pending >= 8)
+                {
+                    pending -= 8;
+                    *p++ = static_cast<unsigned char>(acc >> pending);
+                }
+            }
+            if (pending)
+                *p++ = static_cast<unsigned char>(acc << (8 - pending));
+
+            if constexpr (Trailer)
+            {
+                *p++ = counter;
+                uint16_t crc = 0xFFFF;
+                for (const unsigned char *q = out; q < p; ++q)
+                    crc = crcUpdate(crc, *q);
+                *p++ = static_cast<unsigned char>(crc >> 8);
+                *p++ = static_cast<unsigned char>(crc & 0xFF);
+            }
+            return static_cast<size_t>(p - out);
+        }
+
+        // Inverse of encode for a whole packet of packetSize(leds) bytes: frame
+        // gets the top 8 bits of each level, so encode8 -> decode8 round-trips.
+        // False if the header or (with a trailer) the CRC does not match.
+        static bool decode8(const unsigned char *packet, size_t leds, unsigned char *frame)
+        {
+            if (packet[0] != kHeader0 || packet[1] != kHeader1)
+                return false;
+            const unsigned char *p = packet + 2;
+            if constexpr (Trailer)
+            {
+                const size_t covered = 2 + payloadSize(leds) + 1;
+                uint16_t crc = 0xFFFF;
+                for (size_t i = 0; i < covered; ++i)
+                    crc = crcUpdate(crc, packet[i]);
+                if (packet[covered] != (crc >> 8) || packet[covered + 1] != (crc & 0xFF))
+                    return false;
+            }
+            if constexpr (Bits == 8)
+            {
+                std::memcpy(frame, p, leds);
+            }
+            else
+            {
+                uint32_t acc = 0;
+                unsigned pending = 0;
+                for (size_t i = 0; i < leds; ++i)
+                {
+                    while (pending < Bits)
+                    {
+                        acc = (acc << 8) | *p++;
+                        pending += 8;
+                    }
+                    pending -= Bits;
+                    frame[i] = static_cast<unsigned char>((acc >> pending) >> (Bits - 8));
+                }
+            }
+            return true;
+        }
+    };
+
+    using Raw8 = Encoder<8, false>;
+    using Raw8Crc = Encoder<8, true>;
+    using Packed10 = Encoder<10, false>;
+    using Packed10Crc = Encoder<10, true>;
+    using Packed12 = Encoder<12, false>;
+    using Packed12Crc = Encoder<12, true>;
+
+    // Runtime selection per board: one entry per Format, pointing at the
+    // specialized encoder
+    struct EncoderOps
+    {
+        Format format;
+        const char *name;
+        unsigned bits;
+        unsigned char header1;
+        size_t (*packetSize)(size_t leds);
+        size_t (*encode8)(const unsigned char *frame, size_t leds, uint8_t counter, unsigned char *out);
+        size_t (*encode16)(const uint16_t *levels, size_t leds, uint8_t counter, unsigned char *out);
+        bool (*decode8)(const unsigned char *packet, size_t leds, unsigned char *frame);
+    };
+
+    const EncoderOps &ops(Format format);
+    bool parseFormat(const std::string &name, Format &format);
+    // Format whose packets start with DA header1; nullptr if none
+    const EncoderOps *findByHeader(unsigned char header1);
+
+    // Re-encodes count canonical 8-bit packets (DA AD + frameSize bytes each)
+    // into the wire format, numbering them from counter; returns the wire size.
+    // wire is resized, never shrunk, so a reused buffer stops allocating.
+    size_t encodeBatch(Format format, const unsigned char *packets, size_t count, size_t frameSize, uint8_t &counter,
+                       std::vector<unsigned char> &wire);
+}
+
+#endif // FRAMEPROTOCOL_H
@@ -0,0 +1,42 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Consumer side of the shared-memory frame ring (see LightsRing.h for the
+// producer API and memory layout).
+class FrameRing
+{
+public:
+    // Called with a complete packet in shared memory and its sequence number;
+    // the slot stays reserved until the handler returns.
+    using PacketHandler = std::function<void(const unsigned char *, size_t, uint64_t)>;
+
+    static const char *const kDefaultName;
+    static const uint32_t kDefaultCapacity;
+
+    FrameRing();
+    ~FrameRing();
+
+    bool create(const std::string &name, uint32_t capacity);
+    void close();
+    bool isOpen() const;
+
+    // Waits up to timeoutMs for frames, hands every queued frame to handler,
+    // returns the number of frames consumed.
+    size_t consume(const PacketHandler &handler, unsigned timeoutMs);
+
+    std::string getName() const;
+    uint32_t getCapacity() const;
+    uint64_t getConsumed() const;
+    uint64_t getPending() const;
+    uint64_t getOverruns() const;
+
+private:
+    class FrameRingImpl;
+    FrameRingImpl *impl_;
+    std::string name_;
+};
+
+#endif // FRAMERING_H
@@ -0,0 +1,56 @@
+#ifndef INTENSITYOPTIMIZER_H
+#define INTENSITYOPTIMIZER_H
+#include <cstddef>
+#include <vector>
+
+// Bounded damped Gauss-Newton for "which intensities give this reading".
+//
+// The measurement is modelled as linear in the intensities, y = J x. J starts
+// from the spectral model (or finite-difference probes) and after each
+// measurement gets a Broyden rank-1 correction from the observed change, so
+// model errors (gain, peak shifts, calibration) are learned on the fly. Each
+// step solves (J'J + lambda diag(J'J)) dx = J'(target - y) over the free
+// channels; channels that would leave [lo, hi] are pinned to the bound and the
+// rest re-solved. A step that makes the residual worse is retried from the
+// best frame with more damping.
+class IntensityOptimizer
+{
+public:
+    IntensityOptimizer(size_t measurements, size_t channels);
+
+    size_t getMeasurementCount() const;
+    size_t getChannelCount() const;
+
+    // Row-major measurements x channels, d(measurement)/d(intensity step)
+    void setJacobian(const std::vector<float> &jacobian);
+    // lo == hi fixes the channel (locked or without effect)
+    void setBounds(size_t channel, float lo, float hi);
+
+    // Feeds the measurement of frame x and returns the next frame to try.
+    // Returns the relative residual |target - measured| / |target|.
+    double step(const std::vector<float> &x, const std::vector<float> &measured, const std::vector<float> &target,
+                std::vector<float> &next);
+
+    // Frame with the lowest residual seen so far, and its residual norm
+    const std::vector<float> &getBest() const;
+    double getBestResidual() const;
+
+private:
+    void solve(const std::vector<float> &from, const std::vector<double> &residual, std::vector<float> &next) const;
+
+    size_t m_;
+    size_t n_;
+    std::vector<double> jac_;
+    std::vector<float> lo_;
+    std::vector<float> hi_;
+    double lambda_ = 1e-3;
+    bool hasPrevious_ = false;
+    bool gainFitted_ = false;
+    std::vector<float> prevX_;
+    std::vector<float> prevY_;
+    std::vector<float> best_;
+    std::vector<double> bestResidual_; // target - measured at best_
+    double bestNorm_ = -1;
+};
+
+#endif // INTENSITYOPTIMIZER_H
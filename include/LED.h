@@ -14,7 +14,8 @@ public:
     unsigned char getMaxIntensity() const;
     void setMaxIntensity(unsigned char value);
 
-    void randomizeIntensity();
+    unsigned char getMinIntensity() const;
+    void setMinIntensity(unsigned char value);
 
     int getId() const;
     float getPeakWavelength() const;
@@ -30,6 +31,7 @@ private:
     float maxRadiation_;
     unsigned char intensity_;
     unsigned char maxIntensity_ = 255;
+    unsigned char minIntensity_ = 0;
     bool locked_ = false;
 };
 
@@ -4,12 +4,38 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <random>
 #include "LED.h"
+#include "FrameBuffer.h"
+#include "Calibration.h"
+#include "SpectralModel.h"
+#include "LowDiscrepancy.h"
+#include "RecordingFormat.h"
+
+// Bit i selects the LED at index i (LED id i + 1), see ChannelSelector.h
+using ChannelMask = uint64_t;
 
 class LEDController
 {
 public:
-    explicit LEDController(size_t count = 30);
+    // Operations applied to a whole ChannelMask at once
+    enum class BulkOp
+    {
+        Set,       // intensity = a
+        Scale,     // intensity *= a
+        Add,       // intensity += a
+        Clamp,     // intensity into [a, b]
+        SetMax,    // max intensity = a
+        SetMin,    // min random intensity = a
+        Lock,
+        Unlock,
+        Randomize  // like randomizeAll(), LEDs outside the mask stay fixed
+    };
+
+    LEDController(); // LEDs of Lights30Board
 
     LED &getById(int id);
     const LED &getById(int id) const;
@@ -17,18 +43,127 @@ public:
     LED &getByPeak(float peak);
     const LED &getByPeak(float peak) const;
 
+    size_t getLedCount() const;
+    LED &getByIndex(size_t index);
+    const LED &getByIndex(size_t index) const;
+
+    // Intensity ops skip locked and unregistered LEDs and saturate to 0-255.
+    // Runs as one pass over gathered arrays; returns the number of LEDs changed.
+    size_t applyMasked(ChannelMask mask, BulkOp op, float a = 0, float b = 0);
+    ChannelMask getLockedMask() const;
+    ChannelMask getLitMask() const; // intensity > 0
+
     void setPortName(const std::string &portName);
     std::string getPortName() const;
 
-    void randomizeAll();
+    // Returns false if the power budget cannot be met (locked LEDs and
+    // minimums alone exceed it); radiating free LEDs are then left at their minimums.
+    bool randomizeAll();
+    // Draws a random frame with the same rules as randomizeAll() without
+    // changing any LED, for generators that bring their own RNG.
+    bool generateRandomFrame(std::mt19937 &rng, unsigned char *out) const;
+    void seedRandom(uint32_t seed);
+
+    // Space-filling random frames: randomizeAll() takes the next point of a
+    // scrambled Sobol/Halton sequence instead of independent uniform draws.
+    // Dimensions go to the unlocked valid LEDs in id order; limits and the
+    // power budget apply as for uniform frames.
+    void setSequence(LowDiscrepancySequence::Kind kind, uint32_t seed, uint64_t index = 0);
+    void clearSequence();
+    const LowDiscrepancySequence *getSequence() const;
+    // Sample tag of the published frame if it is the last sampled frame unchanged:
+    // true when version and the calibrated bytes match; safe from any thread.
+    bool getSampleTag(uint64_t version, const unsigned char *frame, size_t size,
+                      RecordingFormat::SampleTag &tag) const;
+
+    // Radiant power budget in maxRadiation units (sum of sent byte / 255 * maxRadiation, after calibration),
+    // <= 0 disables it. Random frames are drawn directly inside the budget, no retries.
+    void setPowerBudget(float budget);
+    float getPowerBudget() const;
+    float getFramePower() const;
     std::vector<unsigned char> getIntensityData() const;
 
+    // Publish the edited LED state as a new frame (no-op if unchanged).
+    // Returns the current frame version.
+    uint64_t publish();
+    // Lock-free copy of the last published frame, safe from any thread.
+    uint64_t readFrame(std::vector<unsigned char> &out) const;
+    uint64_t frameVersion() const;
+
+    // Config file: "<id> <max intensity>" lines, then "Integrate time: <us>us"
     bool saveMaxIntensities(const std::string &filename) const;
     bool loadMaxIntensities(const std::string &filename);
 
+    // Parsed config file, for parsing off the command thread (hot reload) and
+    // applying later in one step
+    struct Limits
+    {
+        std::vector<std::pair<size_t, unsigned char>> maxIntensity; // by LED index
+        bool hasIntegrationTime = false;
+        uint32_t integrationUs = 0;
+    };
+    // Returns false if the file cannot be opened; skipped entries go to warnings
+    bool parseMaxIntensities(const std::string &filename, Limits &limits, std::vector<std::string> &warnings) const;
+    void applyLimits(const Limits &limits);
+
+    // Camera integration (exposure) time each frame is held for, and the
+    // extra settling time after the LEDs switch
+    void setIntegrationTime(uint32_t us);
+    uint32_t getIntegrationTime() const;
+    void setSettleTime(uint32_t us);
+    uint32_t getSettleTime() const;
+
+    // Modelled emission spectrum of the current frame as sent, i.e. after
+    // calibration (see SpectralModel.h).
+    // The per-LED profile tables are cached until the grid changes.
+    void setSpectralGrid(float startNm, float stepNm, size_t points);
+    const SpectralModel &getSpectralModel() const;
+    std::vector<float> computeSpectrum() const;
+
+    // Calibration tables applied when frames are published (see Calibration.h).
+    // File lines: <id|all> identity | gamma <g> | radiometric [gamma] [reference] | table <256 values>
+    bool loadCalibration(const std::string &filename);
+    // nullptr if the file cannot be opened or is invalid (then error says where)
+    std::shared_ptr<const Calibration> parseCalibration(const std::string &filename, std::string &error) const;
+    void setCalibration(std::shared_ptr<const Calibration> calibration);
+    void clearCalibration();
+    std::shared_ptr<const Calibration> getCalibration() const;
+    // Frame as sent on the wire: current intensities passed through the tables
+    std::vector<unsigned char> getCalibratedData() const;
+
 private:
+    size_t indexOf(int id) const;
+    // generateRandomFrame() treating LEDs outside `free` as locked
+    bool generateRandomFrame(std::mt19937 &rng, unsigned char *out, ChannelMask free) const;
+    // Shared frame rules; draw(span) returns the step above the minimum in [0, span]
+    // and is called once per free LED in index order
+    template <typename Draw>
+    bool drawFrame(unsigned char *out, ChannelMask free, Draw &&draw) const;
+
     std::vector<LED> leds_;
     std::string port_name_;
+    float powerBudget_ = 0;
+    uint32_t integrationUs_ = 200000;
+    uint32_t settleUs_ = 2000;
+    std::mt19937 rng_{std::random_device{}()};
+    std::unique_ptr<SpectralModel> spectralModel_;
+    std::unique_ptr<LowDiscrepancySequence> sequence_; // null: uniform frames
+    RecordingFormat::SampleTag sampleTag_{};
+    std::vector<unsigned char> sampleFrame_; // intensities of the last sampled frame
+
+    struct PublishedSample
+    {
+        uint64_t version;
+        RecordingFormat::SampleTag tag;
+        std::vector<unsigned char> frame; // calibrated
+    };
+
+    // leds_ is the back buffer edited by commands, frame_ the published front
+    FrameBuffer frame_;
+    std::vector<unsigned char> published_;
+    // swapped atomically, read by send paths on other threads
+    std::atomic<std::shared_ptr<const Calibration>> calibration_;
+    std::atomic<std::shared_ptr<const PublishedSample>> sample_;
 };
 
 #endif // LEDCONTROLLER_H
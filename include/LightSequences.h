@@ -0,0 +1,40 @@
+#ifndef LIGHTSEQUENCES_H
+#define LIGHTSEQUENCES_H
+#include "CoroutineExecutor.h"
+#include <memory>
+#include <vector>
+
+class LEDController;
+
+// Channels currently driven by running sequences. Sent frames are the last
+// published frame with these channels replaced. A sequence releases its
+// channel when it finishes or is destroyed. Loop thread only.
+struct SequenceOverlay
+{
+    explicit SequenceOverlay(size_t ledCount) : value(ledCount, 0), active(ledCount, 0) {}
+
+    // Published frame + overlay, calibrated, as a packet
+    std::vector<unsigned char> buildPacket(const LEDController &controller) const;
+
+    std::vector<unsigned char> value; // intensities before calibration
+    std::vector<unsigned> active; // sequences driving each channel
+};
+
+namespace LightSequences
+{
+    // Steps channel from `from` to `to` over durationMs, one frame every stepMs
+    CoroutineExecutor::Task ramp(CoroutineExecutor &executor, const LEDController &controller,
+                                 std::shared_ptr<SequenceOverlay> overlay, size_t channel, int from, int to,
+                                 unsigned durationMs, unsigned stepMs);
+
+    // Switches channel between value and 0, count pulses (0 = until stopped)
+    CoroutineExecutor::Task pulse(CoroutineExecutor &executor, const LEDController &controller,
+                                  std::shared_ptr<SequenceOverlay> overlay, size_t channel, int value, unsigned onMs,
+                                  unsigned offMs, unsigned count);
+
+    // Sends recorded packets one every periodMs, loops times (0 = until stopped)
+    CoroutineExecutor::Task replay(CoroutineExecutor &executor, std::vector<unsigned char> packets, size_t packetSize,
+                                   unsigned periodMs, unsigned loops);
+}
+
+#endif // LIGHTSEQUENCES_H
@@ -0,0 +1,88 @@
+/*
+ * lightscore C API: drive an LED board in-process without the console.
+ *
+ * A device bundles the LED model (limits, calibration), the serial port and an
+ * optional recording. Functions return LC_OK (0) or a negative LC_ERR_* code.
+ * A device is not thread-safe; use one per thread or serialize calls.
+ *
+ * Link the static library (defines LIGHTSCORE_STATIC) or the lightscore_shared
+ * DLL, which exports only this API.
+ */
+#ifndef LIGHTSCORE_H
+#define LIGHTSCORE_H
+#include <stddef.h>
+
+#if defined(_WIN32) && !defined(LIGHTSCORE_STATIC)
+#ifdef LIGHTSCORE_BUILD_DLL
+#define LIGHTSCORE_API __declspec(dllexport)
+#else
+#define LIGHTSCORE_API __declspec(dllimport)
+#endif
+#else
+#define LIGHTSCORE_API
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#define LC_API_VERSION 1
+
+    enum lc_status
+    {
+        LC_OK = 0,
+        LC_ERR_INVALID_ARG = -1,
+        LC_ERR_NOT_FOUND = -2,
+        LC_ERR_NOT_OPEN = -3,
+        LC_ERR_IO = -4,
+        LC_ERR_INTERNAL = -5
+    };
+
+    typedef struct lc_device lc_device;
+
+    LIGHTSCORE_API int lc_api_version(void);
+
+    LIGHTSCORE_API lc_device *lc_create(void);
+    LIGHTSCORE_API void lc_destroy(lc_device *dev);
+
+    /* Serial port, e.g. "COM3" */
+    LIGHTSCORE_API int lc_open(lc_device *dev, const char *port);
+    LIGHTSCORE_API void lc_close(lc_device *dev);
+
+    /* Number of LEDs, i.e. bytes per frame. LED ids run from 1 to lc_led_count(). */
+    LIGHTSCORE_API int lc_led_count(const lc_device *dev);
+    LIGHTSCORE_API int lc_set_intensity(lc_device *dev, int id, int value);
+    LIGHTSCORE_API int lc_get_intensity(const lc_device *dev, int id);
+    LIGHTSCORE_API int lc_set_max_intensity(lc_device *dev, int id, int value);
+    /* Sets all LEDs from lc_led_count() bytes (locked LEDs keep their value) */
+    LIGHTSCORE_API int lc_set_frame(lc_device *dev, const unsigned char *intensities);
+    LIGHTSCORE_API int lc_randomize(lc_device *dev);
+
+    LIGHTSCORE_API int lc_load_max_intensities(lc_device *dev, const char *path);
+    LIGHTSCORE_API int lc_load_calibration(lc_device *dev, const char *path);
+
+    /* Sends the current intensities as one packet */
+    LIGHTSCORE_API int lc_send(lc_device *dev);
+    /* Sends count frames of lc_led_count() bytes each, packetized and calibrated,
+       in a single write. Returns the number of frames sent or a negative error. */
+    LIGHTSCORE_API long long lc_submit_frames(lc_device *dev, const unsigned char *frames, size_t count);
+
+    /* Full-resolution variant: levels are lc_led_count() values per frame at the
+       wire format's bit depth (0-1023 for "10", 0-4095 for "12"), sent without
+       calibration. Recordings keep the top 8 bits. */
+    LIGHTSCORE_API long long lc_submit_levels(lc_device *dev, const unsigned short *levels, size_t count);
+
+    /* Wire format: "8" (default), "10", "12", or "8c"/"10c"/"12c" with a frame
+       counter and CRC-16 trailer; see FrameProtocol.h. Resets the frame counter. */
+    LIGHTSCORE_API int lc_set_format(lc_device *dev, const char *format);
+
+    /* Records every packet sent through this device to a text recording */
+    LIGHTSCORE_API int lc_record_start(lc_device *dev, const char *path);
+    LIGHTSCORE_API void lc_record_stop(lc_device *dev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIGHTSCORE_H */
@@ -0,0 +1,144 @@
+/*
+ * Shared-memory frame ring between an external producer process and
+ * LightsDebugger (consumer). Plain C so acquisition software can include it
+ * directly; the producer helpers below are all it needs.
+ *
+ * LightsDebugger creates the ring with "ring -s [name]". The producer opens it
+ * with lights_ring_open() and pushes 30-byte intensity frames. Each slot holds
+ * the complete serial packet (0xDA 0xAD + intensities), which the consumer
+ * writes to the serial port straight from shared memory. When the ring is full
+ * the producer drops the frame and counts an overrun.
+ */
+#ifndef LIGHTSRING_H
+#define LIGHTSRING_H
+#include <windows.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LIGHTS_RING_MAGIC 0x474E524Cu /* "LRNG" */
+#define LIGHTS_RING_VERSION 1u
+#define LIGHTS_RING_FRAME_SIZE 30u
+#define LIGHTS_RING_PACKET_SIZE (LIGHTS_RING_FRAME_SIZE + 2u)
+#define LIGHTS_RING_DEFAULT_NAME "LightsDebuggerRing"
+#define LIGHTS_RING_DEFAULT_CAPACITY 1024u /* power of two */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Fields are grouped per writer on separate cache lines. */
+    typedef struct lights_ring_header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t frame_size;
+        uint32_t capacity;
+        unsigned char pad0[48];
+        /* producer-owned */
+        volatile LONG64 write_seq; /* frames published so far */
+        volatile LONG64 overruns;  /* frames dropped because the ring was full */
+        unsigned char pad1[48];
+        /* consumer-owned */
+        volatile LONG64 read_seq; /* frames consumed so far */
+        volatile LONG waiting;    /* 1 while the consumer sleeps on the wake event */
+        unsigned char pad2[52];
+    } lights_ring_header;
+
+    typedef struct lights_ring_slot
+    {
+        uint64_t seq; /* write_seq value this frame was published as */
+        unsigned char packet[LIGHTS_RING_PACKET_SIZE];
+        unsigned char pad[24];
+    } lights_ring_slot;
+
+    typedef struct lights_ring
+    {
+        HANDLE mapping;
+        HANDLE wake;
+        lights_ring_header *hdr;
+        lights_ring_slot *slots;
+    } lights_ring;
+
+    static inline size_t lights_ring_bytes(uint32_t capacity)
+    {
+        return sizeof(lights_ring_header) + (size_t)capacity * sizeof(lights_ring_slot);
+    }
+
+    /* Kernel object names derived from the ring name. */
+    static inline void lights_ring_object_names(const char *name, char *mapping, char *wake, size_t size)
+    {
+        snprintf(mapping, size, "Local\\%s", name);
+        snprintf(wake, size, "Local\\%s.wake", name);
+    }
+
+    static inline LONG64 lights_ring_load(volatile LONG64 *p)
+    {
+        return InterlockedCompareExchange64(p, 0, 0);
+    }
+
+    /* Producer: attach to a ring created by LightsDebugger. Returns 0 on success. */
+    static inline int lights_ring_open(lights_ring *r, const char *name)
+    {
+        char mapping[256], wake[256];
+        memset(r, 0, sizeof(*r));
+        lights_ring_object_names(name ? name : LIGHTS_RING_DEFAULT_NAME, mapping, wake, sizeof(mapping));
+        r->mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, mapping);
+        if (!r->mapping)
+            return -1;
+        r->hdr = (lights_ring_header *)MapViewOfFile(r->mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+        r->wake = OpenEventA(EVENT_MODIFY_STATE, FALSE, wake);
+        if (!r->hdr || !r->wake || r->hdr->magic != LIGHTS_RING_MAGIC || r->hdr->version != LIGHTS_RING_VERSION ||
+            r->hdr->frame_size != LIGHTS_RING_FRAME_SIZE)
+        {
+            if (r->hdr)
+                UnmapViewOfFile(r->hdr);
+            if (r->wake)
+                CloseHandle(r->wake);
+            CloseHandle(r->mapping);
+            memset(r, 0, sizeof(*r));
+            return -1;
+        }
+        r->slots = (lights_ring_slot *)(r->hdr + 1);
+        return 0;
+    }
+
+    /* Producer: publish one frame. Returns 1 if queued, 0 if dropped (overrun). */
+    static inline int lights_ring_push(lights_ring *r, const unsigned char intensities[LIGHTS_RING_FRAME_SIZE])
+    {
+        lights_ring_header *h = r->hdr;
+        LONG64 w = h->write_seq; /* only this process writes it */
+        if (w - lights_ring_load(&h->read_seq) >= (LONG64)h->capacity)
+        {
+            InterlockedIncrement64(&h->overruns);
+            return 0;
+        }
+        lights_ring_slot *slot = &r->slots[w & (h->capacity - 1)];
+        slot->seq = (uint64_t)w;
+        slot->packet[0] = 0xDA;
+        slot->packet[1] = 0xAD;
+        memcpy(slot->packet + 2, intensities, LIGHTS_RING_FRAME_SIZE);
+        InterlockedExchange64(&h->write_seq, w + 1); /* full barrier publishes the slot */
+        /* wake the consumer only if it is (about to be) asleep */
+        if (InterlockedCompareExchange(&h->waiting, 0, 1) == 1)
+            SetEvent(r->wake);
+        return 1;
+    }
+
+    static inline void lights_ring_close(lights_ring *r)
+    {
+        if (r->hdr)
+            UnmapViewOfFile(r->hdr);
+        if (r->wake)
+            CloseHandle(r->wake);
+        if (r->mapping)
+            CloseHandle(r->mapping);
+        memset(r, 0, sizeof(*r));
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIGHTSRING_H */
@@ -0,0 +1,11 @@
+#ifndef LOADTEST_H
+#define LOADTEST_H
+#include <string>
+#include <vector>
+
+// Tool mode: LightsDebugger loadtest [port] [clients] [seconds] [batch]
+// Drives a running control server from several local clients and reports
+// sustained commands/s and frames/s.
+int runLoadTest(const std::vector<std::string> &args);
+
+#endif // LOADTEST_H
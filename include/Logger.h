@@ -0,0 +1,135 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Leveled, categorized logging with the formatting done off the hot path.
+//
+// Callers copy the raw message (text or packet bytes) into a fixed-size slot of
+// a bounded lock-free MPSC ring. A background sink thread formats the slots and
+// writes them to the console (rate limited) and to an optional log file.
+// A disabled level costs one relaxed atomic load. When the ring is full, the
+// message is dropped and counted instead of blocking the sender.
+class Logger
+{
+public:
+    enum class Level : uint8_t
+    {
+        Trace,
+        Debug,
+        Info,
+        Warn,
+        Error,
+        Off
+    };
+    enum class Category : uint8_t
+    {
+        General,
+        Serial,
+        Record,
+        Replay,
+        Command,
+        Count
+    };
+
+    static constexpr size_t kCapacity = 4096;        // slots, power of two
+    static constexpr size_t kPayloadSize = 104;      // bytes of text or packet data per slot
+    static constexpr unsigned kDefaultConsoleRate = 20; // lines per second
+
+    static Logger &instance();
+
+    bool enabled(Category category, Level level) const
+    {
+        return static_cast<uint8_t>(level) >= levels_[static_cast<size_t>(category)].load(std::memory_order_relaxed);
+    }
+
+    void log(Category category, Level level, const std::string &message);
+    // Logs "<prefix> XX XX ..." (prefix is a string literal, stored by pointer)
+    void logBytes(Category category, Level level, const char *prefix, const unsigned char *data, size_t size);
+
+    void setLevel(Level level); // all categories
+    void setLevel(Category category, Level level);
+    Level getLevel(Category category) const;
+    bool openFile(const std::string &path);
+    void closeFile();
+    std::string getFilePath() const;
+    void setConsoleRate(unsigned linesPerSecond); // 0 = unlimited
+    unsigned getConsoleRate() const;
+    void flush(); // waits until everything queued so far is written
+
+    uint64_t getDropped() const;     // lost to a full ring
+    uint64_t getSuppressed() const;  // kept out of the console by the rate limit
+
+    static const char *levelName(Level level);
+    static const char *categoryName(Category category);
+    static bool parseLevel(const std::string &name, Level &level);
+    static bool parseCategory(const std::string &name, Category &category);
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+private:
+    Logger();
+    ~Logger();
+
+    struct Slot
+    {
+        std::atomic<uint64_t> seq;
+        uint64_t timeUs;
+        const char *prefix; // hex messages only
+        uint16_t size;
+        uint16_t fullSize; // hex messages: bytes before truncation
+        Level level;
+        Category category;
+        bool hex;
+        unsigned char payload[kPayloadSize];
+    };
+
+    Slot *claim();
+    void commit(Slot *slot);
+    void sinkLoop();
+    std::string format(const Slot &slot) const;
+    void write(const Slot &slot);
+
+    std::atomic<uint8_t> levels_[static_cast<size_t>(Category::Count)];
+    std::vector<Slot> slots_;
+    std::atomic<uint64_t> head_{0}; // next slot to claim
+    uint64_t tail_ = 0;             // next slot to drain, sink thread only
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> suppressed_{0};
+    std::atomic<unsigned> consoleRate_{kDefaultConsoleRate};
+
+    // console rate limit, sink thread only
+    uint64_t windowStartUs_ = 0;
+    unsigned windowLines_ = 0;
+    uint64_t reportedSuppressed_ = 0;
+
+    mutable std::mutex fileMutex_;
+    std::ofstream file_;
+    std::string filePath_;
+
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::atomic<bool> sinkWaiting_{false};
+    bool stopping_ = false;
+    std::thread sink_;
+};
+
+// 仅在级别启用时才复制参数
+#define LOG_TEXT(category, level, message)                                              \
+    do                                                                                  \
+    {                                                                                   \
+        if (Logger::instance().enabled(Logger::Category::category, Logger::Level::level)) \
+            Logger::instance().log(Logger::Category::category, Logger::Level::level, message); \
+    } while (0)
+
+#endif // LOGGER_H
@@ -0,0 +1,58 @@
+#ifndef LOWDISCREPANCY_H
+#define LOWDISCREPANCY_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Scrambled low-discrepancy point sets in [0,1)^dims for space-filling random
+// frames: consecutive points cover the intensity space evenly instead of
+// clustering like independent uniform draws.
+//
+// Sobol: direction numbers from primitive polynomials over GF(2), points in
+// Gray-code order, then a hash-based nested uniform (Owen) scramble per
+// dimension. Halton: radical inverse in the first 64 prime bases with a random
+// digit permutation per dimension. Both advance in O(dims) per point and can
+// be resumed at any index; the seed selects the scramble.
+class LowDiscrepancySequence
+{
+public:
+    enum class Kind : uint8_t
+    {
+        Sobol,
+        Halton
+    };
+    static constexpr size_t kMaxDims = 64;
+
+    LowDiscrepancySequence(Kind kind, uint32_t seed, uint64_t index = 0);
+
+    // Jumps to point `index` (Sobol repeats after 2^32 points)
+    void seek(uint64_t index);
+    // Writes point index() into out[0..dims) and advances; the first dimensions
+    // are the best distributed ones
+    void next(float *out, size_t dims);
+
+    Kind getKind() const;
+    uint32_t getSeed() const;
+    uint64_t index() const;
+
+    static const char *name(Kind kind);
+    static bool parse(const std::string &name, Kind &kind);
+
+private:
+    Kind kind_;
+    uint32_t seed_;
+    uint64_t index_ = 0;
+    uint32_t scramble_[kMaxDims]; // per-dimension scramble seeds
+
+    // Sobol: unscrambled coordinates of the current point
+    uint32_t sobol_[kMaxDims];
+
+    // Halton: digits of the index per dimension (least significant first) and
+    // the scrambled radical inverse they sum to
+    std::vector<std::vector<uint16_t>> permutations_;
+    std::vector<uint16_t> digits_;
+    double halton_[kMaxDims];
+};
+
+#endif // LOWDISCREPANCY_H
@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <cstdint>
+#include <string>
+
+// Whole-file memory mapping, read-only, newly created or existing read/write.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool openRead(const std::string &path);
+    // Creates (truncates) path with the given size and maps it read/write
+    bool create(const std::string &path, uint64_t size);
+    // Opens path read/write keeping its contents, creating it or growing it to
+    // at least size bytes (new bytes are zero)
+    bool openReadWrite(const std::string &path, uint64_t size);
+    bool flush();
+    void close();
+
+    bool isOpen() const;
+    unsigned char *data();
+    const unsigned char *data() const;
+    uint64_t size() const;
+
+private:
+    class MappedFileImpl;
+    MappedFileImpl *impl_;
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,32 @@
+#ifndef MEASUREMENTSOURCE_H
+#define MEASUREMENTSOURCE_H
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Reads instrument readings, one measurement per line of numbers separated by
+// spaces, tabs or commas. The path may be a regular file that another process
+// appends to, a named pipe, or a virtual COM port: at end of input next()
+// keeps polling until a full line arrives or the timeout expires. Only lines
+// written after open() are read.
+class MeasurementSource
+{
+public:
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+
+    // Skips blank lines and '#' comments; false on timeout or a malformed line
+    bool next(std::vector<float> &values, int timeoutMs);
+
+    // Parses a line of numbers; false if it holds anything else
+    static bool parseValues(const std::string &line, std::vector<float> &values);
+    // Reads all numbers of a file (e.g. a target spectrum) into values
+    static bool readFile(const std::string &path, std::vector<float> &values);
+
+private:
+    std::ifstream in_;
+    std::string partial_; // line fragment read before the writer finished it
+};
+
+#endif // MEASUREMENTSOURCE_H
@@ -0,0 +1,90 @@
+#ifndef PARALLELCHUNKS_H
+#define PARALLELCHUNKS_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Helpers for the tool modes that process whole recordings on all cores.
+namespace ParallelChunks
+{
+    // A piece of a text file that starts right after a '\n'
+    struct LineChunk
+    {
+        const char *begin = nullptr;
+        const char *end = nullptr;
+        uint64_t firstLine = 0; // global index of the chunk's first line
+        uint64_t lines = 0;
+        uint64_t errorLine = 0; // 1-based, 0 = no error
+        const char *error = nullptr;
+    };
+
+    inline unsigned threadCount()
+    {
+        unsigned n = std::thread::hardware_concurrency();
+        return n ? n : 4;
+    }
+
+    // Runs fn(0..count-1) on up to threadCount() threads, interleaved
+    template <typename Fn>
+    void parallelFor(size_t count, Fn fn)
+    {
+        const size_t workers = std::min<size_t>(count, threadCount());
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < workers; ++w)
+        {
+            threads.emplace_back([&, w]
+                                 {
+                for (size_t i = w; i < count; i += workers)
+                    fn(i); });
+        }
+        for (auto &t : threads)
+            t.join();
+    }
+
+    // Splits [begin, end) into about `pieces` chunks on line boundaries
+    inline std::vector<LineChunk> splitLines(const char *begin, const char *end, size_t pieces)
+    {
+        std::vector<LineChunk> chunks;
+        const size_t total = static_cast<size_t>(end - begin);
+        const char *p = begin;
+        for (size_t i = 1; i <= pieces && p < end; ++i)
+        {
+            const char *q = (i == pieces) ? end : begin + total * i / pieces;
+            if (q < p)
+                q = p;
+            if (q < end)
+            {
+                q = static_cast<const char *>(std::memchr(q, '\n', static_cast<size_t>(end - q)));
+                q = q ? q + 1 : end;
+            }
+            if (q > p)
+                chunks.push_back({p, q});
+            p = q;
+        }
+        return chunks;
+    }
+
+    // Counts lines per chunk in parallel and numbers them; returns the total
+    inline uint64_t numberLines(std::vector<LineChunk> &chunks, const char *end)
+    {
+        parallelFor(chunks.size(), [&](size_t i)
+                    {
+            LineChunk &c = chunks[i];
+            c.lines = static_cast<uint64_t>(std::count(c.begin, c.end, '\n'));
+            if (c.end == end && c.end > c.begin && c.end[-1] != '\n')
+                ++c.lines; // last line without trailing newline
+        });
+        uint64_t lines = 0;
+        for (auto &c : chunks)
+        {
+            c.firstLine = lines;
+            lines += c.lines;
+        }
+        return lines;
+    }
+}
+
+#endif // PARALLELCHUNKS_H
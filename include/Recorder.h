@@ -0,0 +1,28 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "RecordingFormat.h"
+
+// Appends sent packets to a text recording (see RecordingFormat.h).
+// Not synchronized: callers sharing a Recorder between threads lock around it.
+class Recorder
+{
+public:
+    bool open(const std::string &path);
+    void close();
+    bool isOpen() const;
+    std::string getPath() const;
+
+    // Writes one packet line, tagged with its sample index if given; a no-op while closed
+    void write(const unsigned char *packet, size_t size, uint64_t version,
+               const RecordingFormat::SampleTag *tag = nullptr);
+
+private:
+    std::ofstream file_;
+    std::string path_;
+    bool failed_ = false;
+};
+
+#endif // RECORDER_H
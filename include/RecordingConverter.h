@@ -0,0 +1,12 @@
+#ifndef RECORDINGCONVERTER_H
+#define RECORDINGCONVERTER_H
+#include <string>
+#include <vector>
+
+// Tool mode:
+//   LightsDebugger convert <in.txt> <out.bin>     text recording -> binary
+//   LightsDebugger convert -r <in.bin> <out.txt>  binary -> text recording
+// Input is memory-mapped and processed in parallel chunks on all cores.
+int runConvertTool(const std::vector<std::string> &args);
+
+#endif // RECORDINGCONVERTER_H
@@ -0,0 +1,57 @@
+#ifndef RECORDINGFORMAT_H
+#define RECORDINGFORMAT_H
+#include <cstddef>
+#include <cstdint>
+#include "LowDiscrepancy.h"
+
+// Text recording line: 32 two-digit hex bytes separated by spaces, optionally
+// followed by " #<frame version>" and, for frames drawn from a low-discrepancy
+// sequence, " @<sobol|halton>/<seed>/<index>" (see LowDiscrepancy.h). Text
+// after a ';' following the version is a comment.
+// Binary recording: RecordingBinaryHeader, then frameCount packets of 32
+// bytes, then frameCount uint64 versions.
+namespace RecordingFormat
+{
+    constexpr size_t kPacketSize = 32;
+    // Upper bound of a formatted text line including '\n'
+    constexpr size_t kMaxLineSize = kPacketSize * 3 + 72;
+
+    // Where a frame came from in its low-discrepancy sequence
+    struct SampleTag
+    {
+        LowDiscrepancySequence::Kind kind;
+        uint32_t seed;
+        uint64_t index;
+    };
+
+    constexpr char kBinaryMagic[4] = {'L', 'D', 'R', 'B'};
+    constexpr uint32_t kBinaryVersion = 1;
+
+    struct RecordingBinaryHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t packetSize;
+        uint32_t reserved;
+        uint64_t frameCount;
+    };
+    static_assert(sizeof(RecordingBinaryHeader) == 24, "RecordingBinaryHeader must be 24 bytes");
+
+    // True if a binary recording of fileSize bytes holds exactly frameCount
+    // frames. frameCount comes from the file, so it is bounded by the size
+    // before any multiplication.
+    bool binarySizeMatches(uint64_t frameCount, uint64_t fileSize);
+
+    // Parses one line (without '\n') into kPacketSize bytes. On failure returns
+    // false and points error at a static description. hasTag (if given) tells
+    // whether the line carried a sample tag, stored into *tag.
+    bool parseLine(const char *begin, const char *end, unsigned char *packet, uint64_t &version,
+                   const char *&error, SampleTag *tag = nullptr, bool *hasTag = nullptr);
+
+    // Formats one packet as a text line ending in '\n' into out (kMaxLineSize
+    // bytes), returns the line length.
+    size_t formatLine(const unsigned char *packet, size_t size, uint64_t version, char *out,
+                      const SampleTag *tag = nullptr);
+}
+
+#endif // RECORDINGFORMAT_H
@@ -0,0 +1,63 @@
+#ifndef RECORDINGINDEX_H
+#define RECORDINGINDEX_H
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Columnar copy of a recording for queries, stored next to it as <recording>.idx.
+//
+// The 30 LED bytes of every packet (header dropped) are transposed into one
+// column per LED, so a filter on l14 reads a single contiguous byte array.
+// Every block of kBlockFrames frames has a min/max summary (zone map) per
+// column, so blocks that cannot match a predicate are skipped without reading
+// their data. Values are the bytes that were sent, i.e. after calibration.
+//
+// File: RecordingIndexHeader, then channels columns of frameCount bytes, then
+// blocks x channels (min, max) byte pairs.
+class RecordingIndex
+{
+public:
+    static constexpr uint32_t kBlockFrames = 4096;
+    static constexpr char kMagic[4] = {'L', 'D', 'I', 'X'};
+    static constexpr uint32_t kVersion = 1;
+
+    struct RecordingIndexHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t channels;
+        uint32_t blockFrames;
+        uint64_t frameCount;
+        uint64_t sourceSize;  // size of the recording the index was built from
+        int64_t sourceTime;   // and its modification time, to detect stale indexes
+    };
+    static_assert(sizeof(RecordingIndexHeader) == 40, "RecordingIndexHeader must be 40 bytes");
+
+    // Maps <recording>.idx, (re)building it first if it is missing, stale or
+    // rebuild is set. Text and binary recordings are both accepted.
+    bool open(const std::string &recordingPath, bool rebuild, std::string &error);
+    void close();
+    bool wasBuilt() const; // open() had to build the index
+
+    uint64_t getFrameCount() const;
+    size_t getChannelCount() const;
+    uint64_t getBlockCount() const;
+    const unsigned char *column(size_t channel) const;
+    unsigned char zoneMin(uint64_t block, size_t channel) const;
+    unsigned char zoneMax(uint64_t block, size_t channel) const;
+
+    static std::string indexPathFor(const std::string &recordingPath);
+
+private:
+    bool build(const std::string &recordingPath, const std::string &indexPath, uint64_t sourceSize,
+               int64_t sourceTime, std::string &error);
+
+    MappedFile file_;
+    RecordingIndexHeader header_{};
+    const unsigned char *columns_ = nullptr;
+    const unsigned char *zones_ = nullptr;
+    bool built_ = false;
+};
+
+#endif // RECORDINGINDEX_H
@@ -0,0 +1,67 @@
+#ifndef RECORDINGQUERY_H
+#define RECORDINGQUERY_H
+#include "RecordingIndex.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Filter expressions over recorded LED values, evaluated on a RecordingIndex.
+//
+//   expr  := term { (or | ||) term }
+//   term  := factor { (and | &&) factor }
+//   factor:= (not | !) factor | ( expr ) | l<id> op <0-255>
+//   op    := > >= < <= == = !=
+//
+// e.g. "l14 > 200 and l3 == 0". Every comparison becomes an inclusive range
+// test, so one kernel (SIMD where available) serves all of them, and each
+// block's zone map decides whether the block matches none, all or some frames
+// before any data is read.
+class RecordingQuery
+{
+public:
+    struct Result
+    {
+        uint64_t matches = 0;
+        uint64_t blocksScanned = 0; // blocks whose data had to be read
+        uint64_t blocksSkipped = 0; // decided by the zone maps alone
+        std::vector<std::pair<uint64_t, uint64_t>> ranges; // matching frames, inclusive, 0-based
+        std::vector<uint64_t> histogram;                    // 256 bins when a histogram channel is set
+        std::vector<unsigned char> minimum;                 // per channel over matching frames
+        std::vector<unsigned char> maximum;
+        std::vector<double> mean;
+    };
+
+    // An empty expression matches every frame
+    bool compile(const std::string &expression, size_t channels, std::string &error);
+    // channel for the value histogram of matching frames, -1 for none
+    void setHistogramChannel(int channel);
+    // min/max/mean of every channel over the matching frames
+    void setStatistics(bool enabled);
+    Result run(const RecordingIndex &index) const;
+
+private:
+    enum class Op : uint8_t
+    {
+        Range, // push: lo <= column[channel] <= hi
+        And,
+        Or,
+        Not
+    };
+    struct Instr
+    {
+        Op op;
+        uint8_t channel;
+        unsigned char lo;
+        unsigned char hi;
+    };
+    static constexpr size_t kMaxDepth = 32; // evaluation stack entries
+
+    std::vector<Instr> program_; // postfix
+    int histogramChannel_ = -1;
+    bool statistics_ = false;
+};
+
+// Tool mode: LightsDebugger query <recording> [expression] [options]
+int runQueryTool(const std::vector<std::string> &args);
+
+#endif // RECORDINGQUERY_H
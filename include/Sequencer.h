@@ -0,0 +1,79 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+#include "TriggerSource.h"
+#include "Clock.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Plays a prepared list of packets on a background thread, one frame per
+// camera exposure:
+//   triggered  each trigger (see TriggerSource.h) sends the next frame at once;
+//              latency = trigger wake-up to the write returning
+//   timed      frame i is sent at start + i * hold (integration + settling);
+//              latency = how late the write returned against its deadline
+// Packets are built up front so the hot path is wait -> write only.
+class Sequencer
+{
+public:
+    // Sends one packet, returns false on failure
+    using SendHandler = std::function<bool(const unsigned char *, size_t, uint64_t)>;
+
+    struct Stats
+    {
+        uint64_t frames = 0;  // frames sent
+        uint64_t errors = 0;  // failed writes
+        uint64_t overruns = 0; // triggered: trigger already queued when ready; timed: write after the hold ended
+        double minUs = 0, meanUs = 0, p99Us = 0, maxUs = 0;
+    };
+
+    Sequencer();
+    ~Sequencer();
+
+    // Timed mode schedules on this clock (default Clock::system()); set while stopped
+    void setClock(Clock &clock);
+
+    // packets holds count * packetSize bytes, versions is empty or one per packet.
+    // An empty trigger spec selects timed mode with holdUs per frame.
+    bool start(std::vector<unsigned char> packets, size_t packetSize, std::vector<uint64_t> versions,
+               const std::string &trigger, uint32_t holdUs, SendHandler onSend);
+    void stop();
+    bool isRunning() const;
+    bool isTriggered() const; // mode of the current or last run
+    std::string getTrigger() const;
+    uint32_t getHoldTime() const;
+
+    size_t getFrameCount() const;
+    uint64_t getPosition() const;
+    Stats getStats() const;
+
+private:
+    void run();
+    void runTriggered();
+    void runTimed();
+    void record(double latencyUs, bool ok, bool overrun);
+    double microsecondsSince(Clock::TimePoint from) const;
+
+    TriggerSource trigger_;
+    Clock *clock_ = &Clock::system();
+    std::vector<unsigned char> packets_;
+    std::vector<uint64_t> versions_;
+    size_t packetSize_ = 0;
+    uint32_t holdUs_ = 0;
+    bool triggered_ = false; // kept after stop() for the final stats
+    SendHandler onSend_;
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> position_{0};
+
+    mutable std::mutex statsMutex_;
+    Stats stats_;
+    std::vector<float> latencies_; // us, for the percentile
+};
+
+#endif // SEQUENCER_H
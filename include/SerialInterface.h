@@ -9,9 +9,12 @@ public:
     SerialInterface();
     ~SerialInterface();
 
+    // COM<n> opens the serial port at 115200 8N1. Any other name is opened as a
+    // file or named pipe and written raw (appending), e.g. as simspec's input.
     bool open(const std::string &port);
     void close();
     bool sendData(const std::vector<unsigned char> &data);
+    bool sendData(const unsigned char *data, size_t size);
     bool isOpen() const;
 
 private:
@@ -0,0 +1,43 @@
+#ifndef SPECTRALMODEL_H
+#define SPECTRALMODEL_H
+#include <cstddef>
+#include <vector>
+
+class LEDController;
+
+// Forward model of the combined emission spectrum of a frame. Each LED is a
+// Gaussian around its peak wavelength scaled by its radiation at 255 (LEDs
+// without radiation data contribute nothing). Profiles are tabulated once on
+// the wavelength grid, so evaluating a frame is a matrix-vector product.
+class SpectralModel
+{
+public:
+    SpectralModel(const LEDController &controller, float startNm, float stepNm, size_t points);
+
+    float getStart() const;
+    float getStep() const;
+    size_t getPointCount() const;
+    size_t getChannelCount() const;
+    float getWavelength(size_t point) const;
+    // Contribution of one intensity step of channel at point
+    float getWeight(size_t point, size_t channel) const;
+
+    // out receives getPointCount() values for a frame of getChannelCount() bytes
+    void evaluate(const unsigned char *frame, float *out) const;
+
+    // Full width at half maximum assumed for an LED at the given peak
+    static float fwhmFor(float peakNm);
+
+private:
+    float start_;
+    float step_;
+    size_t points_;
+    size_t stride_; // points_ rounded up to the SIMD width
+    size_t channels_;
+    // One column of stride_ weights (profile * maxRadiation / 255) per channel
+    // that has a profile, so a frame is summed as a few long axpy passes.
+    std::vector<float> columns_;
+    std::vector<size_t> columnChannel_;
+};
+
+#endif // SPECTRALMODEL_H
@@ -0,0 +1,17 @@
+#ifndef SPECTROMETERSIM_H
+#define SPECTROMETERSIM_H
+#include <string>
+#include <vector>
+
+// Tool mode: LightsDebugger simspec <serial-in> <measure-out> [gain] [noise%]
+// Local stand-in for the spectrometer used by 'tune': follows the packets
+// written to serial-in (a file, pipe or the far end of a virtual COM pair;
+// 'setcom <file>' writes packets to a file or pipe instead of a COM port),
+// and appends the modelled spectrum of each frame to measure-out as one line.
+// Packets may use any 'proto' wire format (told apart by the second header
+// byte); deeper levels are cut to their top 8 bits, frames failing CRC are skipped.
+// Per-LED efficiencies of 85-115% and a red shift of one grid step (5 nm) make
+// it differ from the model the optimizer starts with.
+int runSpectrometerSim(const std::vector<std::string> &args);
+
+#endif // SPECTROMETERSIM_H
@@ -0,0 +1,102 @@
+#ifndef STATEJOURNAL_H
+#define STATEJOURNAL_H
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class LEDController;
+
+// Crash-safe record of the controller state (intensities, limits, locks,
+// power budget, integration/settle time) in one memory-mapped file:
+//
+//   JournalHeader | snapshot slot A | snapshot slot B | record log ...
+//
+// capture() diffs the state against the last capture and appends one
+// 16-byte record per changed field to the log; that is a few stores into the
+// mapping and no system call, and the pages reach the file even if the
+// process dies. When the log is half full the current state is written as a
+// snapshot into the older slot and the log starts over, so recovery reads
+// one snapshot plus at most half a log regardless of session length.
+// Records carry a sequence number and a CRC; replay stops at the first stale
+// or torn one, and a torn snapshot falls back to the other slot.
+// Survives process crashes, not power loss (the view is flushed only on close).
+class StateJournal
+{
+public:
+    static constexpr uint64_t kFileSize = 1 << 20;
+    static constexpr size_t kMaxLeds = 64;
+
+    StateJournal() = default;
+    ~StateJournal();
+
+    // Maps path, creating or reinitializing it if it is not a valid journal,
+    // and locates the newest snapshot and the end of its log
+    bool open(const std::string &path, size_t ledCount);
+    void close();
+    bool isOpen() const;
+    std::string getPath() const;
+
+    // Applies the newest snapshot and the records after it to controller.
+    // Returns false when the journal holds no state yet.
+    bool recover(LEDController &controller, uint64_t &replayed);
+    // Recovered state without applying it; false when there is none
+    bool hasState() const;
+    // Starts a new log epoch from controller's current state
+    void snapshot(const LEDController &controller);
+    // Appends records for fields changed since the last capture, returns how many
+    size_t capture(const LEDController &controller);
+
+    uint64_t getSequence() const;        // last record or snapshot written
+    uint64_t getRecordsInLog() const;    // since the newest snapshot
+    uint64_t getSnapshotCount() const;   // this session
+
+#pragma pack(push, 1)
+    struct LedState
+    {
+        uint8_t intensity;
+        uint8_t maxIntensity;
+        uint8_t minIntensity;
+        uint8_t locked;
+    };
+    struct State
+    {
+        uint32_t ledCount;
+        float powerBudget;
+        uint32_t integrationUs;
+        uint32_t settleUs;
+        LedState leds[kMaxLeds];
+    };
+#pragma pack(pop)
+
+private:
+    enum Field : uint8_t
+    {
+        Intensity = 1,
+        MaxIntensity,
+        MinIntensity,
+        Locked,
+        PowerBudget,
+        IntegrationUs,
+        SettleUs
+    };
+
+    static State read(const LEDController &controller);
+    static void apply(const State &state, LEDController &controller);
+    void append(Field field, uint8_t channel, uint32_t value);
+    static bool applyRecord(State &state, uint8_t field, uint8_t channel, uint32_t value);
+
+    MappedFile file_;
+    std::string path_;
+    State last_ = {};      // state as of the last record written
+    State recovered_ = {}; // newest snapshot + log, found by open()
+    bool hasRecovered_ = false;
+    bool baseline_ = false; // last_ matches what the file describes
+    uint64_t sequence_ = 0;
+    uint64_t logStart_ = 0; // sequence of the newest snapshot
+    uint64_t logRecords_ = 0;
+    uint64_t snapshots_ = 0;
+    int newestSlot_ = 0;
+};
+
+#endif // STATEJOURNAL_H
@@ -0,0 +1,70 @@
+#ifndef TEMPORALDITHER_H
+#define TEMPORALDITHER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Calibration;
+
+// First-order sigma-delta dithering of fractional intensity targets across
+// consecutive frames: a channel set to 12.37 is sent as 12 and 13 in the
+// ratio that averages to 12.37, with the quantization error carried into the
+// next frame. The effective resolution therefore depends on a steady frame
+// rate; getStats() reports the achieved mean and ripple per channel.
+//
+// Targets are set from the command thread and swapped in atomically; next()
+// and the error state belong to the streaming thread.
+class TemporalDither
+{
+public:
+    struct ChannelStats
+    {
+        float target = -1;   // < 0: not dithered
+        uint64_t frames = 0;
+        double mean = 0;     // average level sent
+        double ripple = 0;   // RMS of (level - target), in levels
+        unsigned char lo = 0, hi = 0;
+    };
+
+    explicit TemporalDither(size_t channels);
+
+    // level in [0, 255]; a negative level stops dithering the channel.
+    // Only this channel's error and statistics start over.
+    void setTarget(size_t channel, float level);
+    void clear();
+    bool isActive() const;
+    std::vector<float> getTargets() const;
+
+    // Streaming thread: overwrites the dithered channels of a calibrated frame
+    // with the next sigma-delta level passed through calibration
+    void next(unsigned char *frame, size_t size, const Calibration &calibration);
+
+    std::vector<ChannelStats> getStats() const;
+    void resetStats();
+
+private:
+    using Targets = std::vector<float>;
+
+    void resetChannelStats(size_t channel); // statsMutex_ held
+
+    size_t channels_;
+    std::atomic<std::shared_ptr<const Targets>> targets_;
+
+    // streaming thread only
+    std::shared_ptr<const Targets> applied_;
+    std::vector<float> error_;
+    std::vector<float> target_; // 0 where inactive
+    std::vector<float> active_; // 1 or 0, keeps the loop branch-free
+    std::vector<unsigned char> level_;
+
+    mutable std::mutex statsMutex_;
+    std::vector<uint64_t> frames_;
+    std::vector<double> sum_, sumSquares_; // of level, of (level - target)
+    std::vector<unsigned char> lo_, hi_;
+    std::atomic<bool> resetStats_{false};
+};
+
+#endif // TEMPORALDITHER_H
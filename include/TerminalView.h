@@ -0,0 +1,45 @@
+#ifndef TERMINALVIEW_H
+#define TERMINALVIEW_H
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Fixed-size text grid drawn at the top of the console with ANSI cursor
+// addressing. Callers redraw the whole grid with put(); present() emits only
+// the cells that changed since the previous present(), so an unchanged
+// dashboard costs no terminal output at all.
+class TerminalView
+{
+public:
+    TerminalView(size_t rows, size_t cols);
+
+    size_t rows() const;
+    size_t cols() const;
+
+    // Writes text at row/col of the next frame, clipped to the grid
+    void put(size_t row, size_t col, const std::string &text);
+    void fill(size_t row, size_t col, size_t count, char c);
+    void clear();
+
+    // Appends the escape sequences that bring the screen up to date to out
+    // (empty if nothing changed). The cursor is saved and restored around
+    // the update so output below the view is not disturbed.
+    void present(std::string &out);
+    // Next present() redraws every cell (after the screen was cleared)
+    void invalidate();
+
+    // Enables escape sequence processing on the console; false if the
+    // console does not support it
+    static bool enableAnsi();
+    // Writes data to the console in one call
+    static void write(const std::string &data);
+
+private:
+    size_t rows_;
+    size_t cols_;
+    std::vector<char> next_;  // frame being drawn
+    std::vector<char> shown_; // what the terminal currently shows
+    bool full_ = true;
+};
+
+#endif // TERMINALVIEW_H
@@ -0,0 +1,112 @@
+#ifndef TRACER_H
+#define TRACER_H
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Opt-in timeline tracing, exported as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev).
+//
+// Each thread appends complete spans (name, begin, duration) to its own
+// fixed-size buffer; only that thread writes it, so recording a span takes no
+// lock. While tracing is off a span costs one relaxed atomic load. Full
+// buffers drop further spans and count them. Span names are stored by pointer
+// and must outlive the export (string literals, command table keys).
+// A thread's buffer is allocated on its first span while tracing is on, so
+// threads that never record cost nothing; stop() frees the buffers of threads
+// that have exited once they are exported.
+class Tracer
+{
+public:
+    static constexpr size_t kEventsPerThread = 1 << 16;
+
+    static Tracer &instance();
+
+    bool isEnabled() const
+    {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    void start();
+    // Stops recording and writes everything recorded since start() to path.
+    // Returns false if the file cannot be written.
+    bool stop(const std::string &path);
+
+    // Label for the calling thread in the exported timeline (string literal)
+    void setThreadName(const char *name);
+
+    void record(const char *name, std::chrono::steady_clock::time_point begin,
+                std::chrono::steady_clock::time_point end);
+
+    uint64_t getEventCount() const; // recorded in the current/last session
+    uint64_t getDropped() const;
+
+    Tracer(const Tracer &) = delete;
+    Tracer &operator=(const Tracer &) = delete;
+
+private:
+    Tracer() = default;
+
+    struct Event
+    {
+        const char *name;
+        int64_t beginNs; // since the session start
+        int64_t durationNs;
+    };
+
+    struct ThreadBuffer
+    {
+        uint32_t tid = 0;
+        std::atomic<const char *> name{nullptr};
+        std::atomic<uint64_t> session{0}; // session the events belong to, written by the owner thread
+        std::atomic<size_t> count{0};
+        std::unique_ptr<Event[]> events;
+    };
+
+    // The calling thread's buffer, created and registered on first use when
+    // create is set; nullptr otherwise
+    ThreadBuffer *localBuffer(bool create);
+
+    std::atomic<bool> enabled_{false};
+    std::atomic<uint64_t> session_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<int64_t> originNs_{0}; // session start, steady_clock ns
+
+    mutable std::mutex buffersMutex_; // registration and export only
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+    uint32_t nextTid_ = 0;
+    uint64_t exported_ = 0;
+};
+
+// Records the enclosing scope as one span while tracing is on
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name) : name_(Tracer::instance().isEnabled() ? name : nullptr)
+    {
+        if (name_)
+            begin_ = std::chrono::steady_clock::now();
+    }
+    ~TraceSpan()
+    {
+        if (name_)
+            Tracer::instance().record(name_, begin_, std::chrono::steady_clock::now());
+    }
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name_;
+    std::chrono::steady_clock::time_point begin_;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+
+#endif // TRACER_H
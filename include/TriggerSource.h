@@ -0,0 +1,37 @@
+#ifndef TRIGGERSOURCE_H
+#define TRIGGERSOURCE_H
+#include <cstdint>
+#include <string>
+
+// External frame trigger, a stand-in for the camera strobe:
+//   event:<name>  named auto-reset event; each SetEvent() is one trigger
+//   COM<x>        serial port; each received '\n' is one trigger
+//   anything else a named pipe (\\.\pipe\...) or a file another process
+//                 appends to; each '\n' is one trigger
+// Waits block in the kernel (event or overlapped read), so a trigger wakes the
+// caller without polling; only plain files are polled at 1 ms.
+class TriggerSource
+{
+public:
+    TriggerSource();
+    ~TriggerSource();
+
+    bool open(const std::string &spec);
+    void close();
+    bool isOpen() const;
+    std::string getSpec() const;
+
+    // True when a trigger arrived within timeoutMs. Triggers that arrived
+    // while nobody was waiting are kept (one per line) and returned at once.
+    bool wait(uint32_t timeoutMs);
+    // Triggers received but not yet returned. An auto-reset event does not
+    // count, so for event: this is 0 or 1 (signals in between coalesce).
+    uint64_t getPending() const;
+
+private:
+    class TriggerSourceImpl;
+    TriggerSourceImpl *impl_;
+    std::string spec_;
+};
+
+#endif // TRIGGERSOURCE_H
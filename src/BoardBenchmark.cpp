@@ -0,0 +1,127 @@
+#include "BoardBenchmark.h"
+#include "BasicLEDController.h"
+#include "FramePacket.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace
+{
+    volatile unsigned g_sink;
+
+    template <typename Step>
+    void timeRow(const char *name, size_t frames, Step &&step)
+    {
+        unsigned checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames; ++i)
+            checksum += step(); // 写入 sink，防止被优化掉
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("  %-52s %10.1f\n", name, s * 1e9 / frames);
+        g_sink = checksum;
+    }
+}
+
+int runBoardBenchmark(const std::vector<std::string> &args)
+{
+    size_t frames = 1000000;
+    float budget = 0;
+    try
+    {
+        if (args.size() > 1)
+            frames = std::stoul(args[1]);
+        if (args.size() > 2)
+            budget = std::stof(args[2]);
+    }
+    catch (...)
+    {
+        frames = 0;
+    }
+    if (args.size() > 3 || frames == 0)
+    {
+        std::cout << "[Usage] boardbench [frames] [budget]\n";
+        return 1;
+    }
+
+    // 与控制台相同的初始状态：读取 led_config.cfg / led_calib.cfg（存在时）
+    LEDController dynamic;
+    dynamic.loadMaxIntensities("led_config.cfg");
+    dynamic.loadCalibration("led_calib.cfg");
+    dynamic.setPowerBudget(budget);
+    Lights30Controller fixed;
+    fixed.copyFrom(dynamic);
+
+    // 同一种子下两种实现的数据包必须逐字节一致
+    constexpr size_t kCheckFrames = 10000;
+    {
+        std::mt19937 a(1), b(1);
+        std::vector<unsigned char> frame(dynamic.getLedCount()), calibrated(frame.size()), packet;
+        Lights30Controller::Packet fixedPacket;
+        const auto calibration = dynamic.getCalibration();
+        for (size_t i = 0; i < kCheckFrames; ++i)
+        {
+            dynamic.generateRandomFrame(a, frame.data());
+            calibration->apply(frame.data(), calibrated.data(), frame.size());
+            FramePacket::build(calibrated.data(), calibrated.size(), packet);
+            fixed.randomize(b);
+            fixed.pack(fixedPacket);
+            if (packet.size() != fixedPacket.size() || !std::equal(packet.begin(), packet.end(), fixedPacket.begin()))
+            {
+                std::cout << "[Error] Packets differ at frame " << i << ".\n";
+                return 1;
+            }
+        }
+    }
+
+    std::cout << "[Info] " << frames << " frames of " << Lights30Controller::kChannels << " LEDs, power budget "
+              << budget << " (" << kCheckFrames << " packets identical).\n";
+    std::printf("  %-52s %10s\n", "path", "ns/frame");
+    {
+        std::vector<unsigned char> packet;
+        timeRow("LEDController randomizeAll + calibrate + build", frames, [&]
+                {
+                    dynamic.randomizeAll();
+                    FramePacket::build(dynamic.getCalibratedData().data(), dynamic.getLedCount(), packet);
+                    return static_cast<unsigned>(packet.back());
+                });
+    }
+    {
+        std::mt19937 rng(1);
+        std::vector<unsigned char> frame(dynamic.getLedCount()), calibrated(frame.size()), packet;
+        const auto calibration = dynamic.getCalibration();
+        timeRow("LEDController generateRandomFrame (reused bufs)", frames, [&]
+                {
+                    dynamic.generateRandomFrame(rng, frame.data());
+                    calibration->apply(frame.data(), calibrated.data(), frame.size());
+                    FramePacket::build(calibrated.data(), calibrated.size(), packet);
+                    return static_cast<unsigned>(packet.back());
+                });
+    }
+    {
+        std::mt19937 rng(1);
+        Lights30Controller::Packet packet;
+        timeRow("BasicLEDController<Lights30Board> randomize + pack", frames, [&]
+                {
+                    fixed.randomize(rng);
+                    fixed.pack(packet);
+                    return static_cast<unsigned>(packet.back());
+                });
+    }
+    {
+        std::vector<unsigned char> packet;
+        timeRow("LEDController pack only", frames, [&]
+                {
+                    FramePacket::build(dynamic.getCalibratedData().data(), dynamic.getLedCount(), packet);
+                    return static_cast<unsigned>(packet.back());
+                });
+    }
+    {
+        Lights30Controller::Packet packet;
+        timeRow("BasicLEDController<Lights30Board> pack only", frames, [&]
+                {
+                    fixed.pack(packet);
+                    return static_cast<unsigned>(packet.back());
+                });
+    }
+    return 0;
+}
@@ -1,4 +1,12 @@
 #include "CLIApp.h"
+#include "RecordingFormat.h"
+#include "FramePacket.h"
+#include "FrameProtocol.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include "MeasurementSource.h"
+#include "IntensityOptimizer.h"
+#include "ChannelSelector.h"
 #include <vector>
 #include <string>
 #include <map>
@@ -9,59 +17,162 @@
 #include <chrono>
 #include <fstream>
 #include <iomanip>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <bit>
 
-CLIApp::CLIApp()
+namespace
+{
+    // "l<x>" 或纯数字峰位走原来的单灯路径，其余按选择器解析
+    bool isSingleLed(const std::string &arg)
+    {
+        if (arg.size() > 1 && arg[0] == 'l')
+            return arg.find_first_not_of("0123456789", 1) == std::string::npos;
+        char *end = nullptr;
+        std::strtof(arg.c_str(), &end);
+        return !arg.empty() && *end == '\0';
+    }
+
+    // 命令内临时修改 std::cout 的格式，离开作用域时恢复（包括提前返回）
+    class CoutFormatGuard
+    {
+    public:
+        CoutFormatGuard() : flags_(std::cout.flags()), precision_(std::cout.precision()) {}
+        ~CoutFormatGuard()
+        {
+            std::cout.flags(flags_);
+            std::cout.precision(precision_);
+        }
+        CoutFormatGuard(const CoutFormatGuard &) = delete;
+        CoutFormatGuard &operator=(const CoutFormatGuard &) = delete;
+
+    private:
+        std::ios::fmtflags flags_;
+        std::streamsize precision_;
+    };
+
+    // 当前线程正在执行（或启动了本线程）的命令，黑匣子按它标注每帧来源
+    thread_local uint64_t t_command = 0;
+
+    // watch 面板占据屏幕顶部，命令在其下方的滚动区域中照常输入和输出
+    constexpr size_t kDashboardRows = 19;
+    constexpr size_t kDashboardCols = 80;
+    constexpr size_t kDashboardLedRows = 15; // 两列
+    constexpr size_t kBarWidth = 16;
+}
+
+CLIApp::CLIApp(bool restoreState, Clock &clock) : clock_(clock)
 {
     setupCommands();
+    blackbox_.setClock(clock_);
+    blackbox_.installCrashDump(blackboxCrashFile_);
+    sequencer_.setClock(clock_);
+    startWatcher();
+    // 从状态日志恢复上次会话（异常退出也不丢失），然后从恢复后的状态开始新一轮日志
+    const auto t0 = std::chrono::steady_clock::now();
+    if (!journal_.open(journalFile_, controller_.getLedCount()))
+    {
+        std::cout << "[Warning] Cannot open state journal '" << journalFile_ << "'; state will not survive a crash.\n";
+        return;
+    }
+    uint64_t replayed = 0;
+    const bool restored = restoreState && journal_.recover(controller_, replayed);
+    journal_.snapshot(controller_);
+    controller_.publish();
+    recoveryMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (restored)
+        std::cout << "[Info] Restored previous session from '" << journalFile_ << "' (snapshot + " << replayed
+                  << " changes, " << std::fixed << std::setprecision(2) << recoveryMs_ << " ms).\n"
+                  << std::defaultfloat << std::setprecision(6);
+}
+
+CLIApp::~CLIApp()
+{
+    // 正常退出时压缩日志，下次启动只需读取快照
+    journal_.snapshot(controller_);
+    journal_.close();
+    stopWatch();
+    watcher_.stop();
+    coroutines_.stop();
+    sequencer_.stop();
+    stopRing();
+    server_.stop();
+    stopStream();
 }
 
 void CLIApp::run()
 {
+    Tracer::instance().setThreadName("console");
     std::string line;
     while (true)
     {
         std::cout << "> ";
         if (!std::getline(std::cin, line))
             break;
-        std::vector<std::string> args;
-        std::istringstream iss(line);
-        std::string arg;
-        while (iss >> arg)
-            args.push_back(arg);
+        std::lock_guard<std::timed_mutex> lock(commandMutex_);
+        executeLine(line);
+    }
+}
 
-        // 在回放模式下，仅支持空输入(回放下一帧)和 replay -e
-        if (isReplaying_)
-        {
-            if (args.empty())
-            {
-                handleEmpty(args);
-                continue;
-            }
-            if (!args.empty() && args[0] == "replay")
-            {
-                handleReplay(args);
-                continue;
-            }
-            std::cout << "[Warn] In replay mode: only (empty) or 'replay -e' supported.\n";
-            continue;
-        }
+bool CLIApp::executeLine(const std::string &line)
+{
+    t_command = blackbox_.noteCommand(line.empty() ? std::string("(enter)") : line);
+    applyPendingReload();
+    bool ok = dispatchLine(line);
+    // 命令锁定了正在抖动的灯时停止抖动，锁定的灯不再变化
+    if (dither_.isActive())
+        releaseLockedDither();
+    // 每条命令后把状态变化追加到映射的日志（无变化时只是一次比较）
+    journal_.capture(controller_);
+    return ok;
+}
+
+bool CLIApp::dispatchLine(const std::string &line)
+{
+    std::vector<std::string> args;
+    std::istringstream iss(line);
+    std::string arg;
+    while (iss >> arg)
+        args.push_back(arg);
+    LOG_TEXT(Command, Debug, "Execute '" + line + "'");
 
+    // 在回放模式下，仅支持空输入(回放下一帧)和 replay -e
+    if (isReplaying_)
+    {
         if (args.empty())
         {
             handleEmpty(args);
-            continue;
-        }
-
-        auto it = commands.find(args[0]);
-        if (it != commands.end())
-        {
-            it->second(args);
+            return true;
         }
-        else
+        if (!args.empty() && args[0] == "replay")
         {
-            handleError(args);
+            handleReplay(args);
+            return true;
         }
+        std::cout << "[Warn] In replay mode: only (empty) or 'replay -e' supported.\n";
+        return false;
+    }
+
+    if (args.empty())
+    {
+        TRACE_SPAN("(empty)");
+        handleEmpty(args);
+        return true;
+    }
+
+    auto it = commands.find(args[0]);
+    if (it == commands.end())
+    {
+        handleError(args);
+        return false;
     }
+    TRACE_SPAN(it->first.c_str()); // 命令表的键在程序运行期间一直有效
+    it->second(args);
+    // 命令执行完毕后整体发布，流线程不会看到半修改的帧
+    controller_.publish();
+    return true;
 }
 
 void CLIApp::setupCommands()
@@ -100,6 +211,54 @@ void CLIApp::setupCommands()
     { handleRecord(args); };
     commands["replay"] = [this](const std::vector<std::string> &args)
     { handleReplay(args); };
+    commands["stream"] = [this](const std::vector<std::string> &args)
+    { handleStream(args); };
+    commands["serve"] = [this](const std::vector<std::string> &args)
+    { handleServe(args); };
+    commands["ring"] = [this](const std::vector<std::string> &args)
+    { handleRing(args); };
+    commands["calib"] = [this](const std::vector<std::string> &args)
+    { handleCalib(args); };
+    commands["setmin"] = [this](const std::vector<std::string> &args)
+    { handleSetMin(args); };
+    commands["budget"] = [this](const std::vector<std::string> &args)
+    { handleBudget(args); };
+    commands["spectrum"] = [this](const std::vector<std::string> &args)
+    { handleSpectrum(args); };
+    commands["log"] = [this](const std::vector<std::string> &args)
+    { handleLog(args); };
+    commands["proto"] = [this](const std::vector<std::string> &args)
+    { handleProto(args); };
+    commands["tune"] = [this](const std::vector<std::string> &args)
+    { handleTune(args); };
+    commands["seq"] = [this](const std::vector<std::string> &args)
+    { handleSeq(args); };
+    commands["integ"] = [this](const std::vector<std::string> &args)
+    { handleInteg(args); };
+    commands["trace"] = [this](const std::vector<std::string> &args)
+    { handleTrace(args); };
+    commands["co"] = [this](const std::vector<std::string> &args)
+    { handleCo(args); };
+    commands["sel"] = [this](const std::vector<std::string> &args)
+    { handleSel(args); };
+    commands["op"] = [this](const std::vector<std::string> &args)
+    { handleOp(args); };
+    commands["journal"] = [this](const std::vector<std::string> &args)
+    { handleJournal(args); };
+    commands["dither"] = [this](const std::vector<std::string> &args)
+    { handleDither(args); };
+    commands["sampler"] = [this](const std::vector<std::string> &args)
+    { handleSampler(args); };
+    commands["blackbox"] = [this](const std::vector<std::string> &args)
+    { handleBlackbox(args); };
+    commands["clock"] = [this](const std::vector<std::string> &args)
+    { handleClock(args); };
+    commands["seed"] = [this](const std::vector<std::string> &args)
+    { handleSeed(args); };
+    commands["reload"] = [this](const std::vector<std::string> &args)
+    { handleReload(args); };
+    commands["watch"] = [this](const std::vector<std::string> &args)
+    { handleWatch(args); };
 }
 
 void CLIApp::handleEmpty(const std::vector<std::string> &args)
@@ -113,20 +272,15 @@ void CLIApp::handleEmpty(const std::vector<std::string> &args)
             return;
         }
         std::vector<unsigned char> packet;
-        if (!readNextReplayPacket(packet))
+        uint64_t version = 0;
+        if (!readNextReplayPacket(packet, version))
         {
             std::cout << "[Info] Replay finished or no more data. Use 'replay -e' to exit.\n";
             return;
         }
 
-        std::cout << "[Debug] Send packet: ";
-        for (auto b : packet)
-            std::cout << std::hex << std::uppercase << (int)b << " ";
-        std::cout << std::dec << std::endl;
-
-        if (serial_.sendData(packet))
+        if (sendPacket(packet, version))
         {
-            maybeRecordPacket(packet);
             std::cout << "[Info] Replay frame sent.\n";
         }
         else
@@ -137,28 +291,21 @@ void CLIApp::handleEmpty(const std::vector<std::string> &args)
     }
 
     // 非回放：随机生成并发送
-    controller_.randomizeAll();
-    auto data = controller_.getIntensityData();
+    if (!controller_.randomizeAll())
+        std::cout << "[Warning] Power budget too small for locked LEDs and minimums.\n";
+    std::vector<unsigned char> data;
+    uint64_t version = controller_.publish();
+    controller_.readFrame(data);
     if (!serial_.isOpen())
     {
         std::cout << "[Error] Serial port not open. Use setcom to set port.\n";
         return;
     }
     std::vector<unsigned char> packet;
-    packet.reserve(32);
-    packet.push_back(0xDA);
-    packet.push_back(0xAD);
-    packet.insert(packet.end(), data.begin(), data.end());
-
-    // 输出即将发送的数据
-    std::cout << "[Debug] Send packet: ";
-    for (auto b : packet)
-        std::cout << std::hex << std::uppercase << (int)b << " ";
-    std::cout << std::dec << std::endl;
+    FramePacket::build(data.data(), data.size(), packet);
 
-    if (serial_.sendData(packet))
+    if (sendPacket(packet, version))
     {
-        maybeRecordPacket(packet);
         std::cout << "[Info] Random intensity generated and sent.\n";
     }
     else
@@ -172,9 +319,10 @@ void CLIApp::handleSetCom(const std::vector<std::string> &args)
     // setcom COMx
     if (args.size() != 2)
     {
-        std::cout << "[Usage] setcom COMx\n";
+        std::cout << "[Usage] setcom COMx|<file>\n";
         return;
     }
+    std::lock_guard<std::mutex> lock(sendMutex_);
     if (serial_.open(args[1]))
     {
         lastUsedPort_ = args[1];
@@ -188,8 +336,9 @@ void CLIApp::handleSetCom(const std::vector<std::string> &args)
 
 void CLIApp::handleLS(const std::vector<std::string> &args)
 {
-    // 输出30个灯的详细信息
-    std::cout << "ID\tPeak\tMaxRad\tIntensity\tMaxIntensity\tLocked\n";
+    // 输出30个灯的详细信息（Sent 为经过校准表后实际发送的值）
+    auto calibration = controller_.getCalibration();
+    std::cout << "ID\tPeak\tMaxRad\tIntensity\tSent\tMin\tMaxIntensity\tLocked\n";
     for (int i = 1; i <= 30; ++i)
     {
         try
@@ -199,6 +348,8 @@ void CLIApp::handleLS(const std::vector<std::string> &args)
                       << led.getPeakWavelength() << "\t"
                       << led.getMaxRadiation() << "\t"
                       << (int)led.getIntensity() << "\t\t"
+                      << (int)calibration->getTable(i - 1)[led.getIntensity()] << "\t"
+                      << (int)led.getMinIntensity() << "\t"
                       << (int)led.getMaxIntensity() << "\t\t"
                       << (led.isLocked() ? "Yes" : "No") << "\n";
         }
@@ -211,7 +362,12 @@ void CLIApp::handleLS(const std::vector<std::string> &args)
 
 void CLIApp::handleSet(const std::vector<std::string> &args)
 {
-    // set l<x> y 或 set x y
+    // set l<x> y 或 set x y 或 set <selector> y
+    if (args.size() == 3 && !isSingleLed(args[1]))
+    {
+        applyBulk(args[1], LEDController::BulkOp::Set, std::stof(args[2]), 0, "intensity set to " + args[2]);
+        return;
+    }
     if (args.size() == 3 && args[1].size() > 1 && args[1][0] == 'l')
     {
         // set l<x> y
@@ -315,7 +471,12 @@ void CLIApp::handleSetMA(const std::vector<std::string> &args)
 
 void CLIApp::handleSetM(const std::vector<std::string> &args)
 {
-    // setm l<x> y 或 setm x y
+    // setm l<x> y 或 setm x y 或 setm <selector> y
+    if (args.size() == 3 && !isSingleLed(args[1]))
+    {
+        applyBulk(args[1], LEDController::BulkOp::SetMax, std::stof(args[2]), 0, "max intensity set to " + args[2]);
+        return;
+    }
     if (args.size() == 3 && args[1].size() > 1 && args[1][0] == 'l')
     {
         // setm l<x> y
@@ -352,10 +513,168 @@ void CLIApp::handleSetM(const std::vector<std::string> &args)
     }
 }
 
+void CLIApp::handleSetMin(const std::vector<std::string> &args)
+{
+    // setmin l<x> y 或 setmin x y 或 setmin <selector> y
+    if (args.size() == 3 && !isSingleLed(args[1]))
+    {
+        applyBulk(args[1], LEDController::BulkOp::SetMin, std::stof(args[2]), 0, "min intensity set to " + args[2]);
+        return;
+    }
+    if (args.size() == 3 && args[1].size() > 1 && args[1][0] == 'l')
+    {
+        int id = std::stoi(args[1].substr(1));
+        int value = std::stoi(args[2]);
+        try
+        {
+            controller_.getById(id).setMinIntensity((unsigned char)value);
+            std::cout << "[Info] LED #" << id << " min intensity set to " << value << "\n";
+        }
+        catch (...)
+        {
+            std::cout << "[Error] Invalid LED id.\n";
+        }
+    }
+    else if (args.size() == 3)
+    {
+        float peak = std::stof(args[1]);
+        int value = std::stoi(args[2]);
+        try
+        {
+            controller_.getByPeak(peak).setMinIntensity((unsigned char)value);
+            std::cout << "[Info] LED with peak " << peak << " min intensity set to " << value << "\n";
+        }
+        catch (...)
+        {
+            std::cout << "[Error] Invalid peak value.\n";
+        }
+    }
+    else
+    {
+        std::cout << "[Usage] setmin l<x> y  or  setmin <peak> <value>\n";
+    }
+}
+
+void CLIApp::handleBudget(const std::vector<std::string> &args)
+{
+    // budget x  或  budget off  或  budget
+    if (args.size() == 1)
+    {
+        if (controller_.getPowerBudget() > 0)
+            std::cout << "[Info] Power budget " << controller_.getPowerBudget() << ", current frame "
+                      << controller_.getFramePower() << "\n";
+        else
+            std::cout << "[Info] Power budget off, current frame " << controller_.getFramePower() << "\n";
+    }
+    else if (args.size() == 2 && args[1] == "off")
+    {
+        controller_.setPowerBudget(0);
+        std::cout << "[Info] Power budget off.\n";
+    }
+    else if (args.size() == 2)
+    {
+        float budget = std::stof(args[1]);
+        if (budget <= 0)
+        {
+            std::cout << "[Error] Budget must be positive. Use 'budget off' to disable.\n";
+            return;
+        }
+        controller_.setPowerBudget(budget);
+        std::cout << "[Info] Power budget set to " << budget << "\n";
+    }
+    else
+    {
+        std::cout << "[Usage] budget <value>  |  budget off  |  budget\n";
+    }
+}
+
+void CLIApp::handleSpectrum(const std::vector<std::string> &args)
+{
+    // spectrum  或  spectrum -o <file>  或  spectrum grid <start> <step> <points>
+    const SpectralModel &model = controller_.getSpectralModel();
+    if (args.size() == 1)
+    {
+        auto spectrum = controller_.computeSpectrum();
+        size_t peak = 0;
+        double total = 0;
+        for (size_t p = 0; p < spectrum.size(); ++p)
+        {
+            total += spectrum[p] * model.getStep();
+            if (spectrum[p] > spectrum[peak])
+                peak = p;
+        }
+
+        // 评估耗时：取多次平均
+        auto data = controller_.getCalibratedData();
+        const int runs = 1000;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < runs; ++i)
+            model.evaluate(data.data(), spectrum.data());
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+
+        std::cout << "[Info] Grid " << model.getStart() << "-" << model.getWavelength(model.getPointCount() - 1)
+                  << " nm, step " << model.getStep() << " nm (" << model.getPointCount() << " points)\n"
+                  << "[Info] Peak " << spectrum[peak] << " at " << model.getWavelength(peak) << " nm, integral "
+                  << total << ", evaluated in " << us << " us\n";
+    }
+    else if (args.size() == 3 && args[1] == "-o")
+    {
+        std::ofstream ofs(args[2], std::ios::out | std::ios::trunc);
+        if (!ofs.is_open())
+        {
+            std::cout << "[Error] Failed to open " << args[2] << "\n";
+            return;
+        }
+        auto data = controller_.getCalibratedData(); // 实际发送的值，与 computeSpectrum 一致
+        auto spectrum = controller_.computeSpectrum();
+        // 只为当前点亮且有光谱参数的灯输出单独的列
+        std::vector<size_t> lit;
+        ofs << "wavelength_nm,total";
+        for (size_t c = 0; c < data.size(); ++c)
+        {
+            float peakWeight = 0;
+            for (size_t p = 0; p < model.getPointCount(); ++p)
+                peakWeight = std::max(peakWeight, model.getWeight(p, c));
+            if (data[c] != 0 && peakWeight > 0)
+            {
+                lit.push_back(c);
+                ofs << ",l" << (c + 1);
+            }
+        }
+        ofs << "\n";
+        for (size_t p = 0; p < model.getPointCount(); ++p)
+        {
+            ofs << model.getWavelength(p) << "," << spectrum[p];
+            for (auto c : lit)
+                ofs << "," << model.getWeight(p, c) * data[c];
+            ofs << "\n";
+        }
+        std::cout << "[Info] Spectrum written to " << args[2] << "\n";
+    }
+    else if (args.size() == 5 && args[1] == "grid")
+    {
+        float start = std::stof(args[2]);
+        float step = std::stof(args[3]);
+        int points = std::stoi(args[4]);
+        if (step <= 0 || points <= 0 || points > 100000)
+        {
+            std::cout << "[Error] Step must be positive and points 1-100000.\n";
+            return;
+        }
+        controller_.setSpectralGrid(start, step, static_cast<size_t>(points));
+        std::cout << "[Info] Spectral grid set to " << start << " nm + " << points << " x " << step << " nm\n";
+    }
+    else
+    {
+        std::cout << "[Usage] spectrum  |  spectrum -o <file.csv>  |  spectrum grid <start> <step> <points>\n";
+    }
+}
+
 void CLIApp::handleRandom(const std::vector<std::string> &args)
 {
     // 随机生成强度
-    controller_.randomizeAll();
+    if (!controller_.randomizeAll())
+        std::cout << "[Warning] Power budget too small for locked LEDs and minimums.\n";
     std::cout << "[Info] Random intensity generated.\n";
 }
 
@@ -367,22 +686,14 @@ void CLIApp::handleSend(const std::vector<std::string> &args)
         std::cout << "[Error] Serial port not open. Use setcom to set port.\n";
         return;
     }
-    auto data = controller_.getIntensityData();
+    std::vector<unsigned char> data;
+    uint64_t version = controller_.publish();
+    controller_.readFrame(data);
     std::vector<unsigned char> packet;
-    packet.reserve(32);
-    packet.push_back(0xDA);
-    packet.push_back(0xAD);
-    packet.insert(packet.end(), data.begin(), data.end());
+    FramePacket::build(data.data(), data.size(), packet);
 
-    // 输出即将发送的数据
-    std::cout << "[Debug] Send packet: ";
-    for (auto b : packet)
-        std::cout << std::hex << std::uppercase << (int)b << " ";
-    std::cout << std::dec << std::endl;
-
-    if (serial_.sendData(packet))
+    if (sendPacket(packet, version))
     {
-        maybeRecordPacket(packet);
         std::cout << "[Info] Data sent to serial port.\n";
     }
     else
@@ -393,7 +704,7 @@ void CLIApp::handleSend(const std::vector<std::string> &args)
 
 void CLIApp::handleDo(const std::vector<std::string> &args)
 {
-    // do X：random+send执行Y次，每次间隔1秒
+    // do X：random+send执行X次，每帧保持一个积分时间+稳定时间
     if (args.size() != 2)
     {
         std::cout << "[Usage] do <count>\n";
@@ -402,31 +713,24 @@ void CLIApp::handleDo(const std::vector<std::string> &args)
     int count = std::stoi(args[1]);
     for (int i = 0; i < count; ++i)
     {
-        controller_.randomizeAll();
-        auto data = controller_.getIntensityData();
+        // 帧边界：应用热重载的配置，下一帧即按新上限/校准生成
+        applyPendingReload();
+        if (!controller_.randomizeAll())
+            std::cout << "[Warning] Power budget too small for locked LEDs and minimums.\n";
+        std::vector<unsigned char> data;
+        uint64_t version = controller_.publish();
+        controller_.readFrame(data);
         std::vector<unsigned char> packet;
-        packet.reserve(32);
-        packet.push_back(0xDA);
-        packet.push_back(0xAD);
-        packet.insert(packet.end(), data.begin(), data.end());
-
-        // 输出即将发送的数据
-        std::cout << "[Debug] Send packet: ";
-        for (auto b : packet)
-            std::cout << std::hex << std::uppercase << (int)b << " ";
-        std::cout << std::dec << std::endl;
+        FramePacket::build(data.data(), data.size(), packet);
 
-        if (!serial_.isOpen() || !serial_.sendData(packet))
+        if (!serial_.isOpen() || !sendPacket(packet, version))
         {
             std::cout << "[Error] Serial port not open or send failed.\n";
             break;
         }
-        else
-        {
-            maybeRecordPacket(packet);
-        }
         std::cout << "[Info] [" << (i + 1) << "/" << count << "] Data sent.\n";
-        std::this_thread::sleep_for(std::chrono::seconds(1));
+        TRACE_SPAN("hold sleep");
+        clock_.sleepFor(std::chrono::microseconds(controller_.getIntegrationTime() + controller_.getSettleTime()));
     }
 }
 
@@ -460,31 +764,106 @@ void CLIApp::handleHelp(const std::vector<std::string> &args)
 {
     std::cout << "Available commands:\n"
                  "  (empty)         : Generate random intensities and send to COM port\n"
-                 "  setcom COMx     : Set output serial port\n"
+                 "  setcom COMx     : Set output serial port (a file or pipe path is written raw, e.g. for simspec)\n"
                  "  ls              : List all 30 LEDs info\n"
                  "  set l<x> y      : Set LED by id to intensity y\n"
                  "  set <peak> y    : Set LED by peak to intensity y\n"
+                 "  set <sel> y     : Set every LED matched by a selector (also setm, setmin, lock, unlock)\n"
+                 "                    e.g. l1-l10  l3,l7,l9  400-600nm  visible&!locked  @name\n"
+                 "                    atoms: all none valid visible uv nir rgb white locked unlocked on off\n"
+                 "  op <sel> <set|scale|add|clamp|setm|setmin|lock|unlock|random> [a] [b] : Bulk operation\n"
+                 "  sel <name> <sel>: Define a named selector, used as @name\n"
+                 "  sel -d <name>   : Delete a named selector\n"
+                 "  sel ? <sel>     : Show the LEDs a selector matches\n"
+                 "  sel             : List named selectors\n"
                  "  seta x          : Set all LEDs intensity to x\n"
                  "  setma x         : Set all LEDs max intensity to x\n"
                  "  setm l<x> y     : Set LED by id max intensity to y\n"
                  "  setm <peak> y   : Set LED by peak max intensity to y\n"
+                 "  setmin l<x> y   : Set LED by id min random intensity to y\n"
+                 "  setmin <peak> y : Set LED by peak min random intensity to y\n"
+                 "  budget x        : Keep random frames under radiant power x (maxRad units)\n"
+                 "  budget off      : Disable the power budget\n"
+                 "  budget          : Show budget and current frame power\n"
+                 "  spectrum        : Summarize the modelled spectrum of the current frame as sent (after calibration)\n"
+                 "  spectrum -o f   : Export the spectrum (total and per LED) to CSV file f\n"
+                 "  spectrum grid <start> <step> <points> : Set the wavelength grid in nm\n"
                  "  random          : Generate random intensities\n"
+                 "  seed n          : Seed the random frame generator (reproducible runs)\n"
+                 "  sampler sobol|halton [seed] [--at n] : Draw random frames from a low-discrepancy sequence\n"
+                 "  sampler resume f : Continue the sequence after the last sampled frame recorded in f\n"
+                 "  sampler uniform : Back to independent uniform frames\n"
+                 "  sampler         : Show the random frame sampler\n"
                  "  send            : Send current intensities to serial port\n"
-                 "  do X            : random+send X times, 1s interval\n"
+                 "  do X            : random+send X times, each held for integration + settle time\n"
+                 "  integ [us] [settle] : Show or set the camera integration time and LED settle time (us)\n"
+                 "  clock           : Show the clock timed commands run on (--virtual-clock simulates time)\n"
+                 "  clock +ms       : Advance the virtual clock\n"
                  "  save            : Save max intensities to file\n"
                  "  load            : Load max intensities from file\n"
+                 "  reload          : Show hot reload status (config and calibration files are watched)\n"
+                 "  reload now [config|calib] : Reload the files now, keeping the old config if invalid\n"
+                 "  reload -s | -e  : Start or stop watching the files\n"
                  "  help            : Show this help\n"
+                 "  journal         : Show the crash-safe state journal (restored at startup, --fresh skips it)\n"
+                 "  journal snap    : Compact the journal into a snapshot now\n"
+                 "  blackbox        : Show the in-memory flight recorder of recently sent frames\n"
+                 "  blackbox dump [f] : Write it as a replayable recording (default blackbox.txt)\n"
                  "  record -s [f]   : Start recording sent packets to file f (default record.txt)\n"
                  "  record -e       : Stop recording\n"
                  "  replay -s [f]   : Start replay from file f (default record.txt)\n"
+                 "  replay -s f --from n --to m : Replay only frames n-m (0-based, as printed by 'query')\n"
                  "  replay -e       : Stop replay mode\n"
+                 "  stream -s [hz]  : Stream the current frame in background (default 50 Hz)\n"
+                 "  stream -e       : Stop streaming\n"
+                 "  stream          : Show streaming status\n"
+                 "  dither <sel> <level> : Hold fractional levels (e.g. 12.37) by dithering across streamed frames\n"
+                 "  dither off [sel] : Stop dithering (all LEDs or the selected ones)\n"
+                 "  dither          : Show targets, achieved mean and ripple per LED, and frame timing\n"
+                 "  serve -s [port] : Accept commands and frame batches on 127.0.0.1 (default 7070)\n"
+                 "  serve -e        : Stop the control server\n"
+                 "  serve           : Show control server status\n"
+                 "  ring -s [name]  : Forward frames from shared-memory ring (default LightsDebuggerRing)\n"
+                 "  ring -e         : Stop forwarding and remove the ring\n"
+                 "  ring            : Show ring counters\n"
+                 "  calib load [f]  : Load per-LED calibration tables (default led_calib.cfg)\n"
+                 "  calib off       : Send raw intensities\n"
+                 "  calib           : Show calibration status\n"
+                 "  log <lvl> [cat] : Set log level (trace|debug|info|warn|error|off) for all or one category\n"
+                 "                    (general|serial|record|replay|command); 'debug serial' shows sent packets\n"
+                 "  log -f <file>   : Also write all log messages to file (appends)\n"
+                 "  log -e          : Stop writing the log file\n"
+                 "  log rate x      : Limit console log output to x lines/s (0 = unlimited)\n"
+                 "  log             : Show log levels and counters\n"
+                 "  proto <fmt>     : Set the wire format: 8 (default), 10, 12 bit; 8c/10c/12c add counter+CRC\n"
+                 "  proto           : Show the wire format and packet size\n"
+                 "  tune <target> <src> [iters] [tol%] : Adjust unlocked LEDs until the readings from src\n"
+                 "                    (file, pipe or COM port, one line per frame) match target (default 20, 1%)\n"
+                 "  seq -s random n [opts] : Play n random frames, one per exposure, in background\n"
+                 "  seq -s file f [--from n] [--to m] [opts] : Play recorded frames n-m of text recording f\n"
+                 "                    opts: --trigger src  advance on each trigger instead of timed holds\n"
+                 "                    (event:<name>, COM port, pipe or file; one line per trigger)\n"
+                 "  seq -e          : Stop the sequence\n"
+                 "  seq -w          : Wait for a timed sequence to finish, then show its latency\n"
+                 "  seq             : Show progress and wake-up-to-write latency\n"
+                 "  co ramp l<x> <from> <to> <ms> [step ms] : Ramp one LED in background (default 10 ms steps)\n"
+                 "  co pulse l<x> <value> <on ms> <off ms> [count] : Pulse train on one LED (0 = endless)\n"
+                 "  co replay <f> <period ms> [loops] : Replay a text recording in background (0 = endless)\n"
+                 "                    co sequences run concurrently on one thread and override their LEDs\n"
+                 "  co -e           : Stop all co sequences and release their LEDs\n"
+                 "  co              : Show running co sequences and timer lateness\n"
+                 "  trace -s [f]    : Record command, generation, encode, serial, record and sleep spans\n"
+                 "  trace -e        : Stop tracing and write Chrome trace JSON to f (default trace.json)\n"
+                 "  trace           : Show tracing status\n"
                  "  lock l<x>       : Lock LED by id (prevent changes)\n"
                  "  lock <peak>     : Lock LED by peak (prevent changes)\n"
                  "  lock all        : Lock all LEDs (prevent changes)\n"
                  "  unlock l<x>     : Unlock LED by id (allow changes)\n"
                  "  unlock <peak>   : Unlock LED by peak (allow changes)\n"
                  "  unlock all      : Unlock all LEDs (allow changes)\n"
-                 "  cls             : Clear all LED intensities\n";
+                 "  watch [hz]      : Live dashboard above the prompt: bars, locks, send rate, queues (default 10 Hz)\n"
+                 "  watch -e        : Close the dashboard\n"
+                 "  cls             : Clear the screen\n";
 }
 
 void CLIApp::handleError(const std::vector<std::string> &args)
@@ -494,6 +873,14 @@ void CLIApp::handleError(const std::vector<std::string> &args)
 
 void CLIApp::handleClear(const std::vector<std::string> &args)
 {
+    // ANSI 清屏，不再为此启动 shell；面板打开时光标回到面板下方
+    if (TerminalView::enableAnsi())
+    {
+        TerminalView::write(isWatching_ ? "\x1b[2J\x1b[" + std::to_string(kDashboardRows + 1) + ";1H"
+                                        : std::string("\x1b[2J\x1b[H"));
+        watchRedraw_ = true;
+        return;
+    }
 #ifdef _WIN32
     system("cls");
 #else
@@ -520,6 +907,11 @@ void CLIApp::handleLock(const std::vector<std::string> &args)
         std::cout << "[Info] All LEDs locked.\n";
         return;
     }
+    if (args.size() == 2 && !isSingleLed(args[1]))
+    {
+        applyBulk(args[1], LEDController::BulkOp::Lock, 0, 0, "locked");
+        return;
+    }
 
     // lock l<x> 或 lock <peak>
     if (args.size() == 2 && args[1].size() > 1 && args[1][0] == 'l')
@@ -575,6 +967,11 @@ void CLIApp::handleUnlock(const std::vector<std::string> &args)
         std::cout << "[Info] All LEDs unlocked.\n";
         return;
     }
+    if (args.size() == 2 && !isSingleLed(args[1]))
+    {
+        applyBulk(args[1], LEDController::BulkOp::Unlock, 0, 0, "unlocked");
+        return;
+    }
 
     // unlock l<x> 或 unlock <peak>
     if (args.size() == 2 && args[1].size() > 1 && args[1][0] == 'l')
@@ -619,33 +1016,25 @@ void CLIApp::handleRecord(const std::vector<std::string> &args)
         std::cout << "[Error] Usage: record -s [filename]  |  record -e\n";
         return;
     }
+    std::lock_guard<std::mutex> lock(sendMutex_);
     if (args[1] == "-s")
     {
         std::string path = (args.size() >= 3) ? args[2] : std::string("record.txt");
-        if (recordFile_.is_open())
-        {
-            recordFile_.close();
-        }
-        recordFile_.open(path, std::ios::out | std::ios::trunc);
-        if (!recordFile_.is_open())
+        if (!recorder_.open(path))
         {
             std::cout << "[Error] Failed to open record file: " << path << "\n";
             return;
         }
-        recordFilePath_ = path;
-        isRecording_ = true;
-        std::cout << "[Info] Recording started to '" << recordFilePath_ << "'.\n";
+        std::cout << "[Info] Recording started to '" << recorder_.getPath() << "'.\n";
     }
     else if (args[1] == "-e")
     {
-        if (!isRecording_)
+        if (!recorder_.isOpen())
         {
             std::cout << "[Info] Recording has not been started. Use 'record -s [file]'.\n";
             return;
         }
-        if (recordFile_.is_open())
-            recordFile_.close();
-        isRecording_ = false;
+        recorder_.close();
         std::cout << "[Info] Recording stopped.\n";
     }
     else
@@ -656,15 +1045,45 @@ void CLIApp::handleRecord(const std::vector<std::string> &args)
 
 void CLIApp::handleReplay(const std::vector<std::string> &args)
 {
-    // replay -s [file]  或  replay -e
+    // replay -s [file] [--from n] [--to m]  或  replay -e
     if (args.size() < 2)
     {
-        std::cout << "[Error] Usage: replay -s [filename]  |  replay -e\n";
+        std::cout << "[Error] Usage: replay -s [filename] [--from n] [--to m]  |  replay -e\n";
         return;
     }
     if (args[1] == "-s")
     {
-        std::string path = (args.size() >= 3) ? args[2] : std::string("record.txt");
+        // 帧号从 0 开始，区间含两端（与 query 输出一致）
+        std::string path = "record.txt";
+        uint64_t from = 0, to = std::numeric_limits<uint64_t>::max();
+        bool pathSet = false;
+        for (size_t i = 2; i < args.size(); ++i)
+        {
+            try
+            {
+                if (args[i] == "--from" && i + 1 < args.size())
+                    from = std::stoull(args[++i]);
+                else if (args[i] == "--to" && i + 1 < args.size())
+                    to = std::stoull(args[++i]);
+                else if (!pathSet && args[i].rfind("--", 0) != 0)
+                {
+                    path = args[i];
+                    pathSet = true;
+                }
+                else
+                    throw std::invalid_argument(args[i]);
+            }
+            catch (...)
+            {
+                std::cout << "[Error] Usage: replay -s [filename] [--from n] [--to m]  |  replay -e\n";
+                return;
+            }
+        }
+        if (from > to)
+        {
+            std::cout << "[Error] --from must not be after --to.\n";
+            return;
+        }
         if (replayFile_.is_open())
             replayFile_.close();
         replayFile_.open(path);
@@ -673,9 +1092,22 @@ void CLIApp::handleReplay(const std::vector<std::string> &args)
             std::cout << "[Error] Failed to open replay file: " << path << "\n";
             return;
         }
+        std::string skipped;
+        for (uint64_t i = 0; i < from && std::getline(replayFile_, skipped); ++i)
+        {
+        }
+        replayNext_ = from;
+        replayLast_ = to;
         replayFilePath_ = path;
         isReplaying_ = true;
-        std::cout << "[Info] Replay started from '" << replayFilePath_ << "'. Press Enter to send next frame.\n";
+        std::cout << "[Info] Replay started from '" << replayFilePath_ << "'";
+        if (from != 0 || to != std::numeric_limits<uint64_t>::max())
+        {
+            std::cout << " at frame " << from;
+            if (to != std::numeric_limits<uint64_t>::max())
+                std::cout << " through " << to;
+        }
+        std::cout << ". Press Enter to send next frame.\n";
     }
     else if (args[1] == "-e")
     {
@@ -691,58 +1123,1948 @@ void CLIApp::handleReplay(const std::vector<std::string> &args)
     }
     else
     {
-        std::cout << "[Error] Usage: replay -s [filename]  |  replay -e\n";
+        std::cout << "[Error] Usage: replay -s [filename] [--from n] [--to m]  |  replay -e\n";
     }
 }
 
-void CLIApp::maybeRecordPacket(const std::vector<unsigned char> &packet)
+void CLIApp::handleStream(const std::vector<std::string> &args)
 {
-    if (!isRecording_ || !recordFile_.is_open())
+    // stream -s [hz]  或  stream -e  或  stream
+    if (args.size() == 1)
+    {
+        if (isStreaming_)
+            std::cout << "[Info] Streaming at " << streamHz_ << " Hz, " << streamFrames_.load() << " frames sent, "
+                      << streamErrors_.load() << " errors, frame version " << controller_.frameVersion() << ".\n";
+        else
+            std::cout << "[Info] Not streaming.\n";
         return;
-    // 按行记录：32个两位十六进制数（大写，零填充）
-    for (size_t i = 0; i < packet.size(); ++i)
+    }
+    if (args[1] == "-s" && args.size() <= 3)
+    {
+        int hz = (args.size() == 3) ? std::stoi(args[2]) : 50;
+        if (hz <= 0 || hz > 1000)
+        {
+            std::cout << "[Error] Stream rate must be 1-1000 Hz.\n";
+            return;
+        }
+        if (!serial_.isOpen())
+        {
+            std::cout << "[Error] Serial port not open. Use setcom to set port.\n";
+            return;
+        }
+        // 虚拟时钟下 sleepUntil 立即返回：流会变成不限速的忙循环，并把共享的时间线推走
+        if (clock_.isVirtual())
+        {
+            std::cout << "[Error] stream is paced in real time and is not available with --virtual-clock; use 'do' or 'seq'.\n";
+            return;
+        }
+        stopStream();
+        streamHz_ = hz;
+        streamFrames_ = 0;
+        streamErrors_ = 0;
+        streamIntervalSumUs_ = 0;
+        streamIntervalMaxUs_ = 0;
+        dither_.resetStats();
+        isStreaming_ = true;
+        streamCommand_ = t_command;
+        streamThread_ = std::thread(&CLIApp::streamLoop, this);
+        std::cout << "[Info] Streaming started at " << hz << " Hz.\n";
+    }
+    else if (args[1] == "-e" && args.size() == 2)
+    {
+        if (!isStreaming_)
+        {
+            std::cout << "[Info] Streaming has not been started. Use 'stream -s [hz]'.\n";
+            return;
+        }
+        stopStream();
+        std::cout << "[Info] Streaming stopped after " << streamFrames_.load() << " frames.\n";
+    }
+    else
     {
-        if (i)
-            recordFile_ << ' ';
-        recordFile_ << std::uppercase << std::hex << std::setw(2) << std::setfill('0') << (int)packet[i];
+        std::cout << "[Error] Usage: stream -s [hz]  |  stream -e  |  stream\n";
     }
-    recordFile_ << std::dec << "\n";
-    recordFile_.flush();
 }
 
-bool CLIApp::readNextReplayPacket(std::vector<unsigned char> &packet)
+void CLIApp::streamLoop()
 {
-    if (!replayFile_.is_open())
-        return false;
-    std::string line;
-    if (!std::getline(replayFile_, line))
-        return false;
-    std::istringstream iss(line);
-    std::string tok;
-    std::vector<unsigned char> bytes;
-    while (iss >> tok)
+    // 后台线程：只读已发布的帧，不与命令线程争用锁
+    Tracer::instance().setThreadName("stream");
+    t_command = streamCommand_;
+    const auto period = std::chrono::microseconds(1000000 / streamHz_);
+    auto next = clock_.now();
+    std::vector<unsigned char> data;
+    std::vector<unsigned char> packet;
+    auto last = next;
+    while (isStreaming_)
     {
-        try
+        uint64_t version = controller_.readFrame(data);
+        // 抖动通道每帧取下一级（已发布帧是校准后的数据，抖动级别同样过校准表）
+        if (dither_.isActive())
+            dither_.next(data.data(), data.size(), *controller_.getCalibration());
+        FramePacket::build(data.data(), data.size(), packet);
+        if (sendPacket(packet, version))
+            ++streamFrames_;
+        else
+            ++streamErrors_;
+        // 帧间隔统计：抖动的平均值依赖稳定帧率
+        const auto now = clock_.now();
+        const auto intervalUs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(now - last).count());
+        last = now;
+        streamIntervalSumUs_ += intervalUs;
+        if (intervalUs > streamIntervalMaxUs_)
+            streamIntervalMaxUs_ = intervalUs;
+        next += period;
+        TRACE_SPAN("stream sleep");
+        clock_.sleepUntil(next);
+    }
+}
+
+void CLIApp::stopStream()
+{
+    isStreaming_ = false;
+    if (streamThread_.joinable())
+        streamThread_.join();
+}
+
+void CLIApp::handleServe(const std::vector<std::string> &args)
+{
+    // serve -s [port]  或  serve -e  或  serve
+    if (args.size() == 1)
+    {
+        if (server_.isRunning())
+            std::cout << "[Info] Serving on 127.0.0.1:" << server_.getPort() << ", " << server_.getClientCount()
+                      << " clients, " << server_.getCommandCount() << " commands, "
+                      << server_.getFrameCount() << " frames sent.\n";
+        else
+            std::cout << "[Info] Control server not running.\n";
+        return;
+    }
+    if (args[1] == "-s" && args.size() <= 3)
+    {
+        int port = (args.size() == 3) ? std::stoi(args[2]) : ControlProtocol::kDefaultPort;
+        if (port <= 0 || port > 65535)
         {
-            int v = std::stoi(tok, nullptr, 16);
-            if (v < 0)
-                v = 0;
-            if (v > 255)
-                v = 255;
-            bytes.push_back(static_cast<unsigned char>(v));
+            std::cout << "[Error] Invalid port.\n";
+            return;
         }
-        catch (...)
+        if (server_.isRunning())
         {
-            // 非法行，标记失败
-            bytes.clear();
-            break;
+            std::cout << "[Warn] Control server already running on port " << server_.getPort() << ".\n";
+            return;
         }
+        auto onCommand = [this](const std::string &line)
+        {
+            // 远程客户端不能控制服务器本身
+            std::istringstream iss(line);
+            std::string cmd;
+            iss >> cmd;
+            if (cmd == "serve")
+                return false;
+            // 与控制台共用命令锁；服务器停止时放弃等待
+            while (!commandMutex_.try_lock_for(std::chrono::milliseconds(10)))
+            {
+                if (!server_.isRunning())
+                    return false;
+            }
+            std::lock_guard<std::timed_mutex> lock(commandMutex_, std::adopt_lock);
+            return executeLine(line);
+        };
+        auto onFrames = [this](const unsigned char *frames, size_t count, size_t frameSize)
+        { return submitFrames(frames, count, frameSize); };
+        if (server_.start(static_cast<uint16_t>(port), onCommand, onFrames))
+            std::cout << "[Info] Control server listening on 127.0.0.1:" << port << "\n";
+        else
+            std::cout << "[Error] Failed to start control server on port " << port << "\n";
     }
-    if (bytes.size() != 32)
+    else if (args[1] == "-e" && args.size() == 2)
     {
-        std::cout << "[Error] Invalid replay line (expect 32 bytes).\n";
-        return false;
+        if (!server_.isRunning())
+        {
+            std::cout << "[Info] Control server has not been started. Use 'serve -s [port]'.\n";
+            return;
+        }
+        server_.stop();
+        std::cout << "[Info] Control server stopped.\n";
     }
-    packet = std::move(bytes);
-    return true;
+    else
+    {
+        std::cout << "[Error] Usage: serve -s [port]  |  serve -e  |  serve\n";
+    }
+}
+
+size_t CLIApp::submitFrames(const unsigned char *frames, size_t count, size_t frameSize)
+{
+    // 外部提交的帧：逐帧加包头，整批一次写入串口
+    if (frameSize != controller_.getLedCount() || count == 0)
+        return 0;
+    const size_t packetSize = FramePacket::kHeaderSize + frameSize;
+    auto calibration = controller_.getCalibration();
+    std::vector<unsigned char> batch;
+    FramePacket::buildBatch(frames, count, frameSize, calibration.get(), batch);
+
+    LOG_TEXT(Serial, Debug, "Send batch: " + std::to_string(count) + " frames, " + std::to_string(batch.size()) + " bytes.");
+    std::unique_lock<std::mutex> lock(sendMutex_, std::defer_lock);
+    {
+        TRACE_SPAN("send lock wait");
+        lock.lock();
+    }
+    for (size_t i = 0; i < count; ++i)
+        blackbox_.record(batch.data() + i * packetSize, packetSize, 0, t_command);
+    bool sent;
+    if (wireFormat_ != FrameProtocol::Format::Raw8)
+    {
+        size_t wireSize = FrameProtocol::encodeBatch(wireFormat_, batch.data(), count, frameSize, frameCounter_, wire_);
+        sent = serial_.sendData(wire_.data(), wireSize);
+    }
+    else
+    {
+        frameCounter_ = static_cast<uint8_t>(frameCounter_ + count);
+        sent = serial_.sendData(batch);
+    }
+    if (!sent)
+    {
+        LOG_TEXT(Serial, Warn, "Serial write of a " + std::to_string(count) + "-frame batch failed.");
+        sendFailures_.fetch_add(1, std::memory_order_relaxed);
+        dumpBlackboxOnFailure(lock);
+        return 0;
+    }
+    blackboxDumped_ = false;
+    framesSent_.fetch_add(count, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i)
+        recorder_.write(batch.data() + i * packetSize, packetSize, 0); // 版本号0表示非控制器状态的外部帧
+    return count;
+}
+
+void CLIApp::handleCalib(const std::vector<std::string> &args)
+{
+    // calib load [file]  或  calib off  或  calib
+    if (args.size() == 1)
+    {
+        if (controller_.getCalibration()->isIdentity())
+            std::cout << "[Info] Calibration off (raw intensities are sent).\n";
+        else
+            std::cout << "[Info] Calibration on, loaded from '" << calibFile_ << "'. See 'ls' for sent values.\n";
+        return;
+    }
+    if (args[1] == "load" && args.size() <= 3)
+    {
+        std::string path = (args.size() == 3) ? args[2] : calibFile_;
+        if (controller_.loadCalibration(path))
+        {
+            calibFile_ = path;
+            if (watcher_.isRunning())
+                startWatcher(); // 监视新的校准文件
+            std::cout << "[Info] Calibration loaded from " << path << "\n";
+        }
+        else
+        {
+            std::cout << "[Error] Failed to load calibration from " << path << "\n";
+        }
+    }
+    else if (args[1] == "off" && args.size() == 2)
+    {
+        controller_.clearCalibration();
+        std::cout << "[Info] Calibration off.\n";
+    }
+    else
+    {
+        std::cout << "[Error] Usage: calib load [file]  |  calib off  |  calib\n";
+    }
+}
+
+void CLIApp::handleRing(const std::vector<std::string> &args)
+{
+    // ring -s [name]  或  ring -e  或  ring
+    if (args.size() == 1)
+    {
+        if (isRingRunning_)
+            std::cout << "[Info] Ring '" << ring_.getName() << "': " << ring_.getConsumed() << " consumed, "
+                      << ringSent_.load() << " sent, " << ringErrors_.load() << " send errors, "
+                      << ring_.getPending() << " pending, " << ring_.getOverruns() << " overruns (capacity "
+                      << ring_.getCapacity() << ").\n";
+        else
+            std::cout << "[Info] Frame ring not running.\n";
+        return;
+    }
+    if (args[1] == "-s" && args.size() <= 3)
+    {
+        std::string name = (args.size() == 3) ? args[2] : std::string(FrameRing::kDefaultName);
+        stopRing();
+        if (!ring_.create(name, FrameRing::kDefaultCapacity))
+        {
+            std::cout << "[Error] Failed to create shared-memory ring '" << name << "'.\n";
+            return;
+        }
+        ringSent_ = 0;
+        ringErrors_ = 0;
+        isRingRunning_ = true;
+        ringCommand_ = t_command;
+        ringThread_ = std::thread(&CLIApp::ringLoop, this);
+        std::cout << "[Info] Forwarding frames from ring '" << name << "' (" << FrameRing::kDefaultCapacity
+                  << " slots).\n";
+    }
+    else if (args[1] == "-e" && args.size() == 2)
+    {
+        if (!isRingRunning_)
+        {
+            std::cout << "[Info] Frame ring has not been started. Use 'ring -s [name]'.\n";
+            return;
+        }
+        uint64_t consumed = ring_.getConsumed(), overruns = ring_.getOverruns();
+        stopRing();
+        std::cout << "[Info] Frame ring stopped after " << consumed << " frames, " << overruns << " overruns.\n";
+    }
+    else
+    {
+        std::cout << "[Error] Usage: ring -s [name]  |  ring -e  |  ring\n";
+    }
+}
+
+void CLIApp::ringLoop()
+{
+    // 帧直接从共享内存槽写入串口，不经过字符串或中间缓冲
+    Tracer::instance().setThreadName("ring");
+    t_command = ringCommand_;
+    auto onPacket = [this](const unsigned char *packet, size_t size, uint64_t)
+    {
+        if (sendPacket(packet, size, 0))
+            ++ringSent_;
+        else
+            ++ringErrors_;
+    };
+    while (isRingRunning_)
+        ring_.consume(onPacket, 100);
+}
+
+void CLIApp::stopRing()
+{
+    isRingRunning_ = false;
+    if (ringThread_.joinable())
+        ringThread_.join();
+    ring_.close();
+}
+
+bool CLIApp::sendPacket(const std::vector<unsigned char> &packet, uint64_t version)
+{
+    return sendPacket(packet.data(), packet.size(), version);
+}
+
+bool CLIApp::sendPacket(const unsigned char *packet, size_t size, uint64_t version)
+{
+    // 数据包只按原始字节入队，格式化在日志线程完成
+    Logger::instance().logBytes(Logger::Category::Serial, Logger::Level::Debug, "Send packet:", packet, size);
+    std::unique_lock<std::mutex> lock(sendMutex_, std::defer_lock);
+    {
+        TRACE_SPAN("send lock wait");
+        lock.lock();
+    }
+    // packet 是 8 位标准格式（记录文件也保存这种格式），其他线上格式在此重新编码
+    const unsigned char *wire = packet;
+    size_t wireSize = size;
+    if (wireFormat_ != FrameProtocol::Format::Raw8 && size > FramePacket::kHeaderSize)
+    {
+        wireSize = FrameProtocol::encodeBatch(wireFormat_, packet, 1, size - FramePacket::kHeaderSize, frameCounter_,
+                                              wire_);
+        wire = wire_.data();
+    }
+    else
+    {
+        ++frameCounter_;
+    }
+    blackbox_.record(packet, size, version, t_command);
+    if (!serial_.sendData(wire, wireSize))
+    {
+        LOG_TEXT(Serial, Warn, "Serial write of " + std::to_string(wireSize) + " bytes failed.");
+        sendFailures_.fetch_add(1, std::memory_order_relaxed);
+        dumpBlackboxOnFailure(lock);
+        return false;
+    }
+    blackboxDumped_ = false;
+    framesSent_.fetch_add(1, std::memory_order_relaxed);
+    // 采样序列产生的帧在记录中带上序列位置，便于续采
+    RecordingFormat::SampleTag tag;
+    const bool sampled = recorder_.isOpen() && size > FramePacket::kHeaderSize &&
+                         controller_.getSampleTag(version, packet + FramePacket::kHeaderSize,
+                                                  size - FramePacket::kHeaderSize, tag);
+    recorder_.write(packet, size, version, sampled ? &tag : nullptr);
+    return true;
+}
+
+void CLIApp::dumpBlackboxOnFailure(std::unique_lock<std::mutex> &lock)
+{
+    // 每段连续失败只自动转储一次黑匣子，文件在锁外写出
+    if (blackboxDumped_.exchange(true))
+        return;
+    auto frames = blackbox_.snapshot();
+    lock.unlock();
+    std::string error;
+    if (blackbox_.dump(frames, blackboxErrorFile_, error))
+        LOG_TEXT(General, Warn, "Send failed; last " + std::to_string(frames.size()) + " frames dumped to '" +
+                                    blackboxErrorFile_ + "'.");
+    else
+        LOG_TEXT(General, Error, "Send failed; black box dump failed: " + error + ".");
+}
+
+bool CLIApp::readNextReplayPacket(std::vector<unsigned char> &packet, uint64_t &version)
+{
+    if (!replayFile_.is_open() || replayNext_ > replayLast_)
+        return false;
+    std::string line;
+    if (!std::getline(replayFile_, line))
+        return false;
+    ++replayNext_;
+    std::vector<unsigned char> bytes(RecordingFormat::kPacketSize);
+    const char *error = nullptr;
+    if (!RecordingFormat::parseLine(line.data(), line.data() + line.size(), bytes.data(), version, error))
+    {
+        std::cout << "[Error] Invalid replay line (expect 32 bytes): " << error << ".\n";
+        LOG_TEXT(Replay, Error, std::string("Invalid replay line: ") + error + ".");
+        return false;
+    }
+    LOG_TEXT(Replay, Debug, "Replay frame version " + std::to_string(version) + ".");
+    packet = std::move(bytes);
+    return true;
+}
+
+void CLIApp::handleLog(const std::vector<std::string> &args)
+{
+    // log <level> [category]  或  log -f <file>  或  log -e  或  log rate x  或  log
+    auto &logger = Logger::instance();
+    if (args.size() == 1)
+    {
+        std::cout << "[Info] Log levels:";
+        for (size_t i = 0; i < static_cast<size_t>(Logger::Category::Count); ++i)
+        {
+            auto category = static_cast<Logger::Category>(i);
+            std::cout << " " << Logger::categoryName(category) << "=" << Logger::levelName(logger.getLevel(category));
+        }
+        std::string path = logger.getFilePath();
+        std::cout << "\n[Info] Log file: " << (path.empty() ? std::string("(none)") : path) << ", console limit "
+                  << logger.getConsoleRate() << " lines/s, " << logger.getSuppressed() << " suppressed, "
+                  << logger.getDropped() << " dropped.\n";
+        return;
+    }
+    if (args[1] == "-f" && args.size() == 3)
+    {
+        if (logger.openFile(args[2]))
+            std::cout << "[Info] Logging to '" << args[2] << "'.\n";
+        else
+            std::cout << "[Error] Failed to open log file: " << args[2] << "\n";
+        return;
+    }
+    if (args[1] == "-e" && args.size() == 2)
+    {
+        logger.closeFile();
+        std::cout << "[Info] Log file closed.\n";
+        return;
+    }
+    if (args[1] == "rate" && args.size() == 3)
+    {
+        int rate = -1;
+        try
+        {
+            rate = std::stoi(args[2]);
+        }
+        catch (...)
+        {
+        }
+        if (rate < 0)
+        {
+            std::cout << "[Error] Rate must be a non-negative number of lines per second.\n";
+            return;
+        }
+        logger.setConsoleRate(static_cast<unsigned>(rate));
+        std::cout << "[Info] Console log limit set to " << rate << " lines/s.\n";
+        return;
+    }
+
+    Logger::Level level;
+    if (!Logger::parseLevel(args[1], level) || args.size() > 3)
+    {
+        std::cout << "[Usage] log <trace|debug|info|warn|error|off> [category]  |  log -f <file>  |  log -e  |  log rate x\n";
+        return;
+    }
+    if (args.size() == 2)
+    {
+        logger.setLevel(level);
+        std::cout << "[Info] Log level set to " << Logger::levelName(level) << " for all categories.\n";
+        return;
+    }
+    Logger::Category category;
+    if (!Logger::parseCategory(args[2], category))
+    {
+        std::cout << "[Error] Unknown log category '" << args[2] << "' (general|serial|record|replay|command).\n";
+        return;
+    }
+    logger.setLevel(category, level);
+    std::cout << "[Info] Log level set to " << Logger::levelName(level) << " for " << args[2] << ".\n";
+}
+
+void CLIApp::handleProto(const std::vector<std::string> &args)
+{
+    // proto [8|8c|10|10c|12|12c]
+    if (args.size() == 1)
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        const auto &op = FrameProtocol::ops(wireFormat_);
+        std::cout << "[Info] Wire format " << op.name << " (" << op.bits << "-bit), "
+                  << op.packetSize(controller_.getLedCount()) << " bytes per frame.\n";
+        return;
+    }
+    FrameProtocol::Format format;
+    if (args.size() != 2 || !FrameProtocol::parseFormat(args[1], format))
+    {
+        std::cout << "[Usage] proto 8|8c|10|10c|12|12c\n";
+        return;
+    }
+    std::lock_guard<std::mutex> lock(sendMutex_);
+    wireFormat_ = format;
+    frameCounter_ = 0;
+    const auto &op = FrameProtocol::ops(format);
+    std::cout << "[Info] Wire format set to " << op.name << ", " << op.packetSize(controller_.getLedCount())
+              << " bytes per frame. Recordings keep the 8-bit form.\n";
+}
+
+bool CLIApp::sendCurrentFrame()
+{
+    std::vector<unsigned char> data;
+    uint64_t version = controller_.publish();
+    controller_.readFrame(data);
+    std::vector<unsigned char> packet;
+    FramePacket::build(data.data(), data.size(), packet);
+    return sendPacket(packet, version);
+}
+
+void CLIApp::handleTune(const std::vector<std::string> &args)
+{
+    // tune <target> <source> [iterations] [tolerance%]
+    if (args.size() < 3 || args.size() > 5)
+    {
+        std::cout << "[Usage] tune <target-file> <measurement-source> [iterations] [tolerance%]\n";
+        return;
+    }
+    int maxIterations = 20;
+    double tolerance = 0.01;
+    try
+    {
+        if (args.size() > 3)
+            maxIterations = std::stoi(args[3]);
+        if (args.size() > 4)
+            tolerance = std::stod(args[4]) / 100.0;
+    }
+    catch (...)
+    {
+        maxIterations = 0;
+    }
+    if (maxIterations <= 0 || tolerance <= 0)
+    {
+        std::cout << "[Usage] tune <target-file> <measurement-source> [iterations] [tolerance%]\n";
+        return;
+    }
+    if (!serial_.isOpen())
+    {
+        std::cout << "[Error] Serial port not open. Use setcom to set port.\n";
+        return;
+    }
+    std::vector<float> target;
+    if (!MeasurementSource::readFile(args[1], target))
+    {
+        std::cout << "[Error] Failed to read target values from " << args[1] << "\n";
+        return;
+    }
+    MeasurementSource source;
+    if (!source.open(args[2]))
+    {
+        std::cout << "[Error] Failed to open measurement source " << args[2] << "\n";
+        return;
+    }
+    const int timeoutMs = 5000;
+    using Clock = std::chrono::steady_clock;
+    auto ms = [](Clock::duration d)
+    { return std::chrono::duration<double, std::milli>(d).count(); };
+    auto tuneStart = Clock::now();
+
+    // 发送一帧并读取对应的测量值
+    std::vector<float> measured;
+    auto measure = [&](const char *what) -> bool
+    {
+        if (!sendCurrentFrame())
+        {
+            std::cout << "[Error] Failed to send data to serial port.\n";
+            return false;
+        }
+        if (!source.next(measured, timeoutMs))
+        {
+            std::cout << "[Error] No valid measurement from " << args[2] << " within " << timeoutMs / 1000 << " s ("
+                      << what << ").\n";
+            return false;
+        }
+        if (measured.size() != target.size())
+        {
+            std::cout << "[Error] Measurement has " << measured.size() << " values, target has " << target.size()
+                      << ".\n";
+            return false;
+        }
+        return true;
+    };
+
+    // 锁定、未注册的灯固定不动；其余在 [0, 上限] 内调节
+    const size_t channels = controller_.getLedCount();
+    IntensityOptimizer optimizer(target.size(), channels);
+    std::vector<float> x(channels);
+    std::vector<size_t> freeChannels;
+    for (size_t c = 0; c < channels; ++c)
+    {
+        const LED &led = controller_.getById(static_cast<int>(c + 1));
+        x[c] = led.getIntensity();
+        if (led.isLocked() || led.getPeakWavelength() == 0 || led.getMaxIntensity() == 0)
+            optimizer.setBounds(c, x[c], x[c]);
+        else
+        {
+            optimizer.setBounds(c, 0.0f, led.getMaxIntensity());
+            freeChannels.push_back(c);
+        }
+    }
+    if (freeChannels.empty())
+    {
+        std::cout << "[Error] All LEDs are locked; nothing to tune.\n";
+        return;
+    }
+
+    auto t0 = Clock::now();
+    if (!measure("initial frame"))
+        return;
+    auto residualPercent = [&](const std::vector<float> &y)
+    {
+        double r = 0, t = 0;
+        for (size_t i = 0; i < y.size(); ++i)
+        {
+            r += (target[i] - y[i]) * (target[i] - y[i]);
+            t += target[i] * target[i];
+        }
+        return t > 0 ? std::sqrt(r / t) * 100 : std::sqrt(r);
+    };
+    CoutFormatGuard format;
+    std::cout << std::fixed << std::setprecision(2) << "[Info] iter 0: residual " << residualPercent(measured)
+              << "%, send+measure " << ms(Clock::now() - t0) << " ms\n";
+
+    const SpectralModel &model = controller_.getSpectralModel();
+    if (target.size() == model.getPointCount())
+    {
+        // 测量值在模型波长网格上：直接用光谱模型作为初始雅可比
+        std::vector<float> jacobian(target.size() * channels);
+        for (size_t p = 0; p < target.size(); ++p)
+            for (size_t c = 0; c < channels; ++c)
+                jacobian[p * channels + c] = model.getWeight(p, c);
+        optimizer.setJacobian(jacobian);
+    }
+    else
+    {
+        // 其他仪器：逐灯差分探测得到初始雅可比
+        std::cout << "[Info] Readings are not on the spectral grid; probing " << freeChannels.size() << " LEDs.\n";
+        std::vector<float> base = measured;
+        std::vector<float> jacobian(target.size() * channels, 0.0f);
+        for (auto c : freeChannels)
+        {
+            LED &led = controller_.getById(static_cast<int>(c + 1));
+            const int delta = x[c] + 32 <= led.getMaxIntensity() ? 32 : -std::min<int>(32, static_cast<int>(x[c]));
+            if (delta == 0)
+                continue;
+            led.setIntensity(static_cast<unsigned char>(x[c] + delta));
+            bool ok = measure("probe");
+            led.setIntensity(static_cast<unsigned char>(x[c]));
+            if (!ok)
+                return;
+            for (size_t i = 0; i < target.size(); ++i)
+                jacobian[i * channels + c] = (measured[i] - base[i]) / delta;
+        }
+        optimizer.setJacobian(jacobian);
+        measured = base;
+    }
+
+    bool converged = false;
+    int iteration = 0, stalled = 0;
+    double lastBest = std::numeric_limits<double>::max();
+    std::vector<float> next;
+    while (true)
+    {
+        auto solveStart = Clock::now();
+        double residual = optimizer.step(x, measured, target, next);
+        double solveMs = ms(Clock::now() - solveStart);
+        if (residual <= tolerance)
+        {
+            converged = true;
+            break;
+        }
+        if (iteration >= maxIterations)
+            break;
+        // 连续 3 次没有改进最好结果（噪声或锁定的灯限制了精度）时停止
+        if (optimizer.getBestResidual() < lastBest * 0.999)
+        {
+            lastBest = optimizer.getBestResidual();
+            stalled = 0;
+        }
+        else if (++stalled >= 3)
+            break;
+
+        int changed = 0, maxDelta = 0;
+        for (size_t c = 0; c < channels; ++c)
+        {
+            const float v = std::round(next[c]);
+            const int delta = static_cast<int>(std::abs(v - x[c]));
+            if (delta != 0)
+            {
+                ++changed;
+                maxDelta = std::max(maxDelta, delta);
+            }
+            x[c] = v;
+        }
+        if (changed == 0)
+            break; // 量化后不再变化：已到整数强度能达到的最好结果
+        for (auto c : freeChannels)
+            controller_.getById(static_cast<int>(c + 1)).setIntensity(static_cast<unsigned char>(x[c]));
+
+        ++iteration;
+        t0 = Clock::now();
+        if (!measure("iteration"))
+            return;
+        std::cout << "[Info] iter " << iteration << ": residual " << residualPercent(measured) << "%, " << changed
+                  << " LEDs changed (max " << maxDelta << "), solve " << solveMs << " ms, send+measure "
+                  << ms(Clock::now() - t0) << " ms\n";
+    }
+
+    // 结束时停在最好的帧上
+    const auto &best = optimizer.getBest();
+    if (best != x)
+    {
+        for (auto c : freeChannels)
+            controller_.getById(static_cast<int>(c + 1)).setIntensity(static_cast<unsigned char>(best[c]));
+        if (!sendCurrentFrame())
+            std::cout << "[Error] Failed to send data to serial port.\n";
+    }
+    double targetNorm = 0;
+    for (auto t : target)
+        targetNorm += static_cast<double>(t) * t;
+    const double bestRelative =
+        targetNorm > 0 ? optimizer.getBestResidual() / std::sqrt(targetNorm) * 100 : optimizer.getBestResidual();
+    std::cout << "[Info] " << (converged ? "Converged" : "Stopped") << " after " << iteration << " iterations in "
+              << ms(Clock::now() - tuneStart) << " ms, best residual " << bestRelative << "%. Use 'ls' to view.\n";
+}
+
+void CLIApp::handleSeq(const std::vector<std::string> &args)
+{
+    // seq -s random <n> [--trigger src]  或  seq -s file <f> [--from n] [--to m] [--trigger src]  或  seq -e  或  seq -w  或  seq
+    const char *usage = "[Usage] seq -s random <count> [--trigger src]  |  seq -s file <f> [--from n] [--to m] "
+                        "[--trigger src]  |  seq -e  |  seq -w  |  seq\n";
+    auto printStats = [this]()
+    {
+        auto stats = sequencer_.getStats();
+        std::cout << "[Info] " << sequencer_.getPosition() << "/" << sequencer_.getFrameCount() << " frames, "
+                  << (sequencer_.isTriggered() ? "wake-up-to-write" : "deadline lateness") << " min "
+                  << std::fixed << std::setprecision(0) << stats.minUs << " / mean " << stats.meanUs << " / p99 "
+                  << stats.p99Us << " / max " << stats.maxUs << " us, " << stats.overruns
+                  << (sequencer_.isTriggered() ? " missed triggers, " : " overruns, ") << stats.errors << " errors.\n"
+                  << std::defaultfloat << std::setprecision(6);
+    };
+    if (args.size() == 1)
+    {
+        if (sequencer_.getFrameCount() == 0)
+        {
+            std::cout << "[Info] No sequence has been started.\n";
+            return;
+        }
+        if (sequencer_.isRunning())
+            std::cout << "[Info] Sequence running, "
+                      << (sequencer_.isTriggered() ? "triggered by '" + sequencer_.getTrigger() + "'"
+                                                   : "holding each frame " + std::to_string(sequencer_.getHoldTime()) + " us")
+                      << ".\n";
+        else
+            std::cout << "[Info] Sequence finished.\n";
+        printStats();
+        return;
+    }
+    if (args[1] == "-e" && args.size() == 2)
+    {
+        if (!sequencer_.isRunning())
+        {
+            std::cout << "[Info] Sequence is not running.\n";
+            return;
+        }
+        sequencer_.stop();
+        std::cout << "[Info] Sequence stopped.\n";
+        printStats();
+        return;
+    }
+    if (args[1] == "-w" && args.size() == 2)
+    {
+        if (!sequencer_.isRunning())
+        {
+            std::cout << "[Info] Sequence is not running.\n";
+            return;
+        }
+        if (sequencer_.isTriggered())
+        {
+            std::cout << "[Error] A triggered sequence ends only with its triggers or 'seq -e'.\n";
+            return;
+        }
+        while (sequencer_.isRunning())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::cout << "[Info] Sequence finished.\n";
+        printStats();
+        return;
+    }
+    if (args[1] != "-s" || args.size() < 4 || (args[2] != "random" && args[2] != "file"))
+    {
+        std::cout << usage;
+        return;
+    }
+
+    std::string trigger;
+    uint64_t from = 0, to = std::numeric_limits<uint64_t>::max();
+    size_t count = 0;
+    try
+    {
+        if (args[2] == "random")
+            count = std::stoul(args[3]);
+        for (size_t i = 4; i < args.size(); ++i)
+        {
+            if (args[i] == "--trigger" && i + 1 < args.size())
+                trigger = args[++i];
+            else if (args[2] == "file" && args[i] == "--from" && i + 1 < args.size())
+                from = std::stoull(args[++i]);
+            else if (args[2] == "file" && args[i] == "--to" && i + 1 < args.size())
+                to = std::stoull(args[++i]);
+            else
+                throw std::invalid_argument(args[i]);
+        }
+    }
+    catch (...)
+    {
+        std::cout << usage;
+        return;
+    }
+    if (!serial_.isOpen())
+    {
+        std::cout << "[Error] Serial port not open. Use setcom to set port.\n";
+        return;
+    }
+    if (sequencer_.isRunning())
+    {
+        std::cout << "[Error] A sequence is already running. Use 'seq -e' first.\n";
+        return;
+    }
+
+    // 所有帧在启动前打包好，后台线程只做 等待 -> 写出
+    const size_t packetSize = FramePacket::kHeaderSize + controller_.getLedCount();
+    std::vector<unsigned char> packets;
+    std::vector<uint64_t> versions;
+    if (args[2] == "random")
+    {
+        if (count == 0)
+        {
+            std::cout << "[Error] Frame count must be positive.\n";
+            return;
+        }
+        std::vector<unsigned char> frames(count * controller_.getLedCount());
+        bool withinBudget = true;
+        for (size_t i = 0; i < count; ++i)
+            withinBudget &= controller_.generateRandomFrame(seqRng_, frames.data() + i * controller_.getLedCount());
+        if (!withinBudget)
+            std::cout << "[Warning] Power budget too small for locked LEDs and minimums.\n";
+        auto calibration = controller_.getCalibration();
+        FramePacket::buildBatch(frames.data(), count, controller_.getLedCount(), calibration.get(), packets);
+    }
+    else
+    {
+        if (from > to)
+        {
+            std::cout << "[Error] --from must not be after --to.\n";
+            return;
+        }
+        if (!loadRecording(args[3], from, to, packets, versions))
+            return;
+    }
+
+    const uint32_t holdUs = controller_.getIntegrationTime() + controller_.getSettleTime();
+    auto onSend = [this, command = t_command](const unsigned char *packet, size_t size, uint64_t version)
+    {
+        t_command = command;
+        return sendPacket(packet, size, version);
+    };
+    const size_t frames = packets.size() / packetSize;
+    if (!sequencer_.start(std::move(packets), packetSize, std::move(versions), trigger, holdUs, onSend))
+    {
+        std::cout << "[Error] Failed to open trigger source: " << trigger << "\n";
+        return;
+    }
+    if (trigger.empty())
+        std::cout << "[Info] Sequence of " << frames << " frames started, each held " << holdUs << " us ("
+                  << controller_.getIntegrationTime() << " integration + " << controller_.getSettleTime()
+                  << " settle).\n";
+    else
+        std::cout << "[Info] Sequence of " << frames << " frames started, waiting for triggers on '" << trigger
+                  << "'.\n";
+    // 虚拟时钟下定时序列在命令内跑完：后台线程与之后的命令共用一条时间线，并行推进会失去可重复性
+    if (trigger.empty() && clock_.isVirtual())
+    {
+        while (sequencer_.isRunning())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::cout << "[Info] Sequence finished in simulated time.\n";
+        printStats();
+    }
+}
+
+bool CLIApp::loadRecording(const std::string &path, uint64_t from, uint64_t to, std::vector<unsigned char> &packets,
+                           std::vector<uint64_t> &versions)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cout << "[Error] Failed to open recording: " << path << "\n";
+        return false;
+    }
+    // 与 replay 相同：帧号从 0 开始，区间含两端，录制中已是校准后的数据
+    std::string line;
+    std::vector<unsigned char> bytes(RecordingFormat::kPacketSize);
+    for (uint64_t index = 0; index <= to && std::getline(file, line); ++index)
+    {
+        if (index < from)
+            continue;
+        uint64_t version = 0;
+        const char *error = nullptr;
+        if (!RecordingFormat::parseLine(line.data(), line.data() + line.size(), bytes.data(), version, error))
+        {
+            std::cout << "[Error] Invalid recording line " << index << " (expect 32 bytes): " << error
+                      << ". Binary recordings must be converted with 'convert -r' first.\n";
+            return false;
+        }
+        packets.insert(packets.end(), bytes.begin(), bytes.end());
+        versions.push_back(version);
+    }
+    if (versions.empty())
+    {
+        std::cout << "[Error] No frames in the selected range.\n";
+        return false;
+    }
+    return true;
+}
+
+void CLIApp::handleInteg(const std::vector<std::string> &args)
+{
+    // integ [us] [settle]：积分时间随 save/load 写入配置文件
+    if (args.size() > 3)
+    {
+        std::cout << "[Usage] integ [integration us] [settle us]\n";
+        return;
+    }
+    if (args.size() >= 2)
+    {
+        try
+        {
+            unsigned long integration = std::stoul(args[1]);
+            unsigned long settle = args.size() == 3 ? std::stoul(args[2]) : controller_.getSettleTime();
+            if (integration == 0 || integration > 60000000 || settle > 60000000)
+                throw std::out_of_range(args[1]);
+            controller_.setIntegrationTime(static_cast<uint32_t>(integration));
+            controller_.setSettleTime(static_cast<uint32_t>(settle));
+        }
+        catch (...)
+        {
+            std::cout << "[Error] Times must be in us, integration 1-60000000, settle 0-60000000.\n";
+            return;
+        }
+    }
+    std::cout << "[Info] Integration time " << controller_.getIntegrationTime() << " us, settle time "
+              << controller_.getSettleTime() << " us, frame hold "
+              << controller_.getIntegrationTime() + controller_.getSettleTime() << " us.\n";
+}
+
+void CLIApp::handleTrace(const std::vector<std::string> &args)
+{
+    // trace -s [file]  或  trace -e  或  trace
+    auto &tracer = Tracer::instance();
+    if (args.size() == 1)
+    {
+        if (tracer.isEnabled())
+            std::cout << "[Info] Tracing to '" << traceFile_ << "', " << tracer.getEventCount() << " spans, "
+                      << tracer.getDropped() << " dropped.\n";
+        else
+            std::cout << "[Info] Not tracing.\n";
+        return;
+    }
+    if (args[1] == "-s" && args.size() <= 3)
+    {
+        traceFile_ = args.size() == 3 ? args[2] : "trace.json";
+        tracer.start();
+        std::cout << "[Info] Tracing started, use 'trace -e' to write '" << traceFile_ << "'.\n";
+    }
+    else if (args[1] == "-e" && args.size() == 2)
+    {
+        if (!tracer.isEnabled())
+        {
+            std::cout << "[Info] Tracing has not been started. Use 'trace -s [file]'.\n";
+            return;
+        }
+        if (!tracer.stop(traceFile_))
+        {
+            std::cout << "[Error] Failed to write trace file: " << traceFile_ << "\n";
+            return;
+        }
+        std::cout << "[Info] " << tracer.getEventCount() << " spans written to '" << traceFile_ << "'";
+        if (tracer.getDropped() > 0)
+            std::cout << " (" << tracer.getDropped() << " dropped, per-thread buffer full)";
+        std::cout << ". Open it in chrome://tracing or ui.perfetto.dev.\n";
+    }
+    else
+    {
+        std::cout << "[Error] Usage: trace -s [filename]  |  trace -e  |  trace\n";
+    }
+}
+
+void CLIApp::handleCo(const std::vector<std::string> &args)
+{
+    // co ramp|pulse|replay ...  或  co -e  或  co
+    const char *usage = "[Usage] co ramp l<x> <from> <to> <ms> [step ms]  |  co pulse l<x> <value> <on ms> <off ms> "
+                        "[count]  |  co replay <f> <period ms> [loops]  |  co -e  |  co\n";
+    if (args.size() == 1)
+    {
+        if (!coroutines_.isRunning())
+        {
+            std::cout << "[Info] No co sequences running.\n";
+            return;
+        }
+        auto stats = coroutines_.getStats();
+        std::cout << "[Info] " << coroutines_.getActiveCount() << " of " << coSpawned_ << " co sequences running, "
+                  << stats.sends << " frames sent (" << stats.sendErrors << " failed), timer lateness mean "
+                  << std::fixed << std::setprecision(1) << stats.meanUs << " / p50 " << stats.p50Us << " / p99 "
+                  << stats.p99Us << " / max " << stats.maxUs << " us.\n"
+                  << std::defaultfloat << std::setprecision(6);
+        return;
+    }
+    if (args[1] == "-e" && args.size() == 2)
+    {
+        if (!coroutines_.isRunning())
+        {
+            std::cout << "[Info] No co sequences running.\n";
+            return;
+        }
+        coroutines_.stop();
+        overlay_.reset();
+        coSpawned_ = 0;
+        // 序列覆盖的通道回到已发布帧
+        if (!sendCurrentFrame())
+            std::cout << "[Warning] Failed to resend the published frame.\n";
+        std::cout << "[Info] All co sequences stopped.\n";
+        return;
+    }
+
+    auto parseChannel = [this](const std::string &arg, size_t &channel)
+    {
+        if (arg.size() < 2 || arg[0] != 'l')
+            return false;
+        try
+        {
+            channel = static_cast<size_t>(controller_.getById(std::stoi(arg.substr(1))).getId() - 1);
+            return true;
+        }
+        catch (...)
+        {
+            return false;
+        }
+    };
+    auto number = [](const std::string &arg, unsigned limit)
+    {
+        unsigned long v = std::stoul(arg);
+        if (v > limit)
+            throw std::out_of_range(arg);
+        return static_cast<unsigned>(v);
+    };
+
+    if (!serial_.isOpen())
+    {
+        std::cout << "[Error] Serial port not open. Use setcom to set port.\n";
+        return;
+    }
+    if (!coroutines_.isRunning())
+    {
+        // 所有序列共用一个事件循环线程，发送在独立线程完成
+        auto onSend = [this, command = t_command](const unsigned char *packet, size_t size)
+        {
+            t_command = command;
+            return sendPacket(packet, size, 0);
+        };
+        if (!coroutines_.start(onSend))
+        {
+            std::cout << "[Error] Failed to start the coroutine executor.\n";
+            return;
+        }
+        overlay_ = std::make_shared<SequenceOverlay>(controller_.getLedCount());
+    }
+
+    try
+    {
+        size_t channel = 0;
+        if (args[1] == "ramp" && (args.size() == 6 || args.size() == 7) && parseChannel(args[2], channel))
+        {
+            unsigned from = number(args[3], 255), to = number(args[4], 255), ms = number(args[5], 86400000);
+            unsigned step = args.size() == 7 ? number(args[6], 60000) : 10;
+            coroutines_.spawn(LightSequences::ramp(coroutines_, controller_, overlay_, channel, static_cast<int>(from),
+                                                   static_cast<int>(to), ms, std::max(1u, step)));
+            std::cout << "[Info] Ramp on LED #" << channel + 1 << " from " << from << " to " << to << " over " << ms
+                      << " ms started.\n";
+        }
+        else if (args[1] == "pulse" && (args.size() == 6 || args.size() == 7) && parseChannel(args[2], channel))
+        {
+            unsigned value = number(args[3], 255), on = number(args[4], 86400000), off = number(args[5], 86400000);
+            unsigned count = args.size() == 7 ? number(args[6], 100000000) : 0;
+            if (on + off == 0)
+                throw std::out_of_range(args[4]);
+            coroutines_.spawn(LightSequences::pulse(coroutines_, controller_, overlay_, channel, static_cast<int>(value),
+                                                    on, off, count));
+            std::cout << "[Info] Pulse train on LED #" << channel + 1 << " (" << on << " ms on / " << off
+                      << " ms off, " << (count ? std::to_string(count) : std::string("endless")) << ") started.\n";
+        }
+        else if (args[1] == "replay" && (args.size() == 4 || args.size() == 5))
+        {
+            unsigned period = number(args[3], 86400000), loops = args.size() == 5 ? number(args[4], 100000000) : 1;
+            if (period == 0)
+                throw std::out_of_range(args[3]);
+            std::vector<unsigned char> packets;
+            std::vector<uint64_t> versions;
+            if (!loadRecording(args[2], 0, std::numeric_limits<uint64_t>::max(), packets, versions))
+                return;
+            coroutines_.spawn(LightSequences::replay(coroutines_, std::move(packets), RecordingFormat::kPacketSize,
+                                                     period, loops));
+            std::cout << "[Info] Replay of " << versions.size() << " frames every " << period << " ms started.\n";
+        }
+        else
+        {
+            std::cout << usage;
+            return;
+        }
+        ++coSpawned_;
+    }
+    catch (...)
+    {
+        std::cout << usage;
+    }
+}
+
+bool CLIApp::selectLeds(const std::string &selector, ChannelMask &mask)
+{
+    ChannelSelector compiled;
+    std::string error;
+    if (!compiled.compile(selector, controller_, selectors_, error))
+    {
+        std::cout << "[Error] Invalid selector '" << selector << "': " << error << ".\n";
+        return false;
+    }
+    mask = compiled.evaluate(controller_);
+    return true;
+}
+
+void CLIApp::applyBulk(const std::string &selector, LEDController::BulkOp op, float a, float b,
+                       const std::string &what)
+{
+    ChannelMask mask = 0;
+    if (!selectLeds(selector, mask))
+        return;
+    const size_t changed = controller_.applyMasked(mask, op, a, b);
+    std::cout << "[Info] " << std::popcount(mask) << " LEDs selected by '" << selector << "', " << changed << " "
+              << what << ".\n";
+}
+
+void CLIApp::handleSel(const std::vector<std::string> &args)
+{
+    // sel  或  sel <name> <selector>  或  sel -d <name>  或  sel ? <selector>
+    if (args.size() == 1)
+    {
+        if (selectors_.empty())
+        {
+            std::cout << "[Info] No named selectors. Use 'sel <name> <selector>'.\n";
+            return;
+        }
+        for (const auto &entry : selectors_)
+            std::cout << "  @" << entry.first << " = " << entry.second.getText() << " ("
+                      << std::popcount(entry.second.evaluate(controller_)) << " LEDs)\n";
+        return;
+    }
+    if (args.size() < 3)
+    {
+        std::cout << "[Usage] sel <name> <selector>  |  sel -d <name>  |  sel ? <selector>  |  sel\n";
+        return;
+    }
+    // 选择器不含空格，多个参数直接拼接
+    std::string expression;
+    for (size_t i = 2; i < args.size(); ++i)
+        expression += args[i];
+
+    if (args[1] == "-d")
+    {
+        if (selectors_.erase(expression))
+            std::cout << "[Info] Selector @" << expression << " deleted.\n";
+        else
+            std::cout << "[Error] No selector named @" << expression << ".\n";
+        return;
+    }
+    if (args[1] == "?")
+    {
+        ChannelMask mask = 0;
+        if (!selectLeds(expression, mask))
+            return;
+        std::cout << "[Info] " << std::popcount(mask) << " LEDs:";
+        for (size_t i = 0; i < controller_.getLedCount(); ++i)
+            if (mask >> i & 1)
+                std::cout << " l" << controller_.getByIndex(i).getId();
+        std::cout << "\n";
+        return;
+    }
+    const std::string &name = args[1];
+    if (name.empty() || name.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_") !=
+                            std::string::npos)
+    {
+        std::cout << "[Error] Selector names may contain letters, digits and '_'.\n";
+        return;
+    }
+    ChannelSelector selector;
+    std::string error;
+    if (!selector.compile(expression, controller_, selectors_, error))
+    {
+        std::cout << "[Error] Invalid selector '" << expression << "': " << error << ".\n";
+        return;
+    }
+    const int count = std::popcount(selector.evaluate(controller_));
+    selectors_[name] = std::move(selector);
+    std::cout << "[Info] @" << name << " = " << expression << " (" << count << " LEDs now).\n";
+}
+
+void CLIApp::handleOp(const std::vector<std::string> &args)
+{
+    // op <selector> <operation> [a] [b]
+    using Op = LEDController::BulkOp;
+    static const struct
+    {
+        const char *name;
+        Op op;
+        size_t values;
+        const char *what;
+    } operations[] = {
+        {"set", Op::Set, 1, "intensity set"},
+        {"scale", Op::Scale, 1, "intensity scaled"},
+        {"add", Op::Add, 1, "intensity changed"},
+        {"clamp", Op::Clamp, 2, "intensity clamped"},
+        {"setm", Op::SetMax, 1, "max intensity set"},
+        {"setmin", Op::SetMin, 1, "min intensity set"},
+        {"lock", Op::Lock, 0, "locked"},
+        {"unlock", Op::Unlock, 0, "unlocked"},
+        {"random", Op::Randomize, 0, "intensity randomized"},
+    };
+    if (args.size() >= 3)
+    {
+        for (const auto &operation : operations)
+        {
+            if (args[2] != operation.name || args.size() != 3 + operation.values)
+                continue;
+            float a = 0, b = 0;
+            try
+            {
+                if (operation.values > 0)
+                    a = std::stof(args[3]);
+                if (operation.values > 1)
+                    b = std::stof(args[4]);
+            }
+            catch (...)
+            {
+                break;
+            }
+            applyBulk(args[1], operation.op, a, b, operation.what);
+            return;
+        }
+    }
+    std::cout << "[Usage] op <selector> set <v> | scale <f> | add <d> | clamp <lo> <hi> | setm <v> | setmin <v> | lock | "
+                 "unlock | random\n";
+}
+
+void CLIApp::handleJournal(const std::vector<std::string> &args)
+{
+    // journal  或  journal snap
+    if (!journal_.isOpen())
+    {
+        std::cout << "[Error] State journal is not open.\n";
+        return;
+    }
+    if (args.size() == 2 && args[1] == "snap")
+    {
+        journal_.snapshot(controller_);
+        std::cout << "[Info] Journal compacted into snapshot #" << journal_.getSequence() << ".\n";
+        return;
+    }
+    if (args.size() != 1)
+    {
+        std::cout << "[Usage] journal  |  journal snap\n";
+        return;
+    }
+    std::cout << "[Info] Journal '" << journal_.getPath() << "': sequence " << journal_.getSequence() << ", "
+              << journal_.getRecordsInLog() << " changes since the last snapshot, " << journal_.getSnapshotCount()
+              << " snapshots this session, startup took " << std::fixed << std::setprecision(2) << recoveryMs_
+              << " ms.\n"
+              << std::defaultfloat << std::setprecision(6);
+}
+
+void CLIApp::releaseLockedDither()
+{
+    const auto targets = dither_.getTargets();
+    const ChannelMask locked = controller_.getLockedMask();
+    size_t released = 0;
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        if (targets[i] >= 0 && (locked >> i & 1))
+        {
+            dither_.setTarget(i, -1);
+            ++released;
+        }
+    }
+    if (released)
+        std::cout << "[Info] Dithering stopped on " << released << " locked LEDs.\n";
+}
+
+void CLIApp::handleDither(const std::vector<std::string> &args)
+{
+    // dither <sel> <level>  或  dither off [sel]  或  dither
+    if (args.size() >= 2 && args[1] == "off" && args.size() <= 3)
+    {
+        if (args.size() == 2)
+        {
+            dither_.clear();
+            std::cout << "[Info] Dithering off for all LEDs.\n";
+            return;
+        }
+        ChannelMask mask = 0;
+        if (!selectLeds(args[2], mask))
+            return;
+        for (size_t i = 0; i < controller_.getLedCount(); ++i)
+            if (mask & (ChannelMask{1} << i))
+                dither_.setTarget(i, -1);
+        std::cout << "[Info] Dithering off for " << std::popcount(mask) << " LEDs.\n";
+        return;
+    }
+    if (args.size() == 3)
+    {
+        float level = 0;
+        try
+        {
+            level = std::stof(args[2]);
+        }
+        catch (...)
+        {
+            level = -1;
+        }
+        if (level < 0 || level > 255)
+        {
+            std::cout << "[Error] Dither level must be 0-255.\n";
+            return;
+        }
+        ChannelMask mask = 0;
+        if (!selectLeds(args[1], mask))
+            return;
+        // 与 set 一样，锁定的灯不被改变
+        const ChannelMask locked = mask & controller_.getLockedMask();
+        mask &= ~locked;
+        for (size_t i = 0; i < controller_.getLedCount(); ++i)
+            if (mask & (ChannelMask{1} << i))
+                dither_.setTarget(i, level);
+        std::cout << "[Info] " << std::popcount(mask) << " LEDs dithered to level " << level << ".\n";
+        if (locked)
+            std::cout << "[Warning] " << std::popcount(locked) << " locked LEDs skipped.\n";
+        if (!isStreaming_)
+            std::cout << "[Warning] Dithering only applies to streamed frames. Use 'stream -s [hz]'.\n";
+        return;
+    }
+    if (args.size() != 1)
+    {
+        std::cout << "[Usage] dither <sel> <level>  |  dither off [sel]  |  dither\n";
+        return;
+    }
+
+    if (!dither_.isActive())
+    {
+        std::cout << "[Info] No LEDs are dithered.\n";
+        return;
+    }
+    std::cout << std::fixed << std::setprecision(3);
+    const auto stats = dither_.getStats();
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        const auto &s = stats[i];
+        if (s.target < 0)
+            continue;
+        std::cout << "  LED " << controller_.getByIndex(i).getId() << ": target " << s.target;
+        if (s.frames == 0)
+            std::cout << ", no frames sent yet\n";
+        else
+            std::cout << ", mean " << s.mean << " (error " << s.mean - s.target << "), ripple " << s.ripple
+                      << " rms, levels " << int(s.lo) << "-" << int(s.hi) << ", " << s.frames << " frames\n";
+    }
+    std::cout << std::defaultfloat << std::setprecision(6);
+    if (!isStreaming_)
+    {
+        std::cout << "[Info] Not streaming; dithering is paused.\n";
+        return;
+    }
+    const uint64_t frames = streamFrames_.load() + streamErrors_.load();
+    const double meanMs = frames ? streamIntervalSumUs_.load() / 1000.0 / static_cast<double>(frames) : 0;
+    std::cout << "[Info] Streaming at " << streamHz_ << " Hz: mean frame interval " << std::fixed
+              << std::setprecision(3) << meanMs << " ms (nominal " << 1000.0 / streamHz_ << "), max "
+              << streamIntervalMaxUs_.load() / 1000.0 << " ms, " << streamErrors_.load() << " errors.\n"
+              << std::defaultfloat << std::setprecision(6);
+}
+
+void CLIApp::handleSampler(const std::vector<std::string> &args)
+{
+    // sampler sobol|halton [seed] [--at n]  或  sampler resume <f>  或  sampler uniform  或  sampler
+    const char *usage = "[Usage] sampler sobol|halton [seed] [--at n]  |  sampler resume <f>  |  sampler uniform  |  "
+                        "sampler\n";
+    if (args.size() == 1)
+    {
+        const auto *sequence = controller_.getSequence();
+        if (!sequence)
+        {
+            std::cout << "[Info] Random frames: independent uniform draws.\n";
+            return;
+        }
+        size_t dims = 0;
+        for (size_t i = 0; i < controller_.getLedCount(); ++i)
+            dims += controller_.getByIndex(i).getPeakWavelength() != 0 && !controller_.getByIndex(i).isLocked();
+        std::cout << "[Info] Random frames: " << LowDiscrepancySequence::name(sequence->getKind()) << " sequence, seed "
+                  << sequence->getSeed() << ", next index " << sequence->index() << ", " << dims
+                  << " dimensions (unlocked LEDs).\n";
+        return;
+    }
+    if (args[1] == "uniform" && args.size() == 2)
+    {
+        controller_.clearSequence();
+        std::cout << "[Info] Random frames: independent uniform draws.\n";
+        return;
+    }
+
+    LowDiscrepancySequence::Kind kind{};
+    uint32_t seed = 0;
+    uint64_t index = 0;
+    if (args[1] == "resume" && args.size() == 3)
+    {
+        // 找到记录里最后一个带采样标记的帧
+        std::ifstream file(args[2]);
+        if (!file.is_open())
+        {
+            std::cout << "[Error] Cannot open recording: " << args[2] << "\n";
+            return;
+        }
+        std::string line;
+        std::vector<unsigned char> bytes(RecordingFormat::kPacketSize);
+        bool found = false;
+        uint64_t lineNo = 0;
+        while (std::getline(file, line))
+        {
+            ++lineNo;
+            uint64_t version = 0;
+            const char *error = nullptr;
+            RecordingFormat::SampleTag tag{};
+            bool hasTag = false;
+            if (!RecordingFormat::parseLine(line.data(), line.data() + line.size(), bytes.data(), version, error, &tag,
+                                            &hasTag))
+            {
+                std::cout << "[Error] " << args[2] << ":" << lineNo << ": " << error << ".\n";
+                return;
+            }
+            if (hasTag)
+            {
+                kind = tag.kind;
+                seed = tag.seed;
+                index = tag.index + 1;
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            std::cout << "[Error] No sampled frames in '" << args[2] << "'.\n";
+            return;
+        }
+    }
+    else
+    {
+        if (!LowDiscrepancySequence::parse(args[1], kind))
+        {
+            std::cout << usage;
+            return;
+        }
+        seed = std::random_device{}();
+        size_t i = 2;
+        try
+        {
+            if (i < args.size() && args[i] != "--at")
+                seed = static_cast<uint32_t>(std::stoul(args[i++]));
+            if (i + 1 < args.size() && args[i] == "--at")
+            {
+                index = std::stoull(args[i + 1]);
+                i += 2;
+            }
+        }
+        catch (...)
+        {
+            std::cout << "[Error] Seed and index must be non-negative numbers.\n";
+            return;
+        }
+        if (i != args.size())
+        {
+            std::cout << usage;
+            return;
+        }
+    }
+    controller_.setSequence(kind, seed, index);
+    std::cout << "[Info] Random frames: " << LowDiscrepancySequence::name(kind) << " sequence, seed " << seed
+              << ", starting at index " << index << ".\n";
+}
+
+void CLIApp::handleBlackbox(const std::vector<std::string> &args)
+{
+    // blackbox  或  blackbox dump [f]
+    if (args.size() == 1)
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        const uint64_t recorded = blackbox_.getRecorded();
+        std::cout << "[Info] Black box holds the last " << std::min<uint64_t>(recorded, blackbox_.getCapacity())
+                  << " of " << recorded << " sent frames (capacity " << blackbox_.getCapacity()
+                  << "). Dumps to '" << blackboxErrorFile_ << "' on send errors and to '" << blackboxCrashFile_
+                  << "' on a crash.\n";
+        return;
+    }
+    if (args[1] != "dump" || args.size() > 3)
+    {
+        std::cout << "[Usage] blackbox  |  blackbox dump [f]\n";
+        return;
+    }
+    const std::string path = args.size() == 3 ? args[2] : blackboxFile_;
+    std::vector<FlightRecorder::Frame> frames;
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        frames = blackbox_.snapshot();
+    }
+    std::string error;
+    if (!blackbox_.dump(frames, path, error))
+    {
+        std::cout << "[Error] Black box dump failed: " << error << ".\n";
+        return;
+    }
+    std::cout << "[Info] " << frames.size() << " frames written to '" << path << "'. Use 'replay -s " << path
+              << "' to replay them.\n";
+}
+
+void CLIApp::handleClock(const std::vector<std::string> &args)
+{
+    // clock  或  clock +<ms>
+    const double nowS = std::chrono::duration<double>(clock_.now().time_since_epoch()).count();
+    if (args.size() == 1)
+    {
+        if (clock_.isVirtual())
+            std::cout << "[Info] Virtual clock at " << std::fixed << std::setprecision(6) << nowS
+                      << " s; do, seq and black box timestamps run in simulated time.\n"
+                      << std::defaultfloat << std::setprecision(6);
+        else
+            std::cout << "[Info] System clock. Start with --virtual-clock to run timed commands in simulated time.\n";
+        return;
+    }
+    if (args.size() != 2 || args[1].size() < 2 || args[1][0] != '+')
+    {
+        std::cout << "[Usage] clock  |  clock +<ms>\n";
+        return;
+    }
+    if (!clock_.isVirtual())
+    {
+        std::cout << "[Error] Only the virtual clock can be advanced.\n";
+        return;
+    }
+    double ms = -1;
+    try
+    {
+        ms = std::stod(args[1].substr(1));
+    }
+    catch (...)
+    {
+    }
+    if (ms < 0)
+    {
+        std::cout << "[Error] Advance must be a non-negative number of milliseconds.\n";
+        return;
+    }
+    static_cast<VirtualClock &>(clock_).advance(
+        std::chrono::duration_cast<Clock::Duration>(std::chrono::duration<double, std::milli>(ms)));
+    std::cout << "[Info] Virtual clock at " << std::fixed << std::setprecision(6)
+              << std::chrono::duration<double>(clock_.now().time_since_epoch()).count() << " s.\n"
+              << std::defaultfloat << std::setprecision(6);
+}
+
+void CLIApp::handleSeed(const std::vector<std::string> &args)
+{
+    // seed <n>
+    if (args.size() != 2)
+    {
+        std::cout << "[Usage] seed <n>\n";
+        return;
+    }
+    uint32_t seed = 0;
+    try
+    {
+        seed = static_cast<uint32_t>(std::stoul(args[1]));
+    }
+    catch (...)
+    {
+        std::cout << "[Error] Seed must be a non-negative number.\n";
+        return;
+    }
+    controller_.seedRandom(seed);
+    seqRng_.seed(seed);
+    std::cout << "[Info] Random generator seeded with " << seed << ".\n";
+}
+
+void CLIApp::startWatcher()
+{
+    const std::string config = configFile_;
+    const std::string calib = calibFile_;
+    auto onChange = [this, config, calib](const std::string &path)
+    {
+        Tracer::instance().setThreadName("watcher");
+        std::string message;
+        if (!stageReload(path == calib && path != config, path, message))
+            LOG_TEXT(General, Warn, message);
+    };
+    // 命令执行中（do、tune、seq…）由命令在帧边界或结束后应用；空闲时在这里应用，
+    // 每个周期只尝试一次，不阻塞监视线程
+    auto onTick = [this]()
+    {
+        if (!reloadPending_.load(std::memory_order_acquire) || !commandMutex_.try_lock())
+            return;
+        std::lock_guard<std::timed_mutex> lock(commandMutex_, std::adopt_lock);
+        applyPendingReload();
+    };
+    watcher_.start({config, calib}, onChange, 200, onTick);
+}
+
+bool CLIApp::stageReload(bool calibration, const std::string &path, std::string &message)
+{
+    // 只读取固定的 LED 表（id、辐射量），可在监视线程上解析
+    std::shared_ptr<const LEDController::Limits> limits;
+    std::shared_ptr<const Calibration> tables;
+    if (calibration)
+    {
+        std::string error;
+        tables = controller_.parseCalibration(path, error);
+        if (!tables)
+            message = error.empty() ? "Cannot open '" + path + "'" : "Rejected " + error;
+    }
+    else
+    {
+        auto parsed = std::make_shared<LEDController::Limits>();
+        std::vector<std::string> warnings;
+        if (!controller_.parseMaxIntensities(path, *parsed, warnings))
+            message = "Cannot open '" + path + "'";
+        else if (!warnings.empty())
+            message = "Rejected " + path + ": " + warnings.front() +
+                      (warnings.size() > 1 ? " (+" + std::to_string(warnings.size() - 1) + " more)" : "");
+        else
+            limits = std::move(parsed);
+    }
+
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    if (!limits && !tables)
+    {
+        message += "; keeping the current " + std::string(calibration ? "calibration" : "limits") + ".";
+        lastReload_ = message;
+        ++reloadsRejected_;
+        return false;
+    }
+    if (limits)
+        pendingLimits_ = std::move(limits);
+    else
+        pendingCalibration_ = std::move(tables);
+    reloadPending_ = true;
+    return true;
+}
+
+void CLIApp::applyPendingReload()
+{
+    if (!reloadPending_.load(std::memory_order_acquire))
+        return;
+    std::shared_ptr<const LEDController::Limits> limits;
+    std::shared_ptr<const Calibration> calibration;
+    {
+        std::lock_guard<std::mutex> lock(reloadMutex_);
+        reloadPending_ = false;
+        limits = std::move(pendingLimits_);
+        calibration = std::move(pendingCalibration_);
+    }
+    if (!limits && !calibration)
+        return;
+    if (limits)
+        controller_.applyLimits(*limits);
+    if (calibration)
+        controller_.setCalibration(calibration);
+    // 重新发布当前帧，流式发送从下一帧起使用新的校准表
+    controller_.publish();
+    journal_.capture(controller_);
+    ++reloadsApplied_;
+
+    std::string message = "Reloaded";
+    if (limits)
+        message += " " + std::to_string(limits->maxIntensity.size()) + " max intensities" +
+                   (limits->hasIntegrationTime ? " and integration time" : "");
+    if (limits && calibration)
+        message += ",";
+    if (calibration)
+        message += " calibration";
+    message += ".";
+    LOG_TEXT(General, Info, message);
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    lastReload_ = message;
+}
+
+void CLIApp::handleReload(const std::vector<std::string> &args)
+{
+    // reload  或  reload now [config|calib]  或  reload -s  或  reload -e
+    if (args.size() == 1)
+    {
+        if (watcher_.isRunning())
+        {
+            std::cout << "[Info] Watching '" << configFile_ << "' and '" << calibFile_ << "'";
+            if (watcher_.getPolledCount() > 0)
+                std::cout << " (" << watcher_.getPolledCount() << " by polling)";
+            std::cout << ".\n";
+        }
+        else
+        {
+            std::cout << "[Info] Not watching config files. Use 'reload -s'.\n";
+        }
+        std::lock_guard<std::mutex> lock(reloadMutex_);
+        std::cout << "[Info] " << reloadsApplied_.load() << " reloads applied, " << reloadsRejected_.load()
+                  << " rejected." << (lastReload_.empty() ? "" : " Last: " + lastReload_) << "\n";
+        return;
+    }
+    if (args[1] == "now" && args.size() <= 3)
+    {
+        const bool config = args.size() == 2 || args[2] == "config";
+        const bool calib = args.size() == 2 || args[2] == "calib";
+        if (!config && !calib)
+        {
+            std::cout << "[Usage] reload now [config|calib]\n";
+            return;
+        }
+        std::string message;
+        if (config && !stageReload(false, configFile_, message))
+            std::cout << "[Error] " << message << "\n";
+        if (calib && !stageReload(true, calibFile_, message))
+            std::cout << "[Error] " << message << "\n";
+        if (!reloadPending_)
+            return;
+        applyPendingReload();
+        std::lock_guard<std::mutex> lock(reloadMutex_);
+        std::cout << "[Info] " << lastReload_ << "\n";
+    }
+    else if (args[1] == "-s" && args.size() == 2)
+    {
+        startWatcher();
+        std::cout << "[Info] Watching '" << configFile_ << "' and '" << calibFile_ << "' for changes.\n";
+    }
+    else if (args[1] == "-e" && args.size() == 2)
+    {
+        watcher_.stop();
+        std::cout << "[Info] Stopped watching config files.\n";
+    }
+    else
+    {
+        std::cout << "[Usage] reload  |  reload now [config|calib]  |  reload -s  |  reload -e\n";
+    }
+}
+
+void CLIApp::handleWatch(const std::vector<std::string> &args)
+{
+    // watch [hz]  或  watch -e
+    if (args.size() == 2 && args[1] == "-e")
+    {
+        if (!isWatching_)
+        {
+            std::cout << "[Info] Dashboard is not open.\n";
+            return;
+        }
+        stopWatch();
+        std::cout << "[Info] Dashboard closed.\n";
+        return;
+    }
+    int hz = 10;
+    try
+    {
+        if (args.size() == 2)
+            hz = std::stoi(args[1]);
+    }
+    catch (...)
+    {
+        hz = 0;
+    }
+    if (args.size() > 2 || hz < 1 || hz > 30)
+    {
+        std::cout << "[Usage] watch [hz 1-30]  |  watch -e\n";
+        return;
+    }
+    if (!TerminalView::enableAnsi())
+    {
+        std::cout << "[Error] This console does not support ANSI escape sequences; use 'ls'.\n";
+        return;
+    }
+    stopWatch();
+    // LED 编号和峰位在面板打开期间不变，在命令线程上取一次
+    watchLabels_.clear();
+    for (size_t i = 0; i < controller_.getLedCount(); ++i)
+    {
+        const auto &led = controller_.getByIndex(i);
+        char label[24];
+        std::snprintf(label, sizeof(label), "%2d %4.0fnm", led.getId(), led.getPeakWavelength());
+        watchLabels_.push_back(label);
+    }
+    watchHz_ = hz;
+    // 清屏，把滚动区域限制在面板下方
+    TerminalView::write("\x1b[2J\x1b[" + std::to_string(kDashboardRows + 1) + "r\x1b[" +
+                        std::to_string(kDashboardRows + 1) + ";1H");
+    isWatching_ = true;
+    watchThread_ = std::thread(&CLIApp::watchLoop, this);
+    std::cout << "[Info] Dashboard open at " << hz << " Hz. Commands still work here; 'watch -e' closes it.\n";
+}
+
+void CLIApp::stopWatch()
+{
+    if (!watchThread_.joinable())
+        return;
+    isWatching_ = false;
+    watchThread_.join();
+    // 恢复整屏滚动，光标留在原处
+    TerminalView::write("\x1b" "7\x1b[r\x1b" "8");
+}
+
+void CLIApp::watchLoop()
+{
+    // 每帧只读原子计数和已发布帧；其余状态只在没有命令执行时取一次
+    Tracer::instance().setThreadName("watch");
+    using Steady = std::chrono::steady_clock;
+    const auto period = std::chrono::microseconds(1000000 / watchHz_);
+    TerminalView view(kDashboardRows, kDashboardCols);
+    std::vector<unsigned char> frame;
+    std::string out;
+    DashboardState state;
+    auto last = Steady::now();
+    uint64_t lastSent = framesSent_.load(std::memory_order_relaxed);
+    double sendRate = 0, outputRate = 0;
+    size_t outputBytes = 0;
+    auto outputSince = last;
+    auto next = last;
+    while (isWatching_)
+    {
+        // 命令执行中（如 do）沿用上次的值：ring -e 会在命令线程上解除映射
+        if (commandMutex_.try_lock())
+        {
+            std::lock_guard<std::timed_mutex> lock(commandMutex_, std::adopt_lock);
+            readDashboardState(state);
+        }
+        const uint64_t version = controller_.readFrame(frame);
+
+        const auto now = Steady::now();
+        const double dt = std::chrono::duration<double>(now - last).count();
+        const uint64_t sent = framesSent_.load(std::memory_order_relaxed);
+        if (dt > 0)
+        {
+            const double rate = static_cast<double>(sent - lastSent) / dt;
+            sendRate = sendRate == 0 ? rate : 0.7 * sendRate + 0.3 * rate; // 平滑显示
+        }
+        last = now;
+        lastSent = sent;
+        if (now - outputSince >= std::chrono::seconds(1))
+        {
+            outputRate = static_cast<double>(outputBytes) / std::chrono::duration<double>(now - outputSince).count();
+            outputBytes = 0;
+            outputSince = now;
+        }
+
+        if (watchRedraw_.exchange(false))
+            view.invalidate();
+        drawDashboard(view, frame, version, state, sendRate, outputRate);
+        out.clear();
+        view.present(out);
+        if (!out.empty())
+        {
+            TerminalView::write(out);
+            outputBytes += out.size();
+        }
+
+        // 小步睡眠，watch -e 能及时返回
+        next += period;
+        if (next < Steady::now())
+            next = Steady::now();
+        while (isWatching_ && Steady::now() < next)
+            std::this_thread::sleep_for(std::min<Steady::duration>(next - Steady::now(), std::chrono::milliseconds(50)));
+    }
+}
+
+void CLIApp::readDashboardState(DashboardState &state)
+{
+    state.locked = controller_.getLockedMask();
+    state.streamHz = isStreaming_ ? streamHz_ : 0;
+    state.ringOpen = isRingRunning_;
+    state.ringPending = state.ringOpen ? ring_.getPending() : 0;
+    state.ringOverruns = state.ringOpen ? ring_.getOverruns() : 0;
+    state.seqRunning = sequencer_.isRunning();
+    state.seqPosition = sequencer_.getPosition();
+    state.seqFrames = sequencer_.getFrameCount();
+    state.coActive = coroutines_.getActiveCount();
+}
+
+void CLIApp::drawDashboard(TerminalView &view, const std::vector<unsigned char> &frame, uint64_t version,
+                           const DashboardState &state, double sendRate, double outputRate)
+{
+    char line[kDashboardCols + 1];
+    view.clear();
+    std::snprintf(line, sizeof(line), "LightsDebugger  frame v%llu  sent %llu (%.1f/s)  errors %llu",
+                  static_cast<unsigned long long>(version),
+                  static_cast<unsigned long long>(framesSent_.load(std::memory_order_relaxed)), sendRate,
+                  static_cast<unsigned long long>(sendFailures_.load(std::memory_order_relaxed)));
+    view.put(0, 0, line);
+
+    std::string queues = "stream ";
+    queues += state.streamHz ? std::to_string(state.streamHz) + " Hz" : std::string("off");
+    queues += "  ring ";
+    queues += state.ringOpen ? std::to_string(state.ringPending) + " pending, " +
+                                   std::to_string(state.ringOverruns) + " overruns"
+                             : std::string("off");
+    queues += "  seq ";
+    queues += state.seqRunning ? std::to_string(state.seqPosition) + "/" + std::to_string(state.seqFrames)
+                               : std::string("off");
+    queues += "  co " + std::to_string(state.coActive);
+    view.put(1, 0, queues);
+    view.fill(2, 0, kDashboardCols, '-');
+
+    // 每个灯：编号、峰位、发送值的条形图、数值、锁定标记
+    for (size_t i = 0; i < frame.size() && i < watchLabels_.size() && i < 2 * kDashboardLedRows; ++i)
+    {
+        const size_t row = 3 + i % kDashboardLedRows;
+        const size_t col = (i / kDashboardLedRows) * (kDashboardCols / 2);
+        const unsigned value = frame[i];
+        const size_t filled = (value * kBarWidth + 127) / 255;
+        std::string bar(kBarWidth, ' ');
+        std::fill_n(bar.begin(), filled, '#');
+        std::snprintf(line, sizeof(line), "%s [%s] %3u %c", watchLabels_[i].c_str(), bar.c_str(), value,
+                      (state.locked >> i) & 1 ? 'L' : ' ');
+        view.put(row, col, line);
+    }
+
+    view.fill(kDashboardRows - 1, 0, kDashboardCols, '-');
+    std::snprintf(line, sizeof(line), " watch %d Hz, %.0f B/s to the terminal. 'watch -e' closes. ", watchHz_,
+                  outputRate);
+    view.put(kDashboardRows - 1, 2, line);
 }
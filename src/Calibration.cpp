@@ -0,0 +1,81 @@
+#include "Calibration.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    unsigned char toByte(double v)
+    {
+        return static_cast<unsigned char>(std::clamp(std::lround(v), 0L, 255L));
+    }
+}
+
+Calibration::Calibration(size_t channels) : tables_(channels * 256)
+{
+    for (size_t c = 0; c < channels; ++c)
+        setIdentity(c);
+}
+
+size_t Calibration::getChannelCount() const
+{
+    return tables_.size() / 256;
+}
+
+void Calibration::setIdentity(size_t channel)
+{
+    unsigned char *t = &tables_[channel * 256];
+    for (int v = 0; v < 256; ++v)
+        t[v] = static_cast<unsigned char>(v);
+}
+
+void Calibration::setTable(size_t channel, const unsigned char *table)
+{
+    std::memcpy(&tables_[channel * 256], table, 256);
+}
+
+void Calibration::setGamma(size_t channel, float gamma)
+{
+    unsigned char *t = &tables_[channel * 256];
+    for (int v = 0; v < 256; ++v)
+        t[v] = toByte(255.0 * std::pow(v / 255.0, gamma));
+}
+
+void Calibration::setRadiometric(size_t channel, float gamma, float maxRadiation, float reference)
+{
+    // 无辐射数据的通道保持线性
+    if (maxRadiation <= 0 || reference <= 0 || gamma <= 0)
+    {
+        setIdentity(channel);
+        return;
+    }
+    unsigned char *t = &tables_[channel * 256];
+    const double scale = reference / maxRadiation;
+    for (int v = 0; v < 256; ++v)
+        t[v] = toByte(255.0 * std::pow(std::min(1.0, v / 255.0 * scale), 1.0 / gamma));
+}
+
+const unsigned char *Calibration::getTable(size_t channel) const
+{
+    return &tables_[channel * 256];
+}
+
+bool Calibration::isIdentity() const
+{
+    for (size_t i = 0; i < tables_.size(); ++i)
+    {
+        if (tables_[i] != static_cast<unsigned char>(i & 0xFF))
+            return false;
+    }
+    return true;
+}
+
+void Calibration::apply(const unsigned char *in, unsigned char *out, size_t count) const
+{
+    const unsigned char *t = tables_.data();
+    const size_t n = std::min(count, getChannelCount());
+    for (size_t i = 0; i < n; ++i)
+        out[i] = t[i * 256 + in[i]];
+    for (size_t i = n; i < count; ++i)
+        out[i] = in[i];
+}
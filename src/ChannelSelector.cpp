@@ -0,0 +1,310 @@
+#include "ChannelSelector.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <functional>
+
+namespace
+{
+    struct Parser
+    {
+        Parser(const std::string &text, const LEDController &controller, const ChannelSelector::Named &named)
+            : text(text), controller(controller), named(named)
+        {
+        }
+
+        const std::string &text;
+        const LEDController &controller;
+        const ChannelSelector::Named &named;
+        size_t pos = 0;
+        std::string error;
+
+        ChannelMask all() const
+        {
+            const size_t n = controller.getLedCount();
+            return n >= 64 ? ~ChannelMask(0) : (ChannelMask(1) << n) - 1;
+        }
+
+        bool fail(const std::string &message)
+        {
+            if (error.empty())
+                error = message + " at position " + std::to_string(pos + 1);
+            return false;
+        }
+
+        template <typename Pred>
+        ChannelMask where(Pred pred) const
+        {
+            ChannelMask mask = 0;
+            for (size_t i = 0; i < controller.getLedCount(); ++i)
+                if (pred(controller.getByIndex(i)))
+                    mask |= ChannelMask(1) << i;
+            return mask;
+        }
+
+        // RGB/白光灯的峰位是编码 (1/2/3/-1)，0 为未注册
+        static bool hasWavelength(const LED &led)
+        {
+            return led.getPeakWavelength() > 3;
+        }
+
+        bool number(long &value)
+        {
+            const char *begin = text.c_str() + pos;
+            char *end = nullptr;
+            if (!std::isdigit(static_cast<unsigned char>(*begin)))
+                return fail("expected a number");
+            value = std::strtol(begin, &end, 10);
+            pos += static_cast<size_t>(end - begin);
+            return true;
+        }
+
+        bool ledId(long id, ChannelMask &mask)
+        {
+            ChannelMask m = where([id](const LED &led)
+                                  { return led.getId() == id; });
+            if (!m)
+                return fail("unknown LED id " + std::to_string(id));
+            mask = m;
+            return true;
+        }
+    };
+}
+
+bool ChannelSelector::compile(const std::string &expression, const LEDController &controller, const Named &named,
+                              std::string &error)
+{
+    // ChannelMask 每路一位，超过 64 路的灯组无法表示
+    if (controller.getLedCount() > 64)
+    {
+        error = "selectors support at most 64 LEDs (" + std::to_string(controller.getLedCount()) + " present)";
+        return false;
+    }
+    Parser parser(expression, controller, named);
+    std::vector<Instr> program;
+
+    // 递归下降，输出后缀程序
+    std::function<bool()> expr, term, factor;
+    factor = [&]() -> bool
+    {
+        if (parser.pos < expression.size() && expression[parser.pos] == '!')
+        {
+            ++parser.pos;
+            if (!factor())
+                return false;
+            program.push_back({Op::Not, 0});
+            return true;
+        }
+        if (parser.pos < expression.size() && expression[parser.pos] == '(')
+        {
+            ++parser.pos;
+            if (!expr())
+                return false;
+            if (parser.pos >= expression.size() || expression[parser.pos] != ')')
+                return parser.fail("expected ')'");
+            ++parser.pos;
+            return true;
+        }
+
+        // 原子：读到下一个运算符为止
+        size_t end = parser.pos;
+        while (end < expression.size() && std::string(",&!()").find(expression[end]) == std::string::npos)
+            ++end;
+        const std::string word = expression.substr(parser.pos, end - parser.pos);
+        if (word.empty())
+            return parser.fail("expected a selector");
+
+        auto push = [&](ChannelMask mask)
+        {
+            program.push_back({Op::Mask, mask});
+            parser.pos = end;
+            return true;
+        };
+        if (word[0] == '@')
+        {
+            auto it = named.find(word.substr(1));
+            if (it == named.end())
+                return parser.fail("unknown selector '" + word + "'");
+            program.insert(program.end(), it->second.program_.begin(), it->second.program_.end());
+            parser.pos = end;
+            return true;
+        }
+        if (word == "all")
+            return push(parser.all());
+        if (word == "none")
+            return push(0);
+        if (word == "valid")
+            return push(parser.where([](const LED &led)
+                                     { return led.getPeakWavelength() != 0; }));
+        if (word == "visible")
+            return push(parser.where([](const LED &led)
+                                     { return Parser::hasWavelength(led) && led.getPeakWavelength() >= 380 && led.getPeakWavelength() < 750; }));
+        if (word == "uv")
+            return push(parser.where([](const LED &led)
+                                     { return Parser::hasWavelength(led) && led.getPeakWavelength() < 400; }));
+        if (word == "nir")
+            return push(parser.where([](const LED &led)
+                                     { return Parser::hasWavelength(led) && led.getPeakWavelength() >= 750; }));
+        if (word == "rgb")
+            return push(parser.where([](const LED &led)
+                                     { return led.getPeakWavelength() >= 1 && led.getPeakWavelength() <= 3; }));
+        if (word == "white")
+            return push(parser.where([](const LED &led)
+                                     { return led.getPeakWavelength() < 0; }));
+        if (word == "locked" || word == "unlocked" || word == "on" || word == "off")
+        {
+            program.push_back({word == "locked" || word == "unlocked" ? Op::Locked : Op::On, 0});
+            if (word == "unlocked" || word == "off")
+                program.push_back({Op::Not, 0});
+            parser.pos = end;
+            return true;
+        }
+
+        if (word[0] == 'l')
+        {
+            // l<a> 或 l<a>-l<b> 或 l<a>-<b>
+            ++parser.pos;
+            long a = 0, b = 0;
+            if (!parser.number(a))
+                return false;
+            b = a;
+            if (parser.pos < end && expression[parser.pos] == '-')
+            {
+                ++parser.pos;
+                if (parser.pos < end && expression[parser.pos] == 'l')
+                    ++parser.pos;
+                if (!parser.number(b))
+                    return false;
+            }
+            if (parser.pos != end)
+                return parser.fail("unexpected '" + expression.substr(parser.pos, end - parser.pos) + "'");
+            if (a > b)
+                std::swap(a, b);
+            ChannelMask first, last;
+            if (!parser.ledId(a, first) || !parser.ledId(b, last))
+                return false;
+            const long lo = a, hi = b;
+            return push(parser.where([lo, hi](const LED &led)
+                                     { return led.getId() >= lo && led.getId() <= hi; }));
+        }
+
+        if (word.size() > 2 && word.compare(word.size() - 2, 2, "nm") == 0)
+        {
+            // <a>nm 或 <a>-<b>nm，按峰位闭区间
+            long a = 0, b = 0;
+            if (!parser.number(a))
+                return false;
+            b = a;
+            if (parser.pos < end && expression[parser.pos] == '-')
+            {
+                ++parser.pos;
+                if (!parser.number(b))
+                    return false;
+            }
+            if (parser.pos != end - 2)
+                return parser.fail("malformed wavelength range");
+            if (a > b)
+                std::swap(a, b);
+            const float lo = static_cast<float>(a), hi = static_cast<float>(b);
+            return push(parser.where([lo, hi](const LED &led)
+                                     { return Parser::hasWavelength(led) && led.getPeakWavelength() >= lo && led.getPeakWavelength() <= hi; }));
+        }
+        return parser.fail("unknown selector '" + word + "'");
+    };
+    term = [&]() -> bool
+    {
+        if (!factor())
+            return false;
+        while (parser.pos < expression.size() && expression[parser.pos] == '&')
+        {
+            ++parser.pos;
+            if (!factor())
+                return false;
+            program.push_back({Op::And, 0});
+        }
+        return true;
+    };
+    expr = [&]() -> bool
+    {
+        if (!term())
+            return false;
+        while (parser.pos < expression.size() && expression[parser.pos] == ',')
+        {
+            ++parser.pos;
+            if (!term())
+                return false;
+            program.push_back({Op::Or, 0});
+        }
+        return true;
+    };
+
+    if (!expr())
+    {
+        error = parser.error;
+        return false;
+    }
+    if (parser.pos != expression.size())
+    {
+        parser.fail("unexpected '" + expression.substr(parser.pos) + "'");
+        error = parser.error;
+        return false;
+    }
+
+    // 检查栈深度，evaluate 使用固定大小的栈
+    size_t depth = 0, maxDepth = 0;
+    for (const auto &instr : program)
+    {
+        if (instr.op == Op::Mask || instr.op == Op::Locked || instr.op == Op::On)
+            maxDepth = std::max(maxDepth, ++depth);
+        else if (instr.op == Op::And || instr.op == Op::Or)
+            --depth;
+    }
+    if (maxDepth > kMaxDepth)
+    {
+        error = "selector nested too deeply";
+        return false;
+    }
+    program_ = std::move(program);
+    text_ = expression;
+    return true;
+}
+
+ChannelMask ChannelSelector::evaluate(const LEDController &controller) const
+{
+    ChannelMask stack[kMaxDepth];
+    size_t top = 0;
+    const ChannelMask all =
+        controller.getLedCount() >= 64 ? ~ChannelMask(0) : (ChannelMask(1) << controller.getLedCount()) - 1;
+    for (const auto &instr : program_)
+    {
+        switch (instr.op)
+        {
+        case Op::Mask:
+            stack[top++] = instr.mask;
+            break;
+        case Op::Locked:
+            stack[top++] = controller.getLockedMask();
+            break;
+        case Op::On:
+            stack[top++] = controller.getLitMask();
+            break;
+        case Op::Not:
+            stack[top - 1] = ~stack[top - 1] & all;
+            break;
+        case Op::And:
+            --top;
+            stack[top - 1] &= stack[top];
+            break;
+        case Op::Or:
+            --top;
+            stack[top - 1] |= stack[top];
+            break;
+        }
+    }
+    return top ? stack[0] : 0;
+}
+
+const std::string &ChannelSelector::getText() const
+{
+    return text_;
+}
@@ -0,0 +1,92 @@
+#include "Clock.h"
+#include <algorithm>
+#include <thread>
+
+namespace
+{
+    // Windows sleeps in ~15.6 ms ticks: sleep until this far before the
+    // deadline, then yield-spin the rest
+    constexpr auto kSpinMargin = std::chrono::milliseconds(16);
+    constexpr auto kSleepSlice = std::chrono::milliseconds(50);
+
+    class SystemClock : public Clock
+    {
+    public:
+        TimePoint now() const override
+        {
+            return std::chrono::steady_clock::now();
+        }
+
+        void sleepUntil(TimePoint deadline) override
+        {
+            std::this_thread::sleep_until(deadline);
+        }
+
+        bool waitUntil(TimePoint deadline, const std::atomic<bool> &running) override
+        {
+            using std::chrono::steady_clock;
+            while (running && steady_clock::now() < deadline - kSpinMargin)
+                std::this_thread::sleep_for(
+                    std::min<Duration>(deadline - kSpinMargin - steady_clock::now(), kSleepSlice));
+            while (running && steady_clock::now() < deadline)
+                std::this_thread::yield();
+            return running;
+        }
+
+        std::chrono::system_clock::time_point toWallClock(TimePoint t) const override
+        {
+            const auto since = std::chrono::steady_clock::now() - t;
+            return std::chrono::system_clock::now() -
+                   std::chrono::duration_cast<std::chrono::system_clock::duration>(since);
+        }
+
+        bool isVirtual() const override
+        {
+            return false;
+        }
+    };
+}
+
+Clock &Clock::system()
+{
+    static SystemClock clock;
+    return clock;
+}
+
+Clock::TimePoint VirtualClock::now() const
+{
+    return TimePoint(std::chrono::duration_cast<Duration>(std::chrono::nanoseconds(nowNs_.load())));
+}
+
+void VirtualClock::sleepUntil(TimePoint deadline)
+{
+    // 时间只前进：并发的睡眠者各自把时钟推到自己的截止时间
+    const int64_t target = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    int64_t current = nowNs_.load();
+    while (current < target && !nowNs_.compare_exchange_weak(current, target))
+    {
+    }
+}
+
+bool VirtualClock::waitUntil(TimePoint deadline, const std::atomic<bool> &running)
+{
+    if (running)
+        sleepUntil(deadline);
+    return running;
+}
+
+std::chrono::system_clock::time_point VirtualClock::toWallClock(TimePoint t) const
+{
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(t.time_since_epoch()));
+}
+
+bool VirtualClock::isVirtual() const
+{
+    return true;
+}
+
+void VirtualClock::advance(Duration d)
+{
+    nowNs_ += std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
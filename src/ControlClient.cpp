@@ -0,0 +1,127 @@
+#include "ControlClient.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+class ControlClient::ControlClientImpl
+{
+public:
+    SOCKET s = INVALID_SOCKET;
+    bool wsaStarted = false;
+    std::string pending; // bytes received after the last reply line
+};
+
+namespace
+{
+    bool sendAll(SOCKET s, const char *data, size_t size)
+    {
+        size_t off = 0;
+        while (off < size)
+        {
+            int n = send(s, data + off, static_cast<int>(size - off), 0);
+            if (n <= 0)
+                return false;
+            off += static_cast<size_t>(n);
+        }
+        return true;
+    }
+}
+
+ControlClient::ControlClient() : impl_(new ControlClientImpl) {}
+
+ControlClient::~ControlClient()
+{
+    close();
+    if (impl_->wsaStarted)
+        WSACleanup();
+    delete impl_;
+}
+
+bool ControlClient::connect(uint16_t port)
+{
+    close();
+    if (!impl_->wsaStarted)
+    {
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+            return false;
+        impl_->wsaStarted = true;
+    }
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET)
+        return false;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        closesocket(s);
+        return false;
+    }
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+    impl_->s = s;
+    return true;
+}
+
+void ControlClient::close()
+{
+    if (impl_ && impl_->s != INVALID_SOCKET)
+    {
+        closesocket(impl_->s);
+        impl_->s = INVALID_SOCKET;
+        impl_->pending.clear();
+    }
+}
+
+bool ControlClient::isConnected() const
+{
+    return impl_ && impl_->s != INVALID_SOCKET;
+}
+
+bool ControlClient::sendCommand(const std::string &line)
+{
+    if (!isConnected())
+        return false;
+    std::string msg = line + "\n";
+    std::string reply;
+    if (!sendAll(impl_->s, msg.data(), msg.size()) || !readReply(reply))
+        return false;
+    return reply == "OK";
+}
+
+long long ControlClient::sendFrames(const unsigned char *frames, uint32_t count, unsigned char frameSize)
+{
+    using namespace ControlProtocol;
+    if (!isConnected() || count > kMaxBatchFrames)
+        return -1;
+    FrameBatchHeader hdr = {kBatchMagic0, kBatchMagic1, frameSize, 0, count};
+    std::string reply;
+    if (!sendAll(impl_->s, reinterpret_cast<const char *>(&hdr), sizeof(hdr)) ||
+        !sendAll(impl_->s, reinterpret_cast<const char *>(frames), static_cast<size_t>(count) * frameSize) ||
+        !readReply(reply))
+        return -1;
+    if (reply.rfind("OK ", 0) != 0)
+        return -1;
+    return std::stoll(reply.substr(3));
+}
+
+bool ControlClient::readReply(std::string &reply)
+{
+    // 读取一行应答
+    char chunk[256];
+    while (true)
+    {
+        auto nl = impl_->pending.find('\n');
+        if (nl != std::string::npos)
+        {
+            reply = impl_->pending.substr(0, nl);
+            impl_->pending.erase(0, nl + 1);
+            return true;
+        }
+        int n = recv(impl_->s, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        impl_->pending.append(chunk, n);
+    }
+}
@@ -0,0 +1,214 @@
+#include "ControlServer.h"
+#include "ControlProtocol.h"
+#include "Tracer.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <algorithm>
+#include <cstring>
+
+class ControlServer::ControlServerImpl
+{
+public:
+    // Written by start() before the accept thread exists and by stop() after
+    // joining it; the accept thread only reads it.
+    SOCKET listenSocket = INVALID_SOCKET;
+    bool wsaStarted = false;
+};
+
+namespace
+{
+    bool sendAll(SOCKET s, const std::string &text)
+    {
+        size_t off = 0;
+        while (off < text.size())
+        {
+            int n = send(s, text.data() + off, static_cast<int>(text.size() - off), 0);
+            if (n <= 0)
+                return false;
+            off += static_cast<size_t>(n);
+        }
+        return true;
+    }
+}
+
+ControlServer::ControlServer() : impl_(new ControlServerImpl) {}
+
+ControlServer::~ControlServer()
+{
+    stop();
+    if (impl_->wsaStarted)
+        WSACleanup();
+    delete impl_;
+}
+
+bool ControlServer::start(uint16_t port, CommandHandler onCommand, FrameHandler onFrames)
+{
+    if (running_)
+        return false;
+    if (!impl_->wsaStarted)
+    {
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+            return false;
+        impl_->wsaStarted = true;
+    }
+
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == INVALID_SOCKET)
+        return false;
+    // 仅监听本机回环地址
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(s, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || listen(s, SOMAXCONN) != 0)
+    {
+        closesocket(s);
+        return false;
+    }
+
+    impl_->listenSocket = s;
+    port_ = port;
+    onCommand_ = std::move(onCommand);
+    onFrames_ = std::move(onFrames);
+    commandCount_ = 0;
+    frameCount_ = 0;
+    running_ = true;
+    acceptThread_ = std::thread(&ControlServer::acceptLoop, this);
+    return true;
+}
+
+void ControlServer::stop()
+{
+    if (!running_)
+        return;
+    running_ = false;
+    // 关闭监听套接字让 accept 返回；句柄只在接受线程结束后才清除
+    closesocket(impl_->listenSocket);
+    if (acceptThread_.joinable())
+        acceptThread_.join();
+    impl_->listenSocket = INVALID_SOCKET;
+
+    // 断开所有客户端并等待其线程退出
+    std::unique_lock<std::mutex> lock(clientsMutex_);
+    for (auto c : clients_)
+        shutdown(static_cast<SOCKET>(c), SD_BOTH);
+    clientsDone_.wait(lock, [this]
+                      { return clients_.empty(); });
+}
+
+bool ControlServer::isRunning() const
+{
+    return running_;
+}
+
+uint16_t ControlServer::getPort() const
+{
+    return port_;
+}
+
+size_t ControlServer::getClientCount() const
+{
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    return clients_.size();
+}
+
+uint64_t ControlServer::getCommandCount() const
+{
+    return commandCount_;
+}
+
+uint64_t ControlServer::getFrameCount() const
+{
+    return frameCount_;
+}
+
+void ControlServer::acceptLoop()
+{
+    const SOCKET listener = impl_->listenSocket; // fixed while this thread runs
+    while (running_)
+    {
+        SOCKET c = accept(listener, nullptr, nullptr);
+        if (c == INVALID_SOCKET)
+            continue; // stop() closes the listening socket to break out
+        int one = 1;
+        setsockopt(c, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&one), sizeof(one));
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        if (!running_)
+        {
+            closesocket(c);
+            break;
+        }
+        clients_.push_back(static_cast<uintptr_t>(c));
+        std::thread(&ControlServer::clientLoop, this, static_cast<uintptr_t>(c)).detach();
+    }
+}
+
+void ControlServer::clientLoop(uintptr_t client)
+{
+    using namespace ControlProtocol;
+    Tracer::instance().setThreadName("control client");
+    SOCKET s = static_cast<SOCKET>(client);
+    std::vector<unsigned char> buf;
+    size_t head = 0; // start of the unparsed data in buf
+    char chunk[64 * 1024];
+    bool ok = true;
+
+    while (ok && running_)
+    {
+        int n = recv(s, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            break;
+        buf.insert(buf.end(), chunk, chunk + n);
+
+        // 解析缓冲区中所有完整的消息
+        while (ok && head < buf.size())
+        {
+            if (buf[head] == kBatchMagic0)
+            {
+                if (buf.size() - head < sizeof(FrameBatchHeader))
+                    break;
+                FrameBatchHeader hdr;
+                std::memcpy(&hdr, buf.data() + head, sizeof(hdr));
+                uint32_t count = hdr.count;
+                if (hdr.magic1 != kBatchMagic1 || hdr.frameSize == 0 || count > kMaxBatchFrames)
+                {
+                    sendAll(s, "ERR\n");
+                    ok = false; // 无法重新同步，断开连接
+                    break;
+                }
+                size_t payload = static_cast<size_t>(count) * hdr.frameSize;
+                if (buf.size() - head < sizeof(hdr) + payload)
+                    break;
+                size_t sent = onFrames_(buf.data() + head + sizeof(hdr), count, hdr.frameSize);
+                frameCount_ += sent;
+                ok = sendAll(s, "OK " + std::to_string(sent) + "\n");
+                head += sizeof(hdr) + payload;
+            }
+            else
+            {
+                auto begin = buf.begin() + head;
+                auto nl = std::find(begin, buf.end(), '\n');
+                if (nl == buf.end())
+                    break;
+                std::string line(begin, nl);
+                if (!line.empty() && line.back() == '\r')
+                    line.pop_back();
+                bool handled = onCommand_(line);
+                ++commandCount_;
+                ok = sendAll(s, handled ? "OK\n" : "ERR\n");
+                head = static_cast<size_t>(nl - buf.begin()) + 1;
+            }
+        }
+        if (head > 0)
+        {
+            buf.erase(buf.begin(), buf.begin() + head);
+            head = 0;
+        }
+    }
+
+    closesocket(s);
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    clients_.erase(std::remove(clients_.begin(), clients_.end(), client), clients_.end());
+    clientsDone_.notify_all();
+}
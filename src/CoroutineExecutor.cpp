@@ -0,0 +1,305 @@
+#include "CoroutineExecutor.h"
+#include "Tracer.h"
+#include <windows.h>
+#include <algorithm>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+class CoroutineExecutor::CoroutineExecutorImpl
+{
+public:
+    HANDLE timer = nullptr;
+    HANDLE wake = nullptr; // post() and stop() interrupt the wait
+    // 普通定时器精度约 15.6 ms，高精度定时器（Win10 1803+）约 0.5 ms；
+    // 提前这么多醒来，剩余部分自旋等待
+    Clock::duration spinMargin = std::chrono::milliseconds(16);
+
+    bool open()
+    {
+        timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (timer)
+            spinMargin = std::chrono::microseconds(1000);
+        else
+            timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+        wake = CreateEventA(nullptr, FALSE, FALSE, nullptr);
+        return timer && wake;
+    }
+
+    void close()
+    {
+        if (timer)
+            CloseHandle(timer);
+        if (wake)
+            CloseHandle(wake);
+        timer = wake = nullptr;
+    }
+
+    // Blocks until the timer fires at `until`, or until woken
+    void waitUntil(Clock::time_point until)
+    {
+        const auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(until - Clock::now());
+        if (remaining.count() <= 0)
+            return;
+        LARGE_INTEGER due;
+        due.QuadPart = -static_cast<long long>(remaining.count()) * 10; // 相对时间，100 ns 单位
+        HANDLE handles[2] = {timer, wake};
+        const DWORD backstopMs = static_cast<DWORD>(remaining.count() / 1000 + 1);
+        if (SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE))
+            WaitForMultipleObjects(2, handles, FALSE, backstopMs);
+        else
+            WaitForSingleObject(wake, backstopMs);
+    }
+};
+
+CoroutineExecutor::CoroutineExecutor()
+    : impl_(new CoroutineExecutorImpl), histogram_(new std::atomic<uint64_t>[kHistogramBuckets])
+{
+    resetStats();
+}
+
+CoroutineExecutor::~CoroutineExecutor()
+{
+    stop();
+    delete impl_;
+}
+
+bool CoroutineExecutor::start(SendHandler onSend)
+{
+    stop();
+    if (!impl_->open())
+    {
+        impl_->close();
+        return false;
+    }
+    onSend_ = std::move(onSend);
+    running_ = true;
+    loopThread_ = std::thread(&CoroutineExecutor::loop, this);
+    sendThread_ = std::thread(&CoroutineExecutor::sendLoop, this);
+    return true;
+}
+
+void CoroutineExecutor::stop()
+{
+    running_ = false;
+    if (impl_->wake)
+        SetEvent(impl_->wake);
+    sendReady_.notify_all();
+    if (loopThread_.joinable())
+        loopThread_.join();
+    if (sendThread_.joinable())
+        sendThread_.join();
+
+    // 两个线程都已退出：先丢弃仍引用协程的定时器/发送/投递，再销毁协程帧
+    timers_ = {};
+    sendQueue_.clear();
+    std::lock_guard<std::mutex> lock(postMutex_);
+    posted_.clear();
+    hasPosted_ = false;
+    for (void *frame : live_)
+        std::coroutine_handle<>::from_address(frame).destroy();
+    live_.clear();
+    impl_->close();
+}
+
+bool CoroutineExecutor::isRunning() const
+{
+    return running_;
+}
+
+bool CoroutineExecutor::spawn(Task task)
+{
+    if (!running_)
+        return false; // task 析构时销毁协程帧
+    auto handle = task.handle_;
+    task.handle_ = nullptr;
+    handle.promise().executor = this;
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        live_.insert(handle.address()); // 尚未启动的协程在 stop() 时同样被销毁
+    }
+    post([handle]()
+         { handle.resume(); });
+    return true;
+}
+
+void CoroutineExecutor::post(std::function<void()> fn)
+{
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        posted_.push_back(std::move(fn));
+        hasPosted_ = true;
+    }
+    if (running_)
+        SetEvent(impl_->wake);
+}
+
+size_t CoroutineExecutor::getActiveCount() const
+{
+    std::lock_guard<std::mutex> lock(postMutex_);
+    return live_.size();
+}
+
+void CoroutineExecutor::addTimer(Clock::time_point deadline, std::coroutine_handle<> h)
+{
+    timers_.push(Timer{deadline, timerOrder_++, h});
+}
+
+void CoroutineExecutor::queueSend(SendAwaiter *awaiter, std::coroutine_handle<> h)
+{
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        sendQueue_.push_back(SendJob{awaiter, h});
+    }
+    sendReady_.notify_one();
+}
+
+void CoroutineExecutor::retire(std::coroutine_handle<Task::promise_type> h)
+{
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        live_.erase(h.address());
+    }
+    h.destroy();
+}
+
+void CoroutineExecutor::loop()
+{
+    Tracer::instance().setThreadName("coroutines");
+    std::vector<std::function<void()>> batch;
+    while (running_)
+    {
+        if (hasPosted_.load(std::memory_order_acquire))
+        {
+            {
+                std::lock_guard<std::mutex> lock(postMutex_);
+                batch.swap(posted_);
+                hasPosted_ = false;
+            }
+            for (auto &fn : batch)
+                fn();
+            batch.clear();
+        }
+
+        // 到期的协程按截止时间顺序恢复
+        while (!timers_.empty() && timers_.top().deadline <= Clock::now())
+        {
+            Timer timer = timers_.top();
+            timers_.pop();
+            recordLateness(Clock::now() - timer.deadline);
+            timer.handle.resume();
+        }
+
+        if (!running_ || hasPosted_.load(std::memory_order_acquire))
+            continue;
+        if (timers_.empty())
+        {
+            WaitForSingleObject(impl_->wake, 100);
+            continue;
+        }
+        const auto deadline = timers_.top().deadline;
+        if (deadline - Clock::now() > impl_->spinMargin)
+        {
+            TRACE_SPAN("timer wait");
+            impl_->waitUntil(deadline - impl_->spinMargin);
+        }
+        else
+        {
+            while (Clock::now() < deadline && !hasPosted_.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+    }
+}
+
+void CoroutineExecutor::sendLoop()
+{
+    // 串口写入可能阻塞数毫秒，放在独立线程，完成后回到事件循环线程恢复协程
+    Tracer::instance().setThreadName("coroutine send");
+    while (true)
+    {
+        SendJob job;
+        {
+            std::unique_lock<std::mutex> lock(sendMutex_);
+            sendReady_.wait(lock, [this]()
+                            { return !running_ || !sendQueue_.empty(); });
+            if (!running_)
+                return;
+            job = sendQueue_.front();
+            sendQueue_.pop_front();
+        }
+        const auto &packet = job.awaiter->packet;
+        job.awaiter->result = onSend_ ? onSend_(packet.data(), packet.size()) : false;
+        ++sends_;
+        if (!job.awaiter->result)
+            ++sendErrors_;
+        post([handle = job.handle]()
+             { handle.resume(); });
+    }
+}
+
+void CoroutineExecutor::recordLateness(Clock::duration late)
+{
+    const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(late).count()));
+    histogram_[std::min<uint64_t>(ns / 1000, kHistogramBuckets - 1)].fetch_add(1, std::memory_order_relaxed);
+    resumes_.fetch_add(1, std::memory_order_relaxed);
+    latenessSumNs_.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > latenessMaxNs_.load(std::memory_order_relaxed))
+        latenessMaxNs_.store(ns, std::memory_order_relaxed); // 仅事件循环线程写入
+}
+
+CoroutineExecutor::Stats CoroutineExecutor::getStats() const
+{
+    Stats stats;
+    stats.resumes = resumes_;
+    stats.sends = sends_;
+    stats.sendErrors = sendErrors_;
+    stats.maxUs = latenessMaxNs_ / 1000.0;
+    if (stats.resumes == 0)
+        return stats;
+    stats.meanUs = latenessSumNs_ / 1000.0 / static_cast<double>(stats.resumes);
+    // 直方图按 1 us 分桶，百分位精度 1 us
+    uint64_t total = 0;
+    for (size_t i = 0; i < kHistogramBuckets; ++i)
+        total += histogram_[i].load(std::memory_order_relaxed);
+    const uint64_t rank50 = (total + 1) / 2, rank99 = total - total / 100;
+    uint64_t seen = 0;
+    bool have50 = false;
+    for (size_t i = 0; i < kHistogramBuckets; ++i)
+    {
+        seen += histogram_[i].load(std::memory_order_relaxed);
+        if (!have50 && seen >= rank50)
+        {
+            stats.p50Us = static_cast<double>(i);
+            have50 = true;
+        }
+        if (seen >= rank99)
+        {
+            stats.p99Us = static_cast<double>(i);
+            break;
+        }
+    }
+    return stats;
+}
+
+void CoroutineExecutor::resetStats()
+{
+    for (size_t i = 0; i < kHistogramBuckets; ++i)
+        histogram_[i].store(0, std::memory_order_relaxed);
+    resumes_ = 0;
+    latenessSumNs_ = 0;
+    latenessMaxNs_ = 0;
+    sends_ = 0;
+    sendErrors_ = 0;
+}
+
+void AsyncSignal::notify()
+{
+    executor_.post([this]()
+                   {
+                       // 先取出等待者，被唤醒的协程可以立即再次等待
+                       std::vector<std::coroutine_handle<>> waiters;
+                       waiters.swap(waiters_);
+                       for (auto h : waiters)
+                           h.resume(); });
+}
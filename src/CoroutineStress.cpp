@@ -0,0 +1,114 @@
+#include "CoroutineStress.h"
+#include "CoroutineExecutor.h"
+#include "FramePacket.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+    using Clock = CoroutineExecutor::Clock;
+
+    CoroutineExecutor::Task periodic(CoroutineExecutor &executor, Clock::duration period, Clock::time_point next)
+    {
+        std::vector<unsigned char> packet(FramePacket::kHeaderSize + 30, 0);
+        packet[0] = FramePacket::kHeader0;
+        packet[1] = FramePacket::kHeader1;
+        for (unsigned i = 0;; ++i)
+        {
+            co_await executor.sleepUntil(next);
+            next += period;
+            if (i % 10 == 0)
+                co_await executor.send(packet);
+        }
+    }
+
+    CoroutineExecutor::Task triggered(CoroutineExecutor &executor, AsyncSignal &signal)
+    {
+        std::vector<unsigned char> packet(FramePacket::kHeaderSize + 30, 0);
+        while (true)
+        {
+            co_await signal;
+            co_await executor.send(packet);
+        }
+    }
+}
+
+int runCoroutineStress(const std::vector<std::string> &args)
+{
+    size_t maxSequences = 10000;
+    double seconds = 2;
+    try
+    {
+        if (args.size() > 1)
+            maxSequences = std::stoul(args[1]);
+        if (args.size() > 2)
+            seconds = std::stod(args[2]);
+    }
+    catch (...)
+    {
+        maxSequences = 0;
+    }
+    if (maxSequences == 0 || seconds <= 0 || args.size() > 3)
+    {
+        std::cout << "[Usage] costress [max sequences] [seconds per step]\n";
+        return 1;
+    }
+
+    std::atomic<uint64_t> written{0};
+    auto onSend = [&written](const unsigned char *, size_t)
+    {
+        ++written;
+        return true;
+    };
+
+    std::printf("%10s %12s %10s %10s %10s %10s %10s\n", "sequences", "resumes/s", "sends/s", "mean us", "p50 us",
+                "p99 us", "max us");
+    std::mt19937 rng(12345);
+    for (size_t count = 1;; count = std::min(count * 10, maxSequences))
+    {
+        CoroutineExecutor executor;
+        if (!executor.start(onSend))
+        {
+            std::cout << "[Error] Failed to create the executor timer.\n";
+            return 1;
+        }
+        AsyncSignal signal(executor);
+        const auto start = Clock::now() + std::chrono::milliseconds(10);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // 1% 的序列等待外部触发，其余按 1-20 ms 周期运行，相位随机错开
+            if (i % 100 == 99)
+            {
+                executor.spawn(triggered(executor, signal));
+                continue;
+            }
+            const auto period = std::chrono::microseconds(1000 + rng() % 19001);
+            executor.spawn(periodic(executor, period, start + std::chrono::microseconds(rng() % 20000)));
+        }
+
+        // 预热后清零统计，外部线程每 5 ms 触发一次
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        executor.resetStats();
+        const auto measureStart = Clock::now();
+        const auto measureEnd = measureStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+        while (Clock::now() < measureEnd)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            signal.notify();
+        }
+        auto stats = executor.getStats();
+        const double elapsed = std::chrono::duration<double>(Clock::now() - measureStart).count();
+        executor.stop();
+
+        std::printf("%10zu %12.0f %10.0f %10.1f %10.0f %10.0f %10.0f\n", count, stats.resumes / elapsed,
+                    stats.sends / elapsed, stats.meanUs, stats.p50Us, stats.p99Us, stats.maxUs);
+        if (count == maxSequences)
+            break;
+    }
+    std::cout << "[Info] " << written.load() << " packets through the send thread in total.\n";
+    return 0;
+}
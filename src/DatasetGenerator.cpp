@@ -0,0 +1,130 @@
+#include "DatasetGenerator.h"
+#include "LEDController.h"
+#include "SpectralModel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace
+{
+    constexpr uint64_t kChunkFrames = 4096;
+
+    std::mt19937 chunkRng(uint64_t seed, uint64_t chunk)
+    {
+        std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                          static_cast<uint32_t>(chunk), static_cast<uint32_t>(chunk >> 32)};
+        return std::mt19937(seq);
+    }
+}
+
+int runGenTool(const std::vector<std::string> &args)
+{
+    // gen <count> <file> [seed] [threads]
+    if (args.size() < 3 || args.size() > 5)
+    {
+        std::cout << "[Usage] gen <count> <file> [seed] [threads]\n";
+        return 1;
+    }
+    uint64_t count = 0, seed = 1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    try
+    {
+        count = std::stoull(args[1]);
+        if (args.size() > 3)
+            seed = std::stoull(args[3]);
+        if (args.size() > 4)
+            threads = static_cast<unsigned>(std::stoul(args[4]));
+    }
+    catch (...)
+    {
+        count = 0;
+    }
+    if (count == 0 || threads == 0)
+    {
+        std::cout << "[Usage] gen <count> <file> [seed] [threads]\n";
+        return 1;
+    }
+
+    LEDController controller;
+    if (controller.loadMaxIntensities("led_config.cfg"))
+        std::cout << "[Info] Max intensities loaded from led_config.cfg\n";
+    const SpectralModel &model = controller.getSpectralModel();
+    const size_t channels = controller.getLedCount();
+    const size_t points = model.getPointCount();
+
+    DatasetHeader hdr = {};
+    std::memcpy(hdr.magic, "LDGN", 4);
+    hdr.version = 1;
+    hdr.count = count;
+    hdr.seed = seed;
+    hdr.channels = static_cast<uint32_t>(channels);
+    hdr.points = static_cast<uint32_t>(points);
+    hdr.startNm = model.getStart();
+    hdr.stepNm = model.getStep();
+    hdr.framesOffset = sizeof(hdr);
+    hdr.spectraOffset = hdr.framesOffset + count * channels;
+
+    std::ofstream out(args[2], std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        std::cout << "[Error] Failed to create " << args[2] << "\n";
+        return 1;
+    }
+    out.write(reinterpret_cast<const char *>(&hdr), sizeof(hdr));
+
+    // 每个线程按块领取任务，生成后在写锁下写入两列的对应位置
+    const uint64_t chunks = (count + kChunkFrames - 1) / kChunkFrames;
+    std::atomic<uint64_t> nextChunk{0};
+    std::mutex writeMutex;
+    bool writeOk = true;
+    auto start = std::chrono::steady_clock::now();
+
+    auto worker = [&]
+    {
+        std::vector<unsigned char> frames(kChunkFrames * channels);
+        std::vector<float> spectra(kChunkFrames * points);
+        for (uint64_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++)
+        {
+            const uint64_t first = chunk * kChunkFrames;
+            const uint64_t n = std::min(kChunkFrames, count - first);
+            auto rng = chunkRng(seed, chunk);
+            for (uint64_t i = 0; i < n; ++i)
+            {
+                controller.generateRandomFrame(rng, &frames[i * channels]);
+                model.evaluate(&frames[i * channels], &spectra[i * points]);
+            }
+
+            std::lock_guard<std::mutex> lock(writeMutex);
+            out.seekp(static_cast<std::streamoff>(hdr.framesOffset + first * channels));
+            out.write(reinterpret_cast<const char *>(frames.data()), static_cast<std::streamsize>(n * channels));
+            out.seekp(static_cast<std::streamoff>(hdr.spectraOffset + first * points * sizeof(float)));
+            out.write(reinterpret_cast<const char *>(spectra.data()),
+                      static_cast<std::streamsize>(n * points * sizeof(float)));
+            writeOk = writeOk && out.good();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t)
+        pool.emplace_back(worker);
+    for (auto &t : pool)
+        t.join();
+    out.close();
+
+    if (!writeOk || out.fail())
+    {
+        std::cout << "[Error] Failed to write " << args[2] << "\n";
+        return 1;
+    }
+    const double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double bytes = static_cast<double>(hdr.spectraOffset + count * points * sizeof(float));
+    std::cout << "[Info] Generated " << count << " frames x " << points << " spectral points on " << threads
+              << " threads in " << s << " s (" << static_cast<uint64_t>(count / s) << " frames/s, "
+              << bytes / s / 1e6 << " MB/s)\n";
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "EncoderBenchmark.h"
+#include "FrameProtocol.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+namespace
+{
+    volatile unsigned g_sink;
+}
+
+int runEncoderBenchmark(const std::vector<std::string> &args)
+{
+    size_t leds = 30;
+    size_t frames = 1000000;
+    try
+    {
+        if (args.size() > 1)
+            leds = std::stoul(args[1]);
+        if (args.size() > 2)
+            frames = std::stoul(args[2]);
+    }
+    catch (...)
+    {
+        leds = 0;
+    }
+    if (args.size() > 3 || leds == 0 || leds > 4096 || frames == 0)
+    {
+        std::cout << "[Usage] encbench [leds 1-4096] [frames]\n";
+        return 1;
+    }
+
+    // 1024 distinct random frames, cycled, so input stays in cache like a real stream
+    constexpr size_t kInputFrames = 1024;
+    std::mt19937 rng(1);
+    std::vector<unsigned char> input(kInputFrames * leds);
+    for (auto &b : input)
+        b = static_cast<unsigned char>(rng());
+
+    std::cout << "[Info] Encoding " << frames << " frames of " << leds << " LEDs per format.\n";
+    std::printf("  %-6s %8s %10s %10s\n", "format", "bytes", "ns/frame", "MB/s");
+    for (size_t f = 0; f < static_cast<size_t>(FrameProtocol::Format::Count); ++f)
+    {
+        const auto &op = FrameProtocol::ops(static_cast<FrameProtocol::Format>(f));
+        const size_t packetSize = op.packetSize(leds);
+        std::vector<unsigned char> out(packetSize * kInputFrames);
+        unsigned checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < frames; ++i)
+        {
+            const size_t slot = i & (kInputFrames - 1);
+            op.encode8(input.data() + slot * leds, leds, static_cast<uint8_t>(i), out.data() + slot * packetSize);
+            checksum += out[slot * packetSize + packetSize - 1]; // 写入 sink，防止编码被优化掉
+        }
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("  %-6s %8zu %10.1f %10.1f\n", op.name, packetSize, s * 1e9 / frames,
+                    packetSize * frames / s / 1e6);
+        g_sink = checksum;
+    }
+    return 0;
+}
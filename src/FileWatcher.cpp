@@ -0,0 +1,275 @@
+#include "FileWatcher.h"
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    using SteadyClock = std::chrono::steady_clock;
+    constexpr auto kPollInterval = std::chrono::milliseconds(500);
+
+    std::string lowerCase(std::string s)
+    {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return s;
+    }
+
+    uint64_t lastWriteTime(const std::string &path)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data))
+            return 0;
+        return (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+    }
+}
+
+class FileWatcher::FileWatcherImpl
+{
+public:
+    struct File
+    {
+        std::string path;
+        std::string name; // lower case, for matching notifications
+        size_t dir = 0;
+        uint64_t lastWrite = 0;
+        bool changed = false;
+        SteadyClock::time_point changedAt;
+    };
+
+    struct Directory
+    {
+        std::string path;
+        HANDLE handle = INVALID_HANDLE_VALUE;
+        HANDLE event = nullptr;
+        OVERLAPPED ov = {};
+        bool polling = false;
+        alignas(DWORD) unsigned char buffer[8192];
+    };
+
+    std::vector<File> files;
+    std::vector<Directory *> dirs;
+    HANDLE stopEvent = nullptr;
+    ChangeHandler onChange;
+    TickHandler onTick;
+    std::chrono::milliseconds settle{200};
+    std::thread thread;
+    std::atomic<bool> running{false};
+
+    bool arm(Directory &d)
+    {
+        d.ov = {};
+        d.ov.hEvent = d.event;
+        const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+        return ReadDirectoryChangesW(d.handle, d.buffer, sizeof(d.buffer), FALSE, filter, nullptr, &d.ov, nullptr) !=
+               FALSE;
+    }
+
+    void markChanged(size_t dir, const std::string &name)
+    {
+        for (auto &f : files)
+        {
+            if (f.dir == dir && f.name == name)
+            {
+                f.changed = true;
+                f.changedAt = SteadyClock::now();
+            }
+        }
+    }
+
+    void collect(size_t index)
+    {
+        Directory &d = *dirs[index];
+        DWORD got = 0;
+        if (!GetOverlappedResult(d.handle, &d.ov, &got, FALSE) || got == 0)
+        {
+            // 缓冲区溢出：不知道改了什么，当作全部变化
+            for (auto &f : files)
+                if (f.dir == index)
+                    markChanged(index, f.name);
+        }
+        else
+        {
+            for (size_t offset = 0;;)
+            {
+                const auto *info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(d.buffer + offset);
+                char name[MAX_PATH * 3];
+                const int n = WideCharToMultiByte(CP_UTF8, 0, info->FileName,
+                                                  static_cast<int>(info->FileNameLength / sizeof(WCHAR)), name,
+                                                  sizeof(name), nullptr, nullptr);
+                if (n > 0)
+                    markChanged(index, lowerCase(std::string(name, static_cast<size_t>(n))));
+                if (info->NextEntryOffset == 0)
+                    break;
+                offset += info->NextEntryOffset;
+            }
+        }
+        if (!arm(d))
+            d.polling = true;
+    }
+
+    void run()
+    {
+        auto nextPoll = SteadyClock::now();
+        while (running)
+        {
+            std::vector<HANDLE> handles{stopEvent};
+            std::vector<size_t> owners;
+            for (size_t i = 0; i < dirs.size(); ++i)
+            {
+                if (!dirs[i]->polling)
+                {
+                    handles.push_back(dirs[i]->event);
+                    owners.push_back(i);
+                }
+            }
+            // 短超时：到期后检查静默时间和轮询目录
+            const DWORD r = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, 50);
+            if (r == WAIT_OBJECT_0)
+                break;
+            if (r > WAIT_OBJECT_0 && r < WAIT_OBJECT_0 + handles.size())
+                collect(owners[r - WAIT_OBJECT_0 - 1]);
+
+            const auto now = SteadyClock::now();
+            if (now >= nextPoll)
+            {
+                nextPoll = now + kPollInterval;
+                for (auto &f : files)
+                {
+                    if (!dirs[f.dir]->polling)
+                        continue;
+                    const uint64_t t = lastWriteTime(f.path);
+                    if (t != f.lastWrite)
+                    {
+                        f.lastWrite = t;
+                        f.changed = true;
+                        f.changedAt = now;
+                    }
+                }
+            }
+            for (auto &f : files)
+            {
+                if (f.changed && now - f.changedAt >= settle)
+                {
+                    f.changed = false;
+                    if (onChange)
+                        onChange(f.path);
+                }
+            }
+            if (onTick)
+                onTick();
+        }
+    }
+
+    void close()
+    {
+        for (auto *d : dirs)
+        {
+            if (d->handle != INVALID_HANDLE_VALUE)
+            {
+                // 读请求由监视线程发出，CancelIo 取消不了；取消是异步的，
+                // 等请求真正结束后才能释放 OVERLAPPED 和缓冲区
+                if (!d->polling && CancelIoEx(d->handle, &d->ov))
+                {
+                    DWORD n = 0;
+                    GetOverlappedResult(d->handle, &d->ov, &n, TRUE); // ERROR_OPERATION_ABORTED 是预期结果
+                }
+                CloseHandle(d->handle);
+            }
+            if (d->event)
+                CloseHandle(d->event);
+            delete d;
+        }
+        dirs.clear();
+        files.clear();
+        if (stopEvent)
+            CloseHandle(stopEvent);
+        stopEvent = nullptr;
+    }
+};
+
+FileWatcher::FileWatcher() : impl_(new FileWatcherImpl) {}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+    delete impl_;
+}
+
+bool FileWatcher::start(const std::vector<std::string> &paths, ChangeHandler onChange, uint32_t settleMs,
+                        TickHandler onTick)
+{
+    stop();
+    impl_->stopEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (!impl_->stopEvent || paths.empty())
+    {
+        impl_->close();
+        return false;
+    }
+    for (const auto &path : paths)
+    {
+        const size_t slash = path.find_last_of("\\/");
+        const std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+        FileWatcherImpl::File file;
+        file.path = path;
+        file.name = lowerCase(slash == std::string::npos ? path : path.substr(slash + 1));
+        file.lastWrite = lastWriteTime(path);
+
+        auto it = std::find_if(impl_->dirs.begin(), impl_->dirs.end(), [&](const FileWatcherImpl::Directory *d)
+                               { return lowerCase(d->path) == lowerCase(dir); });
+        file.dir = static_cast<size_t>(it - impl_->dirs.begin());
+        if (it == impl_->dirs.end())
+        {
+            auto *d = new FileWatcherImpl::Directory;
+            d->path = dir;
+            impl_->dirs.push_back(d);
+            d->handle = CreateFileA(dir.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                    nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+            d->event = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+            d->polling = d->handle == INVALID_HANDLE_VALUE || !d->event || !impl_->arm(*d);
+        }
+        impl_->files.push_back(std::move(file));
+    }
+    impl_->onChange = std::move(onChange);
+    impl_->onTick = std::move(onTick);
+    impl_->settle = std::chrono::milliseconds(settleMs);
+    impl_->running = true;
+    impl_->thread = std::thread(&FileWatcherImpl::run, impl_);
+    return true;
+}
+
+void FileWatcher::stop()
+{
+    if (impl_->running)
+    {
+        impl_->running = false;
+        SetEvent(impl_->stopEvent);
+    }
+    if (impl_->thread.joinable())
+        impl_->thread.join();
+    impl_->close();
+}
+
+bool FileWatcher::isRunning() const
+{
+    return impl_->running;
+}
+
+std::vector<std::string> FileWatcher::getPaths() const
+{
+    std::vector<std::string> paths;
+    for (const auto &f : impl_->files)
+        paths.push_back(f.path);
+    return paths;
+}
+
+size_t FileWatcher::getPolledCount() const
+{
+    size_t n = 0;
+    for (const auto &f : impl_->files)
+        n += impl_->dirs[f.dir]->polling;
+    return n;
+}
@@ -0,0 +1,163 @@
+#include "FlightRecorder.h"
+#include <windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <exception>
+
+namespace
+{
+    FlightRecorder *g_crashRecorder = nullptr;
+    std::terminate_handler g_previousTerminate = nullptr;
+}
+
+struct FlightRecorderCrashHook
+{
+    static LONG WINAPI onException(EXCEPTION_POINTERS *)
+    {
+        if (g_crashRecorder)
+            g_crashRecorder->crashDump();
+        return EXCEPTION_CONTINUE_SEARCH;
+    }
+
+    static void onTerminate()
+    {
+        if (g_crashRecorder)
+            g_crashRecorder->crashDump();
+        if (g_previousTerminate)
+            g_previousTerminate();
+        std::abort();
+    }
+};
+
+FlightRecorder::FlightRecorder(size_t capacity)
+    : ring_(std::max<size_t>(capacity, 1)), commands_(kCommandSlots), commandIds_(kCommandSlots, 0)
+{
+}
+
+void FlightRecorder::setClock(const Clock &clock)
+{
+    clock_ = &clock;
+}
+
+void FlightRecorder::record(const unsigned char *packet, size_t size, uint64_t version, uint64_t command)
+{
+    Frame &f = ring_[head_ % ring_.size()];
+    f.timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(clock_->now().time_since_epoch()).count();
+    f.version = version;
+    f.command = command;
+    f.size = static_cast<uint32_t>(std::min(size, RecordingFormat::kPacketSize));
+    std::memcpy(f.packet, packet, f.size);
+    ++head_;
+}
+
+uint64_t FlightRecorder::noteCommand(const std::string &line)
+{
+    std::lock_guard<std::mutex> lock(commandMutex_);
+    const uint64_t id = nextCommand_++;
+    commands_[id % kCommandSlots] = line;
+    commandIds_[id % kCommandSlots] = id;
+    return id;
+}
+
+std::vector<FlightRecorder::Frame> FlightRecorder::snapshot() const
+{
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(head_, ring_.size()));
+    std::vector<Frame> frames(count);
+    const size_t first = static_cast<size_t>((head_ - count) % ring_.size());
+    const size_t tail = std::min(count, ring_.size() - first);
+    std::copy_n(ring_.begin() + static_cast<ptrdiff_t>(first), tail, frames.begin());
+    std::copy_n(ring_.begin(), count - tail, frames.begin() + static_cast<ptrdiff_t>(tail));
+    return frames;
+}
+
+bool FlightRecorder::dump(const std::vector<Frame> &frames, const std::string &path, std::string &error) const
+{
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        error = "cannot open '" + path + "'";
+        return false;
+    }
+    writeFrames(file, frames.data(), frames.size(), true);
+    const bool ok = std::ferror(file) == 0;
+    if (std::fclose(file) != 0 || !ok)
+    {
+        error = "write to '" + path + "' failed";
+        return false;
+    }
+    return true;
+}
+
+void FlightRecorder::writeFrames(std::FILE *file, const Frame *frames, size_t count, bool lockCommands) const
+{
+    const bool utc = clock_->isVirtual();
+    std::unique_lock<std::mutex> lock(commandMutex_, std::defer_lock);
+    const bool haveCommands = lockCommands ? (lock.lock(), true) : lock.try_lock();
+
+    char line[RecordingFormat::kMaxLineSize + 64];
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Frame &f = frames[i];
+        size_t n = RecordingFormat::formatLine(f.packet, f.size, f.version, line);
+        --n; // 去掉换行，追加注释
+
+        const auto wall = clock_->toWallClock(Clock::TimePoint(
+            std::chrono::duration_cast<Clock::Duration>(std::chrono::nanoseconds(f.timeNs))));
+        const std::time_t seconds = std::chrono::system_clock::to_time_t(wall);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(wall.time_since_epoch()).count() % 1000;
+        std::tm tm{};
+#ifdef _WIN32
+        utc ? gmtime_s(&tm, &seconds) : localtime_s(&tm, &seconds);
+#else
+        utc ? gmtime_r(&seconds, &tm) : localtime_r(&seconds, &tm);
+#endif
+        n += std::strftime(line + n, sizeof(line) - n, " ; %H:%M:%S", &tm);
+        n += static_cast<size_t>(std::snprintf(line + n, sizeof(line) - n, ".%03d", static_cast<int>(ms)));
+        std::fwrite(line, 1, n, file);
+
+        const char *command = "(none)";
+        if (f.command != 0)
+            command = haveCommands && commandIds_[f.command % kCommandSlots] == f.command
+                          ? commands_[f.command % kCommandSlots].c_str()
+                          : "(older command)";
+        std::fprintf(file, " %s\n", command);
+    }
+}
+
+void FlightRecorder::installCrashDump(const std::string &path)
+{
+    crashPath_ = path;
+    g_crashRecorder = this;
+    SetUnhandledExceptionFilter(&FlightRecorderCrashHook::onException);
+    g_previousTerminate = std::set_terminate(&FlightRecorderCrashHook::onTerminate);
+}
+
+void FlightRecorder::crashDump() const
+{
+    // 崩溃时不加锁、不分配，直接按环形缓冲顺序写出
+    static bool dumped = false;
+    if (dumped || crashPath_.empty())
+        return;
+    dumped = true;
+    std::FILE *file = std::fopen(crashPath_.c_str(), "wb");
+    if (!file)
+        return;
+    const size_t count = static_cast<size_t>(std::min<uint64_t>(head_, ring_.size()));
+    const size_t first = static_cast<size_t>((head_ - count) % ring_.size());
+    const size_t tail = std::min(count, ring_.size() - first);
+    writeFrames(file, ring_.data() + first, tail, false);
+    writeFrames(file, ring_.data(), count - tail, false);
+    std::fclose(file);
+}
+
+size_t FlightRecorder::getCapacity() const
+{
+    return ring_.size();
+}
+
+uint64_t FlightRecorder::getRecorded() const
+{
+    return head_;
+}
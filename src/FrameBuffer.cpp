@@ -0,0 +1,46 @@
+#include "FrameBuffer.h"
+#include <thread>
+
+FrameBuffer::FrameBuffer(size_t size) : data_(size)
+{
+}
+
+size_t FrameBuffer::size() const
+{
+    return data_.size();
+}
+
+uint64_t FrameBuffer::publish(const unsigned char *data)
+{
+    // Odd sequence marks a write in progress
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < data_.size(); ++i)
+        data_[i].store(data[i], std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+    return (seq + 2) / 2;
+}
+
+uint64_t FrameBuffer::read(unsigned char *out) const
+{
+    while (true)
+    {
+        uint64_t before = seq_.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < data_.size(); ++i)
+            out[i] = data_[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (seq_.load(std::memory_order_relaxed) == before)
+            return before / 2;
+    }
+}
+
+uint64_t FrameBuffer::version() const
+{
+    return seq_.load(std::memory_order_acquire) / 2;
+}
@@ -0,0 +1,34 @@
+#include "FramePacket.h"
+#include "Calibration.h"
+#include "Tracer.h"
+#include <cstring>
+
+namespace FramePacket
+{
+    void build(const unsigned char *frame, size_t size, std::vector<unsigned char> &packet)
+    {
+        TRACE_SPAN("packet build");
+        packet.resize(kHeaderSize + size);
+        packet[0] = kHeader0;
+        packet[1] = kHeader1;
+        std::memcpy(packet.data() + kHeaderSize, frame, size);
+    }
+
+    void buildBatch(const unsigned char *frames, size_t count, size_t frameSize, const Calibration *calibration,
+                    std::vector<unsigned char> &batch)
+    {
+        TRACE_SPAN("batch build");
+        const size_t packetSize = kHeaderSize + frameSize;
+        batch.resize(count * packetSize);
+        for (size_t i = 0; i < count; ++i)
+        {
+            unsigned char *p = batch.data() + i * packetSize;
+            p[0] = kHeader0;
+            p[1] = kHeader1;
+            if (calibration)
+                calibration->apply(frames + i * frameSize, p + kHeaderSize, frameSize);
+            else
+                std::memcpy(p + kHeaderSize, frames + i * frameSize, frameSize);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#include "FrameProtocol.h"
+#include "FramePacket.h"
+#include "Tracer.h"
+
+namespace FrameProtocol
+{
+    namespace
+    {
+        template <typename E>
+        constexpr EncoderOps makeOps(Format format, const char *name)
+        {
+            return {format, name, E::kBits, E::kHeader1, &E::packetSize, &E::template encode<unsigned char>,
+                    &E::template encode<uint16_t>, &E::decode8};
+        }
+
+        constexpr EncoderOps kOps[] = {
+            makeOps<Raw8>(Format::Raw8, "8"),
+            makeOps<Raw8Crc>(Format::Raw8Crc, "8c"),
+            makeOps<Packed10>(Format::Packed10, "10"),
+            makeOps<Packed10Crc>(Format::Packed10Crc, "10c"),
+            makeOps<Packed12>(Format::Packed12, "12"),
+            makeOps<Packed12Crc>(Format::Packed12Crc, "12c"),
+        };
+        static_assert(sizeof(kOps) / sizeof(kOps[0]) == static_cast<size_t>(Format::Count), "one entry per format");
+        static_assert(Raw8::kHeader1 == FramePacket::kHeader1, "8-bit format is the legacy packet");
+    }
+
+    const EncoderOps &ops(Format format)
+    {
+        return kOps[static_cast<size_t>(format)];
+    }
+
+    bool parseFormat(const std::string &name, Format &format)
+    {
+        for (const auto &op : kOps)
+        {
+            if (name == op.name)
+            {
+                format = op.format;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const EncoderOps *findByHeader(unsigned char header1)
+    {
+        for (const auto &op : kOps)
+        {
+            if (op.header1 == header1)
+                return &op;
+        }
+        return nullptr;
+    }
+
+    size_t encodeBatch(Format format, const unsigned char *packets, size_t count, size_t frameSize, uint8_t &counter,
+                       std::vector<unsigned char> &wire)
+    {
+        TRACE_SPAN("wire encode");
+        const EncoderOps &op = ops(format);
+        const size_t inSize = FramePacket::kHeaderSize + frameSize;
+        const size_t outSize = op.packetSize(frameSize);
+        if (wire.size() < count * outSize)
+            wire.resize(count * outSize);
+        unsigned char *out = wire.data();
+        for (size_t i = 0; i < count; ++i)
+            out += op.encode8(packets + i * inSize + FramePacket::kHeaderSize, frameSize, counter++, out);
+        return count * outSize;
+    }
+}
@@ -0,0 +1,127 @@
+#include "FrameRing.h"
+#include "LightsRing.h"
+#include <cstring>
+
+const char *const FrameRing::kDefaultName = LIGHTS_RING_DEFAULT_NAME;
+const uint32_t FrameRing::kDefaultCapacity = LIGHTS_RING_DEFAULT_CAPACITY;
+
+class FrameRing::FrameRingImpl
+{
+public:
+    lights_ring ring = {};
+};
+
+FrameRing::FrameRing() : impl_(new FrameRingImpl) {}
+
+FrameRing::~FrameRing()
+{
+    close();
+    delete impl_;
+}
+
+bool FrameRing::create(const std::string &name, uint32_t capacity)
+{
+    close();
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+        return false;
+    char mappingName[256], wakeName[256];
+    lights_ring_object_names(name.c_str(), mappingName, wakeName, sizeof(mappingName));
+
+    auto &r = impl_->ring;
+    const size_t bytes = lights_ring_bytes(capacity);
+    r.mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                   static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32),
+                                   static_cast<DWORD>(bytes & 0xFFFFFFFFu), mappingName);
+    if (!r.mapping)
+        return false;
+    r.hdr = static_cast<lights_ring_header *>(MapViewOfFile(r.mapping, FILE_MAP_ALL_ACCESS, 0, 0, bytes));
+    r.wake = CreateEventA(nullptr, FALSE, FALSE, wakeName);
+    if (!r.hdr || !r.wake)
+    {
+        lights_ring_close(&r);
+        return false;
+    }
+    r.slots = reinterpret_cast<lights_ring_slot *>(r.hdr + 1);
+
+    // 初始化头部，magic 最后写入，生产者据此判断环已就绪
+    std::memset(r.hdr, 0, sizeof(lights_ring_header));
+    r.hdr->version = LIGHTS_RING_VERSION;
+    r.hdr->frame_size = LIGHTS_RING_FRAME_SIZE;
+    r.hdr->capacity = capacity;
+    MemoryBarrier();
+    r.hdr->magic = LIGHTS_RING_MAGIC;
+    name_ = name;
+    return true;
+}
+
+void FrameRing::close()
+{
+    if (impl_->ring.hdr)
+        impl_->ring.hdr->magic = 0;
+    lights_ring_close(&impl_->ring);
+    name_.clear();
+}
+
+bool FrameRing::isOpen() const
+{
+    return impl_->ring.hdr != nullptr;
+}
+
+size_t FrameRing::consume(const PacketHandler &handler, unsigned timeoutMs)
+{
+    auto &r = impl_->ring;
+    if (!r.hdr)
+        return 0;
+    lights_ring_header *h = r.hdr;
+    LONG64 rd = h->read_seq; // only the consumer writes it
+    LONG64 wr = lights_ring_load(&h->write_seq);
+    if (wr == rd)
+    {
+        // 先声明将要休眠再复查，避免错过生产者的唤醒
+        InterlockedExchange(&h->waiting, 1);
+        wr = lights_ring_load(&h->write_seq);
+        if (wr == rd)
+            WaitForSingleObject(r.wake, timeoutMs);
+        InterlockedExchange(&h->waiting, 0);
+        wr = lights_ring_load(&h->write_seq);
+    }
+
+    const uint32_t mask = h->capacity - 1;
+    size_t consumed = 0;
+    for (; rd < wr; ++rd, ++consumed)
+    {
+        const lights_ring_slot &slot = r.slots[rd & mask];
+        handler(slot.packet, LIGHTS_RING_PACKET_SIZE, slot.seq);
+    }
+    if (consumed)
+        InterlockedExchange64(&h->read_seq, rd); // 释放已处理的槽位
+    return consumed;
+}
+
+std::string FrameRing::getName() const
+{
+    return name_;
+}
+
+uint32_t FrameRing::getCapacity() const
+{
+    return impl_->ring.hdr ? impl_->ring.hdr->capacity : 0;
+}
+
+uint64_t FrameRing::getConsumed() const
+{
+    return impl_->ring.hdr ? static_cast<uint64_t>(lights_ring_load(&impl_->ring.hdr->read_seq)) : 0;
+}
+
+uint64_t FrameRing::getPending() const
+{
+    if (!impl_->ring.hdr)
+        return 0;
+    auto *h = impl_->ring.hdr;
+    return static_cast<uint64_t>(lights_ring_load(&h->write_seq) - lights_ring_load(&h->read_seq));
+}
+
+uint64_t FrameRing::getOverruns() const
+{
+    return impl_->ring.hdr ? static_cast<uint64_t>(lights_ring_load(&impl_->ring.hdr->overruns)) : 0;
+}
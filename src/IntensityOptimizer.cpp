@@ -0,0 +1,210 @@
+#include "IntensityOptimizer.h"
+#include <algorithm>
+#include <cmath>
+
+IntensityOptimizer::IntensityOptimizer(size_t measurements, size_t channels)
+    : m_(measurements), n_(channels), jac_(measurements * channels, 0.0), lo_(channels, 0.0f), hi_(channels, 255.0f)
+{
+}
+
+size_t IntensityOptimizer::getMeasurementCount() const
+{
+    return m_;
+}
+
+size_t IntensityOptimizer::getChannelCount() const
+{
+    return n_;
+}
+
+void IntensityOptimizer::setJacobian(const std::vector<float> &jacobian)
+{
+    jac_.assign(jacobian.begin(), jacobian.end());
+    jac_.resize(m_ * n_, 0.0);
+    gainFitted_ = false;
+}
+
+void IntensityOptimizer::setBounds(size_t channel, float lo, float hi)
+{
+    lo_[channel] = lo;
+    hi_[channel] = std::max(lo, hi);
+}
+
+double IntensityOptimizer::step(const std::vector<float> &x, const std::vector<float> &measured,
+                                const std::vector<float> &target, std::vector<float> &next)
+{
+    std::vector<double> r(m_);
+    double norm = 0, targetNorm = 0;
+    for (size_t i = 0; i < m_; ++i)
+    {
+        r[i] = static_cast<double>(target[i]) - measured[i];
+        norm += r[i] * r[i];
+        targetNorm += static_cast<double>(target[i]) * target[i];
+    }
+    norm = std::sqrt(norm);
+    const double relative = targetNorm > 0 ? norm / std::sqrt(targetNorm) : norm;
+
+    if (!gainFitted_)
+    {
+        // 首次测量：按最小二乘把模型整体缩放到仪器单位
+        double num = 0, den = 0;
+        for (size_t i = 0; i < m_; ++i)
+        {
+            double predicted = 0;
+            for (size_t c = 0; c < n_; ++c)
+                predicted += jac_[i * n_ + c] * x[c];
+            num += predicted * measured[i];
+            den += predicted * predicted;
+        }
+        if (den > 0 && num > 0)
+        {
+            for (auto &v : jac_)
+                v *= num / den;
+            gainFitted_ = true;
+        }
+    }
+    else if (hasPrevious_)
+    {
+        // Broyden: J += (dy - J s) s' / (s' s)
+        double ss = 0;
+        for (size_t c = 0; c < n_; ++c)
+            ss += static_cast<double>(x[c] - prevX_[c]) * (x[c] - prevX_[c]);
+        if (ss > 0.25)
+        {
+            for (size_t i = 0; i < m_; ++i)
+            {
+                double predicted = 0;
+                for (size_t c = 0; c < n_; ++c)
+                    predicted += jac_[i * n_ + c] * (x[c] - prevX_[c]);
+                const double k = ((measured[i] - prevY_[i]) - predicted) / ss;
+                for (size_t c = 0; c < n_; ++c)
+                    jac_[i * n_ + c] += k * (x[c] - prevX_[c]);
+            }
+        }
+    }
+    prevX_ = x;
+    prevY_ = measured;
+    hasPrevious_ = true;
+
+    if (bestNorm_ < 0 || norm <= bestNorm_)
+    {
+        best_ = x;
+        bestResidual_ = r;
+        bestNorm_ = norm;
+        lambda_ = std::max(lambda_ / 3, 1e-6);
+    }
+    else
+    {
+        lambda_ = std::min(lambda_ * 4, 1e3);
+    }
+    // 总是从目前最好的帧出发（使用已更新的雅可比）
+    solve(best_, bestResidual_, next);
+    return relative;
+}
+
+void IntensityOptimizer::solve(const std::vector<float> &from, const std::vector<double> &residual,
+                               std::vector<float> &next) const
+{
+    next = from;
+    std::vector<bool> free(n_);
+    for (size_t c = 0; c < n_; ++c)
+        free[c] = hi_[c] > lo_[c];
+
+    std::vector<double> r = residual;
+    for (size_t pass = 0; pass <= n_; ++pass)
+    {
+        std::vector<size_t> idx;
+        for (size_t c = 0; c < n_; ++c)
+            if (free[c])
+                idx.push_back(c);
+        const size_t k = idx.size();
+        if (k == 0)
+            return;
+
+        // Normal equations on the free channels
+        std::vector<double> a(k * k, 0.0), b(k, 0.0);
+        for (size_t i = 0; i < m_; ++i)
+        {
+            const double *row = &jac_[i * n_];
+            for (size_t p = 0; p < k; ++p)
+            {
+                const double jp = row[idx[p]];
+                if (jp == 0)
+                    continue;
+                b[p] += jp * r[i];
+                for (size_t q = 0; q <= p; ++q)
+                    a[p * k + q] += jp * row[idx[q]];
+            }
+        }
+        double trace = 0;
+        for (size_t p = 0; p < k; ++p)
+            trace += a[p * k + p];
+        const double floor = trace > 0 ? trace / k * 1e-9 : 1e-12;
+        for (size_t p = 0; p < k; ++p)
+            a[p * k + p] += lambda_ * a[p * k + p] + floor;
+
+        // Cholesky (lower triangle)
+        for (size_t p = 0; p < k; ++p)
+        {
+            for (size_t q = 0; q <= p; ++q)
+            {
+                double sum = a[p * k + q];
+                for (size_t j = 0; j < q; ++j)
+                    sum -= a[p * k + j] * a[q * k + j];
+                if (p == q)
+                    a[p * k + p] = std::sqrt(std::max(sum, floor));
+                else
+                    a[p * k + q] = sum / a[q * k + q];
+            }
+        }
+        std::vector<double> d(k);
+        for (size_t p = 0; p < k; ++p)
+        {
+            double sum = b[p];
+            for (size_t j = 0; j < p; ++j)
+                sum -= a[p * k + j] * d[j];
+            d[p] = sum / a[p * k + p];
+        }
+        for (size_t p = k; p-- > 0;)
+        {
+            double sum = d[p];
+            for (size_t j = p + 1; j < k; ++j)
+                sum -= a[j * k + p] * d[j];
+            d[p] = sum / a[p * k + p];
+        }
+
+        // Pin channels that leave their bounds, subtract their move from r, re-solve the rest
+        bool pinned = false;
+        for (size_t p = 0; p < k; ++p)
+        {
+            const size_t c = idx[p];
+            const double target = next[c] + d[p];
+            if (target < lo_[c] || target > hi_[c])
+            {
+                const float bound = target < lo_[c] ? lo_[c] : hi_[c];
+                const double move = bound - next[c];
+                for (size_t i = 0; i < m_; ++i)
+                    r[i] -= jac_[i * n_ + c] * move;
+                next[c] = bound;
+                free[c] = false;
+                pinned = true;
+            }
+        }
+        if (!pinned)
+        {
+            for (size_t p = 0; p < k; ++p)
+                next[idx[p]] = static_cast<float>(next[idx[p]] + d[p]);
+            return;
+        }
+    }
+}
+
+const std::vector<float> &IntensityOptimizer::getBest() const
+{
+    return best_;
+}
+
+double IntensityOptimizer::getBestResidual() const
+{
+    return bestNorm_;
+}
@@ -37,10 +37,14 @@ void LED::setMaxIntensity(unsigned char value)
     maxIntensity_ = value;
 }
 
-void LED::randomizeIntensity()
+unsigned char LED::getMinIntensity() const
 {
-    // 生成随机强度
-    intensity_ = rand() % (maxIntensity_ + 1);
+    return minIntensity_;
+}
+
+void LED::setMinIntensity(unsigned char value)
+{
+    minIntensity_ = value;
 }
 
 int LED::getId() const
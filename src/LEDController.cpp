@@ -1,52 +1,29 @@
 #include "LEDController.h"
+#include "Tracer.h"
+#include "BoardSpec.h"
 #include <string>
+#include <sstream>
+#include <algorithm>
 
-LEDController::LEDController(size_t count)
-{
-    // Each element: {id, peakWavelength, maxRadiation}
-    static const struct
-    {
-        int id;
-        float peak;
-        float maxRad;
-    } led_params[] = {
-        {1, 405, 35000},
-        {2, 430, 50000},
-        {3, 450, 55000},
-        {4, 490, 27500},
-        {5, 505, 55000},
-        {6, 525, 37500},
-        {7, 545, 13000},
-        {8, 570, 8500},
-        {9, 590, 13000},
-        {10, 610, 65000},
-        {11, 625, 65000},
-        {12, 645, 65000},
-        {13, 660, 65000},
-        {14, 680, 50000},
-        {15, 750, 32500},
-        {16, 770, 30000},
-        {17, 800, 21000},
-        {18, 870, 0},
-        {19, 970, 0},
-        {20, 1050, 0},
-        {21, 1200, 0},
-        {22, 1300, 0},
-        {23, 1450, 0},
-        {24, 1550, 0},
-        {25, 1600, 0},
-        {26, 0, 0},
-        {27, 1, 0},  // RED LED
-        {28, 2, 0},  // GREEN LED
-        {29, 3, 0},  // BLUE LED
-        {30, -1, -1} // white LED
-    };
-
-    leds_.reserve(30);
-    for (const auto &param : led_params)
-    {
-        leds_.emplace_back(param.id, param.peak, param.maxRad);
+namespace
+{
+    // 掩码只覆盖前 64 路；更宽的灯组只有全通掩码（~0）才视为空闲
+    bool isFree(ChannelMask free, size_t i)
+    {
+        return i < 64 ? (free >> i & 1) != 0 : free == ~ChannelMask(0);
+    }
+}
+
+LEDController::LEDController() : frame_(Lights30Board::kChannels)
+{
+    leds_.reserve(Lights30Board::kChannels);
+    for (const auto &channel : Lights30Board::kLeds)
+    {
+        leds_.emplace_back(channel.id, channel.peak, channel.maxRad);
     }
+    calibration_.store(std::make_shared<const Calibration>(leds_.size()));
+    setSpectralGrid(350.0f, 5.0f, 271); // 350 - 1700 nm
+    publish();
 }
 
 LED &LEDController::getById(int id)
@@ -97,16 +74,284 @@ const LED &LEDController::getByPeak(float peak) const
     throw std::out_of_range("LED with the specified peak wavelength is not found");
 }
 
-void LEDController::randomizeAll()
+size_t LEDController::getLedCount() const
 {
-    // Randomize the intensity of all LEDs (skip invalid LEDs)
-    for (auto &led : leds_)
+    return leds_.size();
+}
+
+LED &LEDController::getByIndex(size_t index)
+{
+    return leds_.at(index);
+}
+
+const LED &LEDController::getByIndex(size_t index) const
+{
+    return leds_.at(index);
+}
+
+size_t LEDController::applyMasked(ChannelMask mask, BulkOp op, float a, float b)
+{
+    const size_t n = std::min<size_t>(leds_.size(), 64);
+    size_t changed = 0;
+    switch (op)
+    {
+    case BulkOp::SetMax:
+    case BulkOp::SetMin:
+    case BulkOp::Lock:
+    case BulkOp::Unlock:
+    {
+        const auto value = static_cast<unsigned char>(std::clamp(a, 0.0f, 255.0f));
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (!(mask >> i & 1))
+                continue;
+            auto &led = leds_[i];
+            if (op == BulkOp::SetMax)
+                led.setMaxIntensity(value);
+            else if (op == BulkOp::SetMin)
+                led.setMinIntensity(value);
+            else if (op == BulkOp::Lock)
+                led.lock();
+            else
+                led.unlock();
+            ++changed;
+        }
+        return changed;
+    }
+    default:
+        break;
+    }
+
+    // 强度操作：先收集成数组，无分支地整段计算（可被编译器向量化），再写回有变化的灯
+    unsigned char current[64], result[64], selected[64];
+    for (size_t i = 0; i < n; ++i)
+    {
+        current[i] = leds_[i].getIntensity();
+        selected[i] = (mask >> i & 1) && !leds_[i].isLocked() && leds_[i].getPeakWavelength() != 0;
+    }
+    if (op == BulkOp::Randomize)
+    {
+        ChannelMask free = 0;
+        for (size_t i = 0; i < n; ++i)
+            free |= ChannelMask(selected[i]) << i;
+        std::vector<unsigned char> frame(leds_.size()); // generateRandomFrame 写满所有灯
+        generateRandomFrame(rng_, frame.data(), free);
+        for (size_t i = 0; i < n; ++i)
+            result[i] = selected[i] ? frame[i] : current[i];
+    }
+    else
+    {
+        // v = current * scale + offset，再夹到 [lo, hi]
+        float scale = 0, offset = a, lo = 0, hi = 255;
+        if (op == BulkOp::Scale)
+        {
+            scale = a;
+            offset = 0;
+        }
+        else if (op == BulkOp::Add)
+        {
+            scale = 1;
+        }
+        else if (op == BulkOp::Clamp)
+        {
+            scale = 1;
+            offset = 0;
+            lo = std::clamp(std::min(a, b), 0.0f, 255.0f);
+            hi = std::clamp(std::max(a, b), 0.0f, 255.0f);
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            const float v = std::clamp(current[i] * scale + offset, lo, hi);
+            const auto rounded = static_cast<unsigned char>(v + 0.5f);
+            result[i] = selected[i] ? rounded : current[i];
+        }
+    }
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (result[i] != current[i])
+        {
+            leds_[i].setIntensity(result[i]);
+            ++changed;
+        }
+    }
+    return changed;
+}
+
+ChannelMask LEDController::getLockedMask() const
+{
+    ChannelMask mask = 0;
+    for (size_t i = 0; i < leds_.size() && i < 64; ++i)
+        mask |= ChannelMask(leds_[i].isLocked()) << i;
+    return mask;
+}
+
+ChannelMask LEDController::getLitMask() const
+{
+    ChannelMask mask = 0;
+    for (size_t i = 0; i < leds_.size() && i < 64; ++i)
+        mask |= ChannelMask(leds_[i].getIntensity() > 0) << i;
+    return mask;
+}
+
+bool LEDController::randomizeAll()
+{
+    TRACE_SPAN("randomizeAll");
+    std::vector<unsigned char> frame(leds_.size());
+    bool ok;
+    if (sequence_)
+    {
+        // 每个可随机的灯占序列的一维
+        size_t dims = 0;
+        for (const auto &led : leds_)
+            dims += led.getPeakWavelength() != 0 && !led.isLocked();
+        float point[LowDiscrepancySequence::kMaxDims];
+        sampleTag_ = {sequence_->getKind(), sequence_->getSeed(), sequence_->index()};
+        sequence_->next(point, dims);
+        size_t d = 0;
+        ok = drawFrame(frame.data(), ~ChannelMask(0), [&](int span)
+                       {
+                           const float u = d < dims && d < LowDiscrepancySequence::kMaxDims ? point[d] : 0.0f;
+                           ++d;
+                           return std::min(static_cast<int>(u * static_cast<float>(span + 1)), span);
+                       });
+        sampleFrame_ = frame;
+    }
+    else
+    {
+        ok = generateRandomFrame(rng_, frame.data());
+        sampleFrame_.clear();
+    }
+    for (size_t i = 0; i < leds_.size(); ++i)
+        leds_[i].setIntensity(frame[i]);
+    return ok;
+}
+
+void LEDController::seedRandom(uint32_t seed)
+{
+    rng_.seed(seed);
+}
+
+void LEDController::setSequence(LowDiscrepancySequence::Kind kind, uint32_t seed, uint64_t index)
+{
+    sequence_ = std::make_unique<LowDiscrepancySequence>(kind, seed, index);
+}
+
+void LEDController::clearSequence()
+{
+    sequence_.reset();
+    sampleFrame_.clear();
+}
+
+const LowDiscrepancySequence *LEDController::getSequence() const
+{
+    return sequence_.get();
+}
+
+bool LEDController::getSampleTag(uint64_t version, const unsigned char *frame, size_t size,
+                                 RecordingFormat::SampleTag &tag) const
+{
+    const auto sample = sample_.load();
+    if (!sample || sample->version != version || sample->frame.size() != size ||
+        !std::equal(frame, frame + size, sample->frame.begin()))
+        return false;
+    tag = sample->tag;
+    return true;
+}
+
+bool LEDController::generateRandomFrame(std::mt19937 &rng, unsigned char *out) const
+{
+    return generateRandomFrame(rng, out, ~ChannelMask(0));
+}
+
+bool LEDController::generateRandomFrame(std::mt19937 &rng, unsigned char *out, ChannelMask free) const
+{
+    // rng() % n instead of a distribution keeps seeded frames identical across
+    // standard libraries.
+    return drawFrame(out, free, [&rng](int span)
+                     { return span > 0 ? static_cast<int>(rng() % static_cast<uint32_t>(span + 1)) : 0; });
+}
+
+template <typename Draw>
+bool LEDController::drawFrame(unsigned char *out, ChannelMask free, Draw &&draw) const
+{
+    // Invalid and locked LEDs keep their intensity, free LEDs draw in [min, max].
+    //
+    // Power is that of the calibrated bytes actually sent. With a power budget,
+    // locked LEDs and minimums use up budget first; if the draw exceeds the
+    // rest, each radiating LED's power above its minimum is scaled down onto
+    // the budget boundary (the largest level whose calibrated power fits), so
+    // no retries are needed.
+    const auto calibration = calibration_.load();
+    float available = powerBudget_;
+    float power = 0;
+    for (size_t i = 0; i < leds_.size(); ++i)
     {
-        if (led.getPeakWavelength() != 0)
+        const auto &led = leds_[i];
+        const float w = std::max(led.getMaxRadiation(), 0.0f) / 255.0f;
+        const unsigned char *table = calibration->getTable(i);
+        if (led.getPeakWavelength() == 0 || led.isLocked() || !isFree(free, i))
         {
-            led.randomizeIntensity();
+            out[i] = led.getIntensity();
+            available -= w * table[out[i]];
+            continue;
         }
+        const int lo = std::min(led.getMinIntensity(), led.getMaxIntensity());
+        const int span = led.getMaxIntensity() - lo;
+        const int extra = draw(span);
+        out[i] = static_cast<unsigned char>(lo + extra);
+        available -= w * table[lo];
+        power += w * std::max(table[out[i]] - table[lo], 0);
     }
+    if (powerBudget_ <= 0 || power <= available)
+        return true;
+
+    const float scale = available > 0 ? available / power : 0.0f;
+    for (size_t i = 0; i < leds_.size(); ++i)
+    {
+        const auto &led = leds_[i];
+        if (led.getPeakWavelength() == 0 || led.isLocked() || !isFree(free, i) || led.getMaxRadiation() <= 0)
+            continue;
+        const unsigned char *table = calibration->getTable(i);
+        const int lo = std::min(led.getMinIntensity(), led.getMaxIntensity());
+        // 从线性缩放的级别出发，调整到不超过缩放后功率的最大级别；表不一定单调，lo 总是满足
+        const float limit = std::max(table[out[i]] - table[lo], 0) * scale;
+        const int drawn = out[i];
+        int v = lo + static_cast<int>((drawn - lo) * scale); // 线性表时即为结果
+        while (v > lo && table[v] - table[lo] > limit)
+            --v;
+        while (v < drawn && table[v + 1] - table[lo] <= limit)
+            ++v;
+        out[i] = static_cast<unsigned char>(v);
+    }
+    return available >= 0;
+}
+
+void LEDController::setPowerBudget(float budget)
+{
+    powerBudget_ = budget;
+}
+
+float LEDController::getPowerBudget() const
+{
+    return powerBudget_;
+}
+
+float LEDController::getFramePower() const
+{
+    // Of the calibrated frame, as sent
+    const auto calibration = calibration_.load();
+    float power = 0;
+    for (size_t i = 0; i < leds_.size(); ++i)
+        power += std::max(leds_[i].getMaxRadiation(), 0.0f) / 255.0f * calibration->getTable(i)[leds_[i].getIntensity()];
+    return power;
+}
+
+std::vector<unsigned char> LEDController::getCalibratedData() const
+{
+    // Whole-frame gather through the per-channel tables
+    auto data = getIntensityData();
+    calibration_.load()->apply(data.data(), data.data(), data.size());
+    return data;
 }
 
 std::vector<unsigned char> LEDController::getIntensityData() const
@@ -121,6 +366,41 @@ std::vector<unsigned char> LEDController::getIntensityData() const
     return data;
 }
 
+uint64_t LEDController::publish()
+{
+    TRACE_SPAN("publish");
+    auto data = getCalibratedData();
+    uint64_t version = frame_.version();
+    if (data != published_ || version == 0)
+    {
+        published_ = std::move(data);
+        version = frame_.publish(published_.data());
+    }
+    // 已发布帧仍是最后一次采样的结果时，记录它在序列中的位置
+    if (!sampleFrame_.empty() && getIntensityData() == sampleFrame_)
+    {
+        const auto current = sample_.load();
+        if (!current || current->version != version)
+            sample_.store(std::make_shared<const PublishedSample>(PublishedSample{version, sampleTag_, published_}));
+    }
+    else if (sample_.load())
+    {
+        sample_.store(nullptr);
+    }
+    return version;
+}
+
+uint64_t LEDController::readFrame(std::vector<unsigned char> &out) const
+{
+    out.resize(frame_.size());
+    return frame_.read(out.data());
+}
+
+uint64_t LEDController::frameVersion() const
+{
+    return frame_.version();
+}
+
 bool LEDController::saveMaxIntensities(const std::string &filename) const
 {
     std::ofstream ofs(filename, std::ios::out | std::ios::trunc);
@@ -130,26 +410,266 @@ bool LEDController::saveMaxIntensities(const std::string &filename) const
     {
         ofs << led.getId() << " " << static_cast<int>(led.getMaxIntensity()) << "\n";
     }
+    // 与原配置文件格式一致：千位分隔符 + us
+    const std::string digits = std::to_string(integrationUs_);
+    std::string grouped;
+    for (size_t i = 0; i < digits.size(); ++i)
+    {
+        if (i > 0 && (digits.size() - i) % 3 == 0)
+            grouped += ',';
+        grouped += digits[i];
+    }
+    ofs << "\nIntegrate time: " << grouped << "us\n";
     return true;
 }
 
 bool LEDController::loadMaxIntensities(const std::string &filename)
+{
+    Limits limits;
+    std::vector<std::string> warnings;
+    if (!parseMaxIntensities(filename, limits, warnings))
+        return false;
+    for (const auto &warning : warnings)
+        std::cerr << "Warning: " << warning << ". Skipping.\n";
+    applyLimits(limits);
+    return true;
+}
+
+bool LEDController::parseMaxIntensities(const std::string &filename, Limits &limits,
+                                        std::vector<std::string> &warnings) const
 {
     std::ifstream ifs(filename);
     if (!ifs.is_open())
         return false;
-    int id, maxIntensity;
-    while (ifs >> id >> maxIntensity)
+    limits = Limits();
+    std::string line;
+    while (std::getline(ifs, line))
     {
+        // "Integrate time: 200,000us"
+        if (line.rfind("Integrate time:", 0) == 0)
+        {
+            std::string digits;
+            for (char c : line.substr(15))
+            {
+                if (c >= '0' && c <= '9')
+                    digits += c;
+                else if (c != ',' && c != ' ')
+                    break;
+            }
+            if (!digits.empty() && digits.size() <= 9)
+            {
+                limits.hasIntegrationTime = true;
+                limits.integrationUs = static_cast<uint32_t>(std::stoul(digits));
+            }
+            else
+            {
+                warnings.push_back("invalid integration time '" + line + "'");
+            }
+            continue;
+        }
+        std::istringstream iss(line);
+        int id, maxIntensity;
+        if (!(iss >> id >> maxIntensity))
+            continue;
+        size_t index = 0;
         try
         {
-            getById(id).setMaxIntensity(static_cast<unsigned char>(maxIntensity));
+            index = indexOf(id);
         }
         catch (...)
         {
-            // Ignore unknown LED IDs
-            std::cerr << "Warning: LED ID " << id << " not found. Skipping.\n";
+            warnings.push_back("LED ID " + std::to_string(id) + " not found");
+            continue;
         }
+        if (maxIntensity < 0 || maxIntensity > 255)
+            warnings.push_back("max intensity " + std::to_string(maxIntensity) + " of LED " + std::to_string(id) +
+                               " is out of range");
+        else
+            limits.maxIntensity.emplace_back(index, static_cast<unsigned char>(maxIntensity));
     }
     return true;
-}
\ No newline at end of file
+}
+
+void LEDController::applyLimits(const Limits &limits)
+{
+    for (const auto &[index, maxIntensity] : limits.maxIntensity)
+        leds_[index].setMaxIntensity(maxIntensity);
+    if (limits.hasIntegrationTime)
+        integrationUs_ = limits.integrationUs;
+}
+
+void LEDController::setIntegrationTime(uint32_t us)
+{
+    integrationUs_ = us;
+}
+
+uint32_t LEDController::getIntegrationTime() const
+{
+    return integrationUs_;
+}
+
+void LEDController::setSettleTime(uint32_t us)
+{
+    settleUs_ = us;
+}
+
+uint32_t LEDController::getSettleTime() const
+{
+    return settleUs_;
+}
+
+void LEDController::setSpectralGrid(float startNm, float stepNm, size_t points)
+{
+    spectralModel_ = std::make_unique<SpectralModel>(*this, startNm, stepNm, points);
+}
+
+const SpectralModel &LEDController::getSpectralModel() const
+{
+    return *spectralModel_;
+}
+
+std::vector<float> LEDController::computeSpectrum() const
+{
+    // The LEDs emit the calibrated bytes, not the requested intensities
+    auto data = getCalibratedData();
+    std::vector<float> spectrum(spectralModel_->getPointCount());
+    spectralModel_->evaluate(data.data(), spectrum.data());
+    return spectrum;
+}
+
+bool LEDController::loadCalibration(const std::string &filename)
+{
+    std::string error;
+    auto calibration = parseCalibration(filename, error);
+    if (!calibration)
+    {
+        if (!error.empty())
+            std::cerr << "Error: " << error << ".\n";
+        return false;
+    }
+    calibration_.store(std::move(calibration));
+    return true;
+}
+
+std::shared_ptr<const Calibration> LEDController::parseCalibration(const std::string &filename,
+                                                                   std::string &error) const
+{
+    std::ifstream ifs(filename);
+    if (!ifs.is_open())
+        return nullptr;
+
+    // Reference for radiometric curves: the weakest LED with radiation data
+    float minRadiation = 0;
+    for (const auto &led : leds_)
+    {
+        if (led.getMaxRadiation() > 0 && (minRadiation == 0 || led.getMaxRadiation() < minRadiation))
+            minRadiation = led.getMaxRadiation();
+    }
+
+    auto calibration = std::make_shared<Calibration>(leds_.size());
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(ifs, line))
+    {
+        ++lineNo;
+        auto hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+        std::istringstream iss(line);
+        std::string target, kind;
+        if (!(iss >> target))
+            continue;
+        iss >> kind;
+
+        std::vector<size_t> channels;
+        if (target == "all")
+        {
+            for (size_t i = 0; i < leds_.size(); ++i)
+                channels.push_back(i);
+        }
+        else
+        {
+            try
+            {
+                channels.push_back(indexOf(std::stoi(target)));
+            }
+            catch (...)
+            {
+                error = filename + ":" + std::to_string(lineNo) + ": unknown LED id '" + target + "'";
+                return nullptr;
+            }
+        }
+
+        bool ok = true;
+        if (kind == "identity")
+        {
+            for (auto c : channels)
+                calibration->setIdentity(c);
+        }
+        else if (kind == "gamma")
+        {
+            float gamma = 0;
+            ok = static_cast<bool>(iss >> gamma) && gamma > 0;
+            if (ok)
+                for (auto c : channels)
+                    calibration->setGamma(c, gamma);
+        }
+        else if (kind == "radiometric")
+        {
+            float gamma = 1, reference = minRadiation;
+            if (iss >> gamma)
+                iss >> reference;
+            ok = gamma > 0 && reference > 0;
+            if (ok)
+                for (auto c : channels)
+                    calibration->setRadiometric(c, gamma, leds_[c].getMaxRadiation(), reference);
+        }
+        else if (kind == "table")
+        {
+            unsigned char table[256];
+            int v = 0, n = 0;
+            while (n < 256 && iss >> v && v >= 0 && v <= 255)
+                table[n++] = static_cast<unsigned char>(v);
+            ok = (n == 256);
+            if (ok)
+                for (auto c : channels)
+                    calibration->setTable(c, table);
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            error = filename + ":" + std::to_string(lineNo) + ": invalid calibration entry";
+            return nullptr;
+        }
+    }
+
+    return calibration;
+}
+
+void LEDController::setCalibration(std::shared_ptr<const Calibration> calibration)
+{
+    calibration_.store(std::move(calibration));
+}
+
+void LEDController::clearCalibration()
+{
+    calibration_.store(std::make_shared<const Calibration>(leds_.size()));
+}
+
+std::shared_ptr<const Calibration> LEDController::getCalibration() const
+{
+    return calibration_.load();
+}
+
+size_t LEDController::indexOf(int id) const
+{
+    for (size_t i = 0; i < leds_.size(); ++i)
+    {
+        if (leds_[i].getId() == id)
+            return i;
+    }
+    throw std::out_of_range("LED id not found");
+}
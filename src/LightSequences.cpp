@@ -0,0 +1,100 @@
+#include "LightSequences.h"
+#include "LEDController.h"
+#include "FramePacket.h"
+#include <algorithm>
+
+std::vector<unsigned char> SequenceOverlay::buildPacket(const LEDController &controller) const
+{
+    std::vector<unsigned char> frame;
+    controller.readFrame(frame); // 已发布帧已经过校准
+    auto calibration = controller.getCalibration();
+    for (size_t i = 0; i < frame.size() && i < value.size(); ++i)
+        if (active[i])
+            frame[i] = calibration->getTable(i)[value[i]];
+    std::vector<unsigned char> packet;
+    FramePacket::build(frame.data(), frame.size(), packet);
+    return packet;
+}
+
+namespace
+{
+    // 序列占用一个通道；正常结束或协程帧被销毁（co -e）时释放
+    struct ChannelClaim
+    {
+        ChannelClaim(SequenceOverlay &overlay, size_t channel) : overlay(overlay), channel(channel)
+        {
+            ++overlay.active[channel];
+        }
+        ~ChannelClaim() { --overlay.active[channel]; }
+        ChannelClaim(const ChannelClaim &) = delete;
+        ChannelClaim &operator=(const ChannelClaim &) = delete;
+
+        SequenceOverlay &overlay;
+        size_t channel;
+    };
+}
+
+namespace LightSequences
+{
+    using Clock = CoroutineExecutor::Clock;
+
+    CoroutineExecutor::Task ramp(CoroutineExecutor &executor, const LEDController &controller,
+                                 std::shared_ptr<SequenceOverlay> overlay, size_t channel, int from, int to,
+                                 unsigned durationMs, unsigned stepMs)
+    {
+        const unsigned steps = std::max(1u, durationMs / std::max(1u, stepMs));
+        auto next = Clock::now();
+        {
+            ChannelClaim claim(*overlay, channel);
+            for (unsigned i = 0; i <= steps; ++i)
+            {
+                overlay->value[channel] = static_cast<unsigned char>(from + (to - from) * static_cast<int>(i) / static_cast<int>(steps));
+                co_await executor.send(overlay->buildPacket(controller));
+                next += std::chrono::milliseconds(stepMs);
+                co_await executor.sleepUntil(next);
+            }
+        }
+        // 通道交还给已发布帧
+        co_await executor.send(overlay->buildPacket(controller));
+    }
+
+    CoroutineExecutor::Task pulse(CoroutineExecutor &executor, const LEDController &controller,
+                                  std::shared_ptr<SequenceOverlay> overlay, size_t channel, int value, unsigned onMs,
+                                  unsigned offMs, unsigned count)
+    {
+        auto next = Clock::now();
+        {
+            ChannelClaim claim(*overlay, channel);
+            for (unsigned i = 0; count == 0 || i < count; ++i)
+            {
+                overlay->value[channel] = static_cast<unsigned char>(value);
+                co_await executor.send(overlay->buildPacket(controller));
+                next += std::chrono::milliseconds(onMs);
+                co_await executor.sleepUntil(next);
+                overlay->value[channel] = 0;
+                co_await executor.send(overlay->buildPacket(controller));
+                next += std::chrono::milliseconds(offMs);
+                co_await executor.sleepUntil(next);
+            }
+        }
+        co_await executor.send(overlay->buildPacket(controller));
+    }
+
+    CoroutineExecutor::Task replay(CoroutineExecutor &executor, std::vector<unsigned char> packets, size_t packetSize,
+                                   unsigned periodMs, unsigned loops)
+    {
+        // 按绝对时间表推进，发送耗时不会累积
+        auto next = Clock::now();
+        const size_t count = packets.size() / packetSize;
+        for (unsigned loop = 0; loops == 0 || loop < loops; ++loop)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                co_await executor.send(std::vector<unsigned char>(packets.begin() + i * packetSize,
+                                                                  packets.begin() + (i + 1) * packetSize));
+                next += std::chrono::milliseconds(periodMs);
+                co_await executor.sleepUntil(next);
+            }
+        }
+    }
+}
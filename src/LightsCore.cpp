@@ -0,0 +1,257 @@
+#include "LightsCore.h"
+#include "LEDController.h"
+#include "SerialInterface.h"
+#include "FramePacket.h"
+#include "FrameProtocol.h"
+#include "Recorder.h"
+#include <vector>
+
+struct lc_device
+{
+    LEDController controller;
+    SerialInterface serial;
+    Recorder recorder;
+    FrameProtocol::Format format = FrameProtocol::Format::Raw8;
+    uint8_t counter = 0;
+    std::vector<unsigned char> batch; // reused between submissions
+    std::vector<unsigned char> wire;
+};
+
+namespace
+{
+    // Sends count canonical packets from dev->batch in the device's wire format
+    bool sendBatch(lc_device *dev, size_t count, size_t frameSize)
+    {
+        if (dev->format == FrameProtocol::Format::Raw8)
+        {
+            dev->counter = static_cast<uint8_t>(dev->counter + count);
+            return dev->serial.sendData(dev->batch);
+        }
+        size_t size = FrameProtocol::encodeBatch(dev->format, dev->batch.data(), count, frameSize, dev->counter, dev->wire);
+        return dev->serial.sendData(dev->wire.data(), size);
+    }
+
+    // 异常不能穿过 C 接口
+    template <typename Fn>
+    auto guarded(Fn fn) -> decltype(fn())
+    {
+        try
+        {
+            return fn();
+        }
+        catch (const std::out_of_range &)
+        {
+            return LC_ERR_NOT_FOUND;
+        }
+        catch (...)
+        {
+            return LC_ERR_INTERNAL;
+        }
+    }
+}
+
+int lc_api_version(void)
+{
+    return LC_API_VERSION;
+}
+
+lc_device *lc_create(void)
+{
+    try
+    {
+        return new lc_device;
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void lc_destroy(lc_device *dev)
+{
+    delete dev;
+}
+
+int lc_open(lc_device *dev, const char *port)
+{
+    if (!dev || !port)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   { return dev->serial.open(port) ? LC_OK : LC_ERR_IO; });
+}
+
+void lc_close(lc_device *dev)
+{
+    if (dev)
+        dev->serial.close();
+}
+
+int lc_led_count(const lc_device *dev)
+{
+    return dev ? static_cast<int>(dev->controller.getLedCount()) : LC_ERR_INVALID_ARG;
+}
+
+int lc_set_intensity(lc_device *dev, int id, int value)
+{
+    if (!dev || value < 0 || value > 255)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   {
+        dev->controller.getById(id).setIntensity(static_cast<unsigned char>(value));
+        return LC_OK; });
+}
+
+int lc_get_intensity(const lc_device *dev, int id)
+{
+    if (!dev)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   { return static_cast<int>(dev->controller.getById(id).getIntensity()); });
+}
+
+int lc_set_max_intensity(lc_device *dev, int id, int value)
+{
+    if (!dev || value < 0 || value > 255)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   {
+        dev->controller.getById(id).setMaxIntensity(static_cast<unsigned char>(value));
+        return LC_OK; });
+}
+
+int lc_set_frame(lc_device *dev, const unsigned char *intensities)
+{
+    if (!dev || !intensities)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   {
+        for (size_t i = 0; i < dev->controller.getLedCount(); ++i)
+            dev->controller.getById(static_cast<int>(i + 1)).setIntensity(intensities[i]);
+        return LC_OK; });
+}
+
+int lc_randomize(lc_device *dev)
+{
+    if (!dev)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   { return dev->controller.randomizeAll() ? LC_OK : LC_ERR_INVALID_ARG; });
+}
+
+int lc_load_max_intensities(lc_device *dev, const char *path)
+{
+    if (!dev || !path)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   { return dev->controller.loadMaxIntensities(path) ? LC_OK : LC_ERR_IO; });
+}
+
+int lc_load_calibration(lc_device *dev, const char *path)
+{
+    if (!dev || !path)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   { return dev->controller.loadCalibration(path) ? LC_OK : LC_ERR_IO; });
+}
+
+int lc_send(lc_device *dev)
+{
+    if (!dev)
+        return LC_ERR_INVALID_ARG;
+    if (!dev->serial.isOpen())
+        return LC_ERR_NOT_OPEN;
+    return guarded([&]
+                   {
+        uint64_t version = dev->controller.publish();
+        std::vector<unsigned char> data;
+        dev->controller.readFrame(data);
+        FramePacket::build(data.data(), data.size(), dev->batch);
+        if (!sendBatch(dev, 1, data.size()))
+            return LC_ERR_IO;
+        dev->recorder.write(dev->batch.data(), dev->batch.size(), version);
+        return LC_OK; });
+}
+
+long long lc_submit_frames(lc_device *dev, const unsigned char *frames, size_t count)
+{
+    if (!dev || (!frames && count))
+        return LC_ERR_INVALID_ARG;
+    if (!dev->serial.isOpen())
+        return LC_ERR_NOT_OPEN;
+    if (count == 0)
+        return 0;
+    return guarded([&]() -> long long
+                   {
+        const size_t frameSize = dev->controller.getLedCount();
+        const size_t packetSize = FramePacket::kHeaderSize + frameSize;
+        auto calibration = dev->controller.getCalibration();
+        FramePacket::buildBatch(frames, count, frameSize, calibration.get(), dev->batch);
+        if (!sendBatch(dev, count, frameSize))
+            return LC_ERR_IO;
+        if (dev->recorder.isOpen())
+        {
+            for (size_t i = 0; i < count; ++i)
+                dev->recorder.write(dev->batch.data() + i * packetSize, packetSize, 0);
+        }
+        return static_cast<long long>(count); });
+}
+
+long long lc_submit_levels(lc_device *dev, const unsigned short *levels, size_t count)
+{
+    if (!dev || (!levels && count))
+        return LC_ERR_INVALID_ARG;
+    if (!dev->serial.isOpen())
+        return LC_ERR_NOT_OPEN;
+    if (count == 0)
+        return 0;
+    return guarded([&]() -> long long
+                   {
+        const auto &op = FrameProtocol::ops(dev->format);
+        const size_t frameSize = dev->controller.getLedCount();
+        const size_t wireSize = op.packetSize(frameSize);
+        if (dev->wire.size() < count * wireSize)
+            dev->wire.resize(count * wireSize);
+        for (size_t i = 0; i < count; ++i)
+            op.encode16(levels + i * frameSize, frameSize, dev->counter++, dev->wire.data() + i * wireSize);
+        if (!dev->serial.sendData(dev->wire.data(), count * wireSize))
+            return LC_ERR_IO;
+        if (dev->recorder.isOpen())
+        {
+            // 记录文件保存 8 位标准格式：取高 8 位
+            std::vector<unsigned char> frame(frameSize);
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (size_t j = 0; j < frameSize; ++j)
+                    frame[j] = static_cast<unsigned char>((levels[i * frameSize + j] & ((1u << op.bits) - 1)) >> (op.bits - 8));
+                FramePacket::build(frame.data(), frameSize, dev->batch);
+                dev->recorder.write(dev->batch.data(), dev->batch.size(), 0);
+            }
+        }
+        return static_cast<long long>(count); });
+}
+
+int lc_set_format(lc_device *dev, const char *format)
+{
+    if (!dev || !format)
+        return LC_ERR_INVALID_ARG;
+    FrameProtocol::Format parsed;
+    if (!FrameProtocol::parseFormat(format, parsed))
+        return LC_ERR_INVALID_ARG;
+    dev->format = parsed;
+    dev->counter = 0;
+    return LC_OK;
+}
+
+int lc_record_start(lc_device *dev, const char *path)
+{
+    if (!dev || !path)
+        return LC_ERR_INVALID_ARG;
+    return guarded([&]
+                   { return dev->recorder.open(path) ? LC_OK : LC_ERR_IO; });
+}
+
+void lc_record_stop(lc_device *dev)
+{
+    if (dev)
+        dev->recorder.close();
+}
@@ -0,0 +1,112 @@
+#include "LoadTest.h"
+#include "ControlClient.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+    constexpr unsigned char kFrameSize = 30;
+
+    struct PhaseResult
+    {
+        uint64_t ok = 0;
+        uint64_t sent = 0;
+        uint64_t errors = 0;
+        double seconds = 0;
+    };
+
+    template <typename Body>
+    PhaseResult runPhase(uint16_t port, int clients, int seconds, Body body)
+    {
+        std::atomic<uint64_t> ok{0}, sent{0}, errors{0};
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::seconds(seconds);
+        for (int c = 0; c < clients; ++c)
+        {
+            threads.emplace_back([&, c]
+                                 {
+                ControlClient client;
+                if (!client.connect(port))
+                {
+                    ++errors;
+                    return;
+                }
+                std::mt19937 rng(c + 1);
+                while (std::chrono::steady_clock::now() < deadline)
+                {
+                    long long n = body(client, rng);
+                    if (n < 0)
+                    {
+                        ++errors;
+                        break;
+                    }
+                    ++ok;
+                    sent += static_cast<uint64_t>(n);
+                } });
+        }
+        for (auto &t : threads)
+            t.join();
+        PhaseResult r;
+        r.ok = ok;
+        r.sent = sent;
+        r.errors = errors;
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return r;
+    }
+}
+
+int runLoadTest(const std::vector<std::string> &args)
+{
+    // loadtest [port] [clients] [seconds] [batch]
+    int port = ControlProtocol::kDefaultPort, clients = 4, seconds = 5, batch = 256;
+    try
+    {
+        if (args.size() > 1)
+            port = std::stoi(args[1]);
+        if (args.size() > 2)
+            clients = std::stoi(args[2]);
+        if (args.size() > 3)
+            seconds = std::stoi(args[3]);
+        if (args.size() > 4)
+            batch = std::stoi(args[4]);
+    }
+    catch (...)
+    {
+        port = -1;
+    }
+    if (port <= 0 || port > 65535 || clients <= 0 || seconds <= 0 || batch <= 0 ||
+        batch > static_cast<int>(ControlProtocol::kMaxBatchFrames))
+    {
+        std::cout << "[Usage] loadtest [port] [clients] [seconds] [batch]\n";
+        return 1;
+    }
+
+    std::cout << "[Info] Load test against 127.0.0.1:" << port << ", " << clients << " clients, "
+              << seconds << " s per phase, " << batch << " frames per batch.\n";
+
+    // 阶段1：文本命令
+    auto cmd = runPhase(static_cast<uint16_t>(port), clients, seconds, [](ControlClient &client, std::mt19937 &rng) -> long long
+                        { return client.sendCommand("set l1 " + std::to_string(rng() % 256)) ? 1 : -1; });
+    std::cout << "[Info] Commands: " << cmd.ok << " in " << cmd.seconds << " s = "
+              << static_cast<uint64_t>(cmd.ok / cmd.seconds) << " commands/s, " << cmd.errors << " errors\n";
+
+    // 阶段2：二进制帧批量
+    std::vector<unsigned char> frames(static_cast<size_t>(batch) * kFrameSize);
+    std::mt19937 fill(12345);
+    for (auto &b : frames)
+        b = static_cast<unsigned char>(fill() & 0xFF);
+    auto frm = runPhase(static_cast<uint16_t>(port), clients, seconds, [&frames, batch](ControlClient &client, std::mt19937 &rng)
+                        {
+        (void)rng;
+        return client.sendFrames(frames.data(), static_cast<uint32_t>(batch), kFrameSize); });
+    uint64_t submitted = frm.ok * static_cast<uint64_t>(batch);
+    std::cout << "[Info] Frames: " << submitted << " submitted in " << frm.seconds << " s = "
+              << static_cast<uint64_t>(submitted / frm.seconds) << " frames/s ("
+              << static_cast<uint64_t>(frm.ok / frm.seconds) << " batches/s), "
+              << frm.sent << " sent to serial, " << frm.errors << " errors\n";
+    return (cmd.errors || frm.errors) ? 1 : 0;
+}
@@ -0,0 +1,331 @@
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    uint64_t nowUs()
+    {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const char *const kLevelNames[] = {"trace", "debug", "info", "warn", "error", "off"};
+    const char *const kLevelTags[] = {"[Trace]", "[Debug]", "[Info]", "[Warning]", "[Error]", ""};
+    const char *const kCategoryNames[] = {"general", "serial", "record", "replay", "command"};
+}
+
+Logger &Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : slots_(kCapacity)
+{
+    // 默认 info：逐帧的 debug/trace 输出保持静默
+    for (auto &level : levels_)
+        level.store(static_cast<uint8_t>(Level::Info), std::memory_order_relaxed);
+    for (size_t i = 0; i < kCapacity; ++i)
+        slots_[i].seq.store(i, std::memory_order_relaxed);
+    nowUs();
+    sink_ = std::thread(&Logger::sinkLoop, this);
+}
+
+Logger::~Logger()
+{
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (sink_.joinable())
+        sink_.join();
+}
+
+Logger::Slot *Logger::claim()
+{
+    // Bounded MPSC ring: a slot is free for position pos when its seq == pos
+    uint64_t pos = head_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Slot &slot = slots_[pos & (kCapacity - 1)];
+        const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+        if (diff == 0)
+        {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                return &slot;
+        }
+        else if (diff < 0)
+        {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::commit(Slot *slot)
+{
+    // claim() returned the slot while its seq was the claimed position
+    const uint64_t pos = slot->seq.load(std::memory_order_relaxed);
+    slot->seq.store(pos + 1, std::memory_order_release);
+    if (sinkWaiting_.load())
+        wake_.notify_one();
+}
+
+void Logger::log(Category category, Level level, const std::string &message)
+{
+    if (!enabled(category, level))
+        return;
+    Slot *slot = claim();
+    if (!slot)
+        return;
+    slot->timeUs = nowUs();
+    slot->prefix = nullptr;
+    slot->level = level;
+    slot->category = category;
+    slot->hex = false;
+    slot->size = static_cast<uint16_t>(std::min(message.size(), kPayloadSize));
+    slot->fullSize = slot->size;
+    std::memcpy(slot->payload, message.data(), slot->size);
+    commit(slot);
+}
+
+void Logger::logBytes(Category category, Level level, const char *prefix, const unsigned char *data, size_t size)
+{
+    if (!enabled(category, level))
+        return;
+    Slot *slot = claim();
+    if (!slot)
+        return;
+    slot->timeUs = nowUs();
+    slot->prefix = prefix;
+    slot->level = level;
+    slot->category = category;
+    slot->hex = true;
+    slot->size = static_cast<uint16_t>(std::min(size, kPayloadSize));
+    slot->fullSize = static_cast<uint16_t>(std::min<size_t>(size, UINT16_MAX));
+    std::memcpy(slot->payload, data, slot->size);
+    commit(slot);
+}
+
+void Logger::sinkLoop()
+{
+    while (true)
+    {
+        bool drainedAny = false;
+        while (true)
+        {
+            Slot &slot = slots_[tail_ & (kCapacity - 1)];
+            if (slot.seq.load(std::memory_order_acquire) != tail_ + 1)
+                break;
+            write(slot);
+            slot.seq.store(tail_ + kCapacity, std::memory_order_release);
+            ++tail_;
+            drainedAny = true;
+        }
+        if (drainedAny)
+        {
+            std::cout.flush();
+            {
+                std::lock_guard<std::mutex> lock(fileMutex_);
+                if (file_.is_open())
+                    file_.flush();
+            }
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex_);
+                written_.store(tail_);
+            }
+            drained_.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex_);
+        if (stopping_)
+            break;
+        // 带超时的等待，避免与生产者之间丢失唤醒
+        sinkWaiting_.store(true);
+        wake_.wait_for(lock, std::chrono::milliseconds(50));
+        sinkWaiting_.store(false);
+    }
+}
+
+std::string Logger::format(const Slot &slot) const
+{
+    std::string line = kLevelTags[static_cast<size_t>(slot.level)];
+    line += '[';
+    line += kCategoryNames[static_cast<size_t>(slot.category)];
+    line += "] ";
+    if (!slot.hex)
+    {
+        line.append(reinterpret_cast<const char *>(slot.payload), slot.size);
+        return line;
+    }
+    static const char digits[] = "0123456789ABCDEF";
+    if (slot.prefix)
+        line += slot.prefix;
+    for (size_t i = 0; i < slot.size; ++i)
+    {
+        line += (i == 0 && !slot.prefix) ? "" : " ";
+        line += digits[slot.payload[i] >> 4];
+        line += digits[slot.payload[i] & 0x0F];
+    }
+    if (slot.fullSize > slot.size)
+        line += " ... (" + std::to_string(slot.fullSize) + " bytes)";
+    return line;
+}
+
+void Logger::write(const Slot &slot)
+{
+    const std::string line = format(slot);
+    {
+        std::lock_guard<std::mutex> lock(fileMutex_);
+        if (file_.is_open())
+        {
+            char stamp[32];
+            std::snprintf(stamp, sizeof(stamp), "%10.6f ", slot.timeUs / 1e6);
+            file_ << stamp << line << '\n';
+        }
+    }
+
+    // 控制台限速：每秒最多 consoleRate_ 行，超出的只写入日志文件
+    const unsigned rate = consoleRate_.load(std::memory_order_relaxed);
+    if (slot.timeUs >= windowStartUs_ + 1000000)
+    {
+        const uint64_t suppressed = suppressed_.load(std::memory_order_relaxed);
+        if (suppressed > reportedSuppressed_)
+        {
+            std::cout << "[Warning][log] " << (suppressed - reportedSuppressed_)
+                      << " messages suppressed by the console rate limit.\n";
+            reportedSuppressed_ = suppressed;
+        }
+        windowStartUs_ = slot.timeUs;
+        windowLines_ = 0;
+    }
+    if (rate != 0 && windowLines_ >= rate)
+    {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ++windowLines_;
+    std::cout << line << '\n';
+}
+
+void Logger::flush()
+{
+    const uint64_t target = head_.load();
+    std::unique_lock<std::mutex> lock(wakeMutex_);
+    wake_.notify_one();
+    while (written_.load() < target)
+        drained_.wait_for(lock, std::chrono::milliseconds(50));
+}
+
+void Logger::setLevel(Level level)
+{
+    for (auto &l : levels_)
+        l.store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+void Logger::setLevel(Category category, Level level)
+{
+    levels_[static_cast<size_t>(category)].store(static_cast<uint8_t>(level), std::memory_order_relaxed);
+}
+
+Logger::Level Logger::getLevel(Category category) const
+{
+    return static_cast<Level>(levels_[static_cast<size_t>(category)].load(std::memory_order_relaxed));
+}
+
+bool Logger::openFile(const std::string &path)
+{
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (file_.is_open())
+        file_.close();
+    file_.open(path, std::ios::out | std::ios::app);
+    if (!file_.is_open())
+    {
+        filePath_.clear();
+        return false;
+    }
+    filePath_ = path;
+    return true;
+}
+
+void Logger::closeFile()
+{
+    flush();
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    if (file_.is_open())
+        file_.close();
+    filePath_.clear();
+}
+
+std::string Logger::getFilePath() const
+{
+    std::lock_guard<std::mutex> lock(fileMutex_);
+    return filePath_;
+}
+
+void Logger::setConsoleRate(unsigned linesPerSecond)
+{
+    consoleRate_.store(linesPerSecond, std::memory_order_relaxed);
+}
+
+unsigned Logger::getConsoleRate() const
+{
+    return consoleRate_.load(std::memory_order_relaxed);
+}
+
+uint64_t Logger::getDropped() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
+
+uint64_t Logger::getSuppressed() const
+{
+    return suppressed_.load(std::memory_order_relaxed);
+}
+
+const char *Logger::levelName(Level level)
+{
+    return kLevelNames[static_cast<size_t>(level)];
+}
+
+const char *Logger::categoryName(Category category)
+{
+    return kCategoryNames[static_cast<size_t>(category)];
+}
+
+bool Logger::parseLevel(const std::string &name, Level &level)
+{
+    for (size_t i = 0; i <= static_cast<size_t>(Level::Off); ++i)
+    {
+        if (name == kLevelNames[i])
+        {
+            level = static_cast<Level>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Logger::parseCategory(const std::string &name, Category &category)
+{
+    for (size_t i = 0; i < static_cast<size_t>(Category::Count); ++i)
+    {
+        if (name == kCategoryNames[i])
+        {
+            category = static_cast<Category>(i);
+            return true;
+        }
+    }
+    return false;
+}
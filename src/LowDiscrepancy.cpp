@@ -0,0 +1,266 @@
+#include "LowDiscrepancy.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace
+{
+    constexpr size_t kBits = 32;
+    constexpr size_t kMaxDigits = 32; // base 2 needs 32 digits for 2^32 points
+
+    constexpr uint16_t kPrimes[LowDiscrepancySequence::kMaxDims] = {
+        2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53,
+        59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131,
+        137, 139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223,
+        227, 229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311};
+
+    uint64_t splitmix(uint64_t x)
+    {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    uint32_t reverseBits(uint32_t x)
+    {
+        x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+        x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+        x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+        x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+        return (x >> 16) | (x << 16);
+    }
+
+    // Nested uniform scramble of a 32-bit fraction: each bit is flipped depending
+    // on all higher bits (Laine-Karras style hash, Burley 2020 constants)
+    uint32_t owenScramble(uint32_t x, uint32_t seed)
+    {
+        x = reverseBits(x);
+        x ^= x * 0x3D20ADEAu;
+        x += seed;
+        x *= (seed >> 16) | 1u;
+        x ^= x * 0x05526C56u;
+        x ^= x * 0x53A22864u;
+        return reverseBits(x);
+    }
+
+    // Order of x modulo the degree-s polynomial p equals 2^s - 1
+    bool isPrimitive(uint32_t p, unsigned s)
+    {
+        const uint32_t period = (1u << s) - 1;
+        uint32_t r = 1;
+        for (uint32_t n = 1; n <= period; ++n)
+        {
+            r <<= 1;
+            if (r >> s & 1)
+                r ^= p;
+            if (r == 1)
+                return n == period;
+        }
+        return false;
+    }
+
+    struct DirectionNumbers
+    {
+        uint32_t v[LowDiscrepancySequence::kMaxDims][kBits];
+
+        DirectionNumbers()
+        {
+            // 第 0 维是 van der Corput；其余维依次取次数递增的本原多项式
+            for (size_t k = 0; k < kBits; ++k)
+                v[0][k] = 1u << (kBits - 1 - k);
+            size_t dim = 1;
+            for (unsigned s = 1; dim < LowDiscrepancySequence::kMaxDims; ++s)
+            {
+                for (uint32_t inner = 0; inner < (1u << (s - 1)) && dim < LowDiscrepancySequence::kMaxDims; ++inner)
+                {
+                    const uint32_t p = (1u << s) | (inner << 1) | 1u;
+                    if (!isPrimitive(p, s))
+                        continue;
+                    // Initial m_k: odd and below 2^k, drawn from a fixed generator
+                    uint64_t m[kBits];
+                    for (size_t k = 0; k < kBits; ++k)
+                    {
+                        if (k < s)
+                        {
+                            m[k] = (splitmix(dim * kBits + k) & ((uint64_t{1} << (k + 1)) - 1)) | 1u;
+                            continue;
+                        }
+                        m[k] = m[k - s] ^ (m[k - s] << s);
+                        for (unsigned j = 1; j < s; ++j)
+                            if (p >> (s - j) & 1)
+                                m[k] ^= m[k - j] << j;
+                    }
+                    for (size_t k = 0; k < kBits; ++k)
+                        v[dim][k] = static_cast<uint32_t>(m[k] << (kBits - 1 - k));
+                    ++dim;
+                }
+            }
+        }
+    };
+
+    const DirectionNumbers &directions()
+    {
+        static const DirectionNumbers table;
+        return table;
+    }
+
+    size_t digitCount(uint16_t base)
+    {
+        // 足够表示 2^32 个点
+        size_t n = 0;
+        for (uint64_t span = 1; span < (uint64_t{1} << 32); span *= base)
+            ++n;
+        return n;
+    }
+
+    struct HaltonTables
+    {
+        size_t digits[LowDiscrepancySequence::kMaxDims];
+        double weight[LowDiscrepancySequence::kMaxDims][kMaxDigits]; // base^-(j+1)
+
+        HaltonTables()
+        {
+            for (size_t d = 0; d < LowDiscrepancySequence::kMaxDims; ++d)
+            {
+                digits[d] = digitCount(kPrimes[d]);
+                double w = 1.0;
+                for (size_t j = 0; j < kMaxDigits; ++j)
+                    weight[d][j] = (w /= kPrimes[d]);
+            }
+        }
+    };
+
+    const HaltonTables &haltonTables()
+    {
+        static const HaltonTables tables;
+        return tables;
+    }
+}
+
+LowDiscrepancySequence::LowDiscrepancySequence(Kind kind, uint32_t seed, uint64_t index) : kind_(kind), seed_(seed)
+{
+    for (size_t d = 0; d < kMaxDims; ++d)
+        scramble_[d] = static_cast<uint32_t>(splitmix((uint64_t{seed} << 8) | d));
+    if (kind_ == Kind::Halton)
+    {
+        // 每维一个数字置换表，所有数位共用
+        digits_.assign(kMaxDims * kMaxDigits, 0);
+        permutations_.resize(kMaxDims);
+        for (size_t d = 0; d < kMaxDims; ++d)
+        {
+            auto &perm = permutations_[d];
+            perm.resize(kPrimes[d]);
+            for (uint16_t i = 0; i < kPrimes[d]; ++i)
+                perm[i] = i;
+            uint64_t state = scramble_[d];
+            for (size_t i = perm.size() - 1; i > 0; --i)
+                std::swap(perm[i], perm[(state = splitmix(state)) % (i + 1)]);
+        }
+    }
+    seek(index);
+}
+
+void LowDiscrepancySequence::seek(uint64_t index)
+{
+    index_ = index;
+    if (kind_ == Kind::Sobol)
+    {
+        const auto &dir = directions();
+        const uint32_t gray = static_cast<uint32_t>(index ^ (index >> 1));
+        for (size_t d = 0; d < kMaxDims; ++d)
+        {
+            uint32_t x = 0;
+            for (uint32_t g = gray; g; g &= g - 1)
+                x ^= dir.v[d][std::countr_zero(g)];
+            sobol_[d] = x;
+        }
+        return;
+    }
+    const auto &tables = haltonTables();
+    for (size_t d = 0; d < kMaxDims; ++d)
+    {
+        uint16_t *digits = &digits_[d * kMaxDigits];
+        uint64_t rest = index;
+        double value = 0;
+        for (size_t j = 0; j < tables.digits[d]; ++j)
+        {
+            digits[j] = static_cast<uint16_t>(rest % kPrimes[d]);
+            rest /= kPrimes[d];
+            value += permutations_[d][digits[j]] * tables.weight[d][j];
+        }
+        halton_[d] = value;
+    }
+}
+
+void LowDiscrepancySequence::next(float *out, size_t dims)
+{
+    dims = std::min(dims, kMaxDims);
+    const uint64_t following = index_ + 1;
+    if (kind_ == Kind::Sobol)
+    {
+        for (size_t d = 0; d < dims; ++d)
+            out[d] = static_cast<float>(owenScramble(sobol_[d], scramble_[d]) >> 8) * (1.0f / 16777216.0f);
+        // Gray 码顺序：相邻两点只差一个方向数
+        const auto &dir = directions();
+        const unsigned bit = std::min<unsigned>(std::countr_zero(following), kBits - 1);
+        for (size_t d = 0; d < kMaxDims; ++d)
+            sobol_[d] ^= dir.v[d][bit];
+        index_ = following;
+        return;
+    }
+
+    for (size_t d = 0; d < dims; ++d)
+        out[d] = std::min(static_cast<float>(halton_[d]), 0x1.fffffep-1f);
+    // 逐维数位加一并进位，只修正变化的数位
+    const auto &tables = haltonTables();
+    for (size_t d = 0; d < kMaxDims; ++d)
+    {
+        uint16_t *digits = &digits_[d * kMaxDigits];
+        const auto &perm = permutations_[d];
+        const uint16_t top = kPrimes[d] - 1;
+        size_t j = 0;
+        for (; j < tables.digits[d] && digits[j] == top; ++j)
+        {
+            halton_[d] += (static_cast<double>(perm[0]) - perm[top]) * tables.weight[d][j];
+            digits[j] = 0;
+        }
+        if (j < tables.digits[d])
+        {
+            halton_[d] += (static_cast<double>(perm[digits[j] + 1]) - perm[digits[j]]) * tables.weight[d][j];
+            ++digits[j];
+        }
+    }
+    index_ = following;
+}
+
+LowDiscrepancySequence::Kind LowDiscrepancySequence::getKind() const
+{
+    return kind_;
+}
+
+uint32_t LowDiscrepancySequence::getSeed() const
+{
+    return seed_;
+}
+
+uint64_t LowDiscrepancySequence::index() const
+{
+    return index_;
+}
+
+const char *LowDiscrepancySequence::name(Kind kind)
+{
+    return kind == Kind::Sobol ? "sobol" : "halton";
+}
+
+bool LowDiscrepancySequence::parse(const std::string &name, Kind &kind)
+{
+    if (name == "sobol")
+        kind = Kind::Sobol;
+    else if (name == "halton")
+        kind = Kind::Halton;
+    else
+        return false;
+    return true;
+}
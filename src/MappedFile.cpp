@@ -0,0 +1,144 @@
+#include "MappedFile.h"
+#include <windows.h>
+#include <algorithm>
+
+class MappedFile::MappedFileImpl
+{
+public:
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMapping = nullptr;
+    unsigned char *view = nullptr;
+    uint64_t size = 0;
+    bool open = false;
+};
+
+MappedFile::MappedFile() : impl_(new MappedFileImpl) {}
+
+MappedFile::~MappedFile()
+{
+    close();
+    delete impl_;
+}
+
+bool MappedFile::openRead(const std::string &path)
+{
+    close();
+    impl_->hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (impl_->hFile == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(impl_->hFile, &size))
+    {
+        close();
+        return false;
+    }
+    impl_->size = static_cast<uint64_t>(size.QuadPart);
+    impl_->open = true;
+    if (impl_->size == 0)
+        return true; // 空文件无法建立映射
+    impl_->hMapping = CreateFileMappingA(impl_->hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (impl_->hMapping)
+        impl_->view = static_cast<unsigned char *>(MapViewOfFile(impl_->hMapping, FILE_MAP_READ, 0, 0, 0));
+    if (!impl_->view)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, uint64_t size)
+{
+    close();
+    impl_->hFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (impl_->hFile == INVALID_HANDLE_VALUE)
+        return false;
+    impl_->size = size;
+    impl_->open = true;
+    if (size == 0)
+        return true;
+    // 以目标大小建立映射会同时扩展文件
+    impl_->hMapping = CreateFileMappingA(impl_->hFile, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                         static_cast<DWORD>(size & 0xFFFFFFFFu), nullptr);
+    if (impl_->hMapping)
+        impl_->view = static_cast<unsigned char *>(MapViewOfFile(impl_->hMapping, FILE_MAP_WRITE, 0, 0, 0));
+    if (!impl_->view)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::openReadWrite(const std::string &path, uint64_t size)
+{
+    close();
+    impl_->hFile = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (impl_->hFile == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER existing;
+    if (!GetFileSizeEx(impl_->hFile, &existing))
+    {
+        close();
+        return false;
+    }
+    impl_->size = std::max<uint64_t>(size, static_cast<uint64_t>(existing.QuadPart));
+    impl_->open = true;
+    if (impl_->size == 0)
+        return true;
+    impl_->hMapping = CreateFileMappingA(impl_->hFile, nullptr, PAGE_READWRITE, static_cast<DWORD>(impl_->size >> 32),
+                                         static_cast<DWORD>(impl_->size & 0xFFFFFFFFu), nullptr);
+    if (impl_->hMapping)
+        impl_->view = static_cast<unsigned char *>(MapViewOfFile(impl_->hMapping, FILE_MAP_WRITE, 0, 0, 0));
+    if (!impl_->view)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::flush()
+{
+    if (!impl_->view)
+        return impl_->open;
+    return FlushViewOfFile(impl_->view, 0) != FALSE;
+}
+
+void MappedFile::close()
+{
+    if (impl_->view)
+        UnmapViewOfFile(impl_->view);
+    if (impl_->hMapping)
+        CloseHandle(impl_->hMapping);
+    if (impl_->hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(impl_->hFile);
+    impl_->view = nullptr;
+    impl_->hMapping = nullptr;
+    impl_->hFile = INVALID_HANDLE_VALUE;
+    impl_->size = 0;
+    impl_->open = false;
+}
+
+bool MappedFile::isOpen() const
+{
+    return impl_->open;
+}
+
+unsigned char *MappedFile::data()
+{
+    return impl_->view;
+}
+
+const unsigned char *MappedFile::data() const
+{
+    return impl_->view;
+}
+
+uint64_t MappedFile::size() const
+{
+    return impl_->size;
+}
@@ -0,0 +1,108 @@
+#include "MeasurementSource.h"
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+bool MeasurementSource::open(const std::string &path)
+{
+    close();
+    in_.open(path, std::ios::in | std::ios::binary);
+    if (!in_.is_open())
+        return false;
+    // 只读打开之后写入的测量：跳过文件中已有的旧数据（管道上 seek 失败，无影响）
+    in_.seekg(0, std::ios::end);
+    in_.clear();
+    return true;
+}
+
+void MeasurementSource::close()
+{
+    if (in_.is_open())
+        in_.close();
+    in_.clear();
+    partial_.clear();
+}
+
+bool MeasurementSource::isOpen() const
+{
+    return in_.is_open();
+}
+
+bool MeasurementSource::next(std::vector<float> &values, int timeoutMs)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (in_.is_open())
+    {
+        std::string chunk;
+        if (std::getline(in_, chunk))
+        {
+            if (in_.eof())
+            {
+                // 写入方还没写完这一行：保留片段，稍后继续读
+                partial_ += chunk;
+                in_.clear();
+            }
+            else
+            {
+                std::string line = partial_ + chunk;
+                partial_.clear();
+                auto hash = line.find('#');
+                if (hash != std::string::npos)
+                    line.erase(hash);
+                if (line.find_first_not_of(" \t\r,") == std::string::npos)
+                    continue;
+                return parseValues(line, values);
+            }
+        }
+        else
+        {
+            in_.clear();
+        }
+        if (std::chrono::steady_clock::now() >= deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+bool MeasurementSource::parseValues(const std::string &line, std::vector<float> &values)
+{
+    values.clear();
+    const char *p = line.c_str();
+    while (true)
+    {
+        while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r' || *p == '\n')
+            ++p;
+        if (*p == '\0')
+            break;
+        char *end = nullptr;
+        float v = std::strtof(p, &end);
+        if (end == p)
+            return false;
+        values.push_back(v);
+        p = end;
+    }
+    return !values.empty();
+}
+
+bool MeasurementSource::readFile(const std::string &path, std::vector<float> &values)
+{
+    std::ifstream ifs(path);
+    if (!ifs.is_open())
+        return false;
+    values.clear();
+    std::string line;
+    std::vector<float> row;
+    while (std::getline(ifs, line))
+    {
+        auto hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+        if (line.find_first_not_of(" \t\r,") == std::string::npos)
+            continue;
+        if (!parseValues(line, row))
+            return false;
+        values.insert(values.end(), row.begin(), row.end());
+    }
+    return !values.empty();
+}
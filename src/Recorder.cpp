@@ -0,0 +1,48 @@
+#include "Recorder.h"
+#include "Logger.h"
+#include "Tracer.h"
+
+bool Recorder::open(const std::string &path)
+{
+    close();
+    file_.open(path, std::ios::out | std::ios::trunc);
+    if (!file_.is_open())
+        return false;
+    path_ = path;
+    failed_ = false;
+    LOG_TEXT(Record, Debug, "Recording to '" + path + "'.");
+    return true;
+}
+
+void Recorder::close()
+{
+    if (file_.is_open())
+        file_.close();
+}
+
+bool Recorder::isOpen() const
+{
+    return file_.is_open();
+}
+
+std::string Recorder::getPath() const
+{
+    return path_;
+}
+
+void Recorder::write(const unsigned char *packet, size_t size, uint64_t version, const RecordingFormat::SampleTag *tag)
+{
+    if (!file_.is_open())
+        return;
+    TRACE_SPAN("record write");
+    // 按行记录：32个两位十六进制数（大写，零填充），行尾 #<帧版本号>
+    char line[RecordingFormat::kMaxLineSize];
+    size_t n = RecordingFormat::formatLine(packet, size, version, line, tag);
+    file_.write(line, static_cast<std::streamsize>(n));
+    file_.flush();
+    if (!file_ && !failed_)
+    {
+        failed_ = true; // 只报告一次，避免每帧刷屏
+        LOG_TEXT(Record, Error, "Write to recording '" + path_ + "' failed; later frames may be missing.");
+    }
+}
@@ -0,0 +1,178 @@
+#include "RecordingConverter.h"
+#include "RecordingFormat.h"
+#include "MappedFile.h"
+#include "ParallelChunks.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace RecordingFormat;
+
+namespace
+{
+    using ParallelChunks::parallelFor;
+    using ParallelChunks::threadCount;
+    using Chunk = ParallelChunks::LineChunk;
+
+    void printRate(const char *what, uint64_t frames, uint64_t bytes, std::chrono::steady_clock::time_point start)
+    {
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "[Info] " << what << " " << frames << " frames, " << bytes << " text bytes in " << s * 1000
+                  << " ms (" << (s > 0 ? bytes / s / 1e9 : 0) << " GB/s)\n";
+    }
+
+    int textToBinary(const std::string &inPath, const std::string &outPath)
+    {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile in;
+        if (!in.openRead(inPath))
+        {
+            std::cout << "[Error] Failed to open " << inPath << "\n";
+            return 1;
+        }
+        const char *begin = reinterpret_cast<const char *>(in.data());
+        const char *end = begin + in.size();
+
+        // 1. 并行统计每块行数，得到每块第一行的全局行号
+        auto chunks = ParallelChunks::splitLines(begin, end, threadCount() * 8);
+        const uint64_t frames = ParallelChunks::numberLines(chunks, end);
+
+        // 2. 并行解析，直接写入映射的输出文件
+        MappedFile out;
+        const uint64_t outSize = sizeof(RecordingBinaryHeader) + frames * (kPacketSize + sizeof(uint64_t));
+        if (!out.create(outPath, outSize))
+        {
+            std::cout << "[Error] Failed to create " << outPath << "\n";
+            return 1;
+        }
+        RecordingBinaryHeader hdr = {};
+        std::memcpy(hdr.magic, kBinaryMagic, sizeof(hdr.magic));
+        hdr.version = kBinaryVersion;
+        hdr.packetSize = kPacketSize;
+        hdr.frameCount = frames;
+        std::memcpy(out.data(), &hdr, sizeof(hdr));
+        unsigned char *packets = out.data() + sizeof(hdr);
+        unsigned char *versions = packets + frames * kPacketSize;
+
+        parallelFor(chunks.size(), [&](size_t i)
+                    {
+            Chunk &c = chunks[i];
+            const char *p = c.begin;
+            for (uint64_t line = 0; line < c.lines; ++line)
+            {
+                const char *nl = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(c.end - p)));
+                const char *eol = nl ? nl : c.end;
+                const uint64_t frame = c.firstLine + line;
+                uint64_t version = 0;
+                if (!parseLine(p, eol, packets + frame * kPacketSize, version, c.error))
+                {
+                    c.errorLine = frame + 1;
+                    return;
+                }
+                std::memcpy(versions + frame * sizeof(uint64_t), &version, sizeof(version));
+                p = eol + 1;
+            } });
+
+        for (const auto &c : chunks)
+        {
+            if (c.errorLine)
+            {
+                std::cout << "[Error] " << inPath << ":" << c.errorLine << ": " << c.error << "\n";
+                out.close();
+                std::remove(outPath.c_str());
+                return 1;
+            }
+        }
+        if (!out.flush())
+        {
+            std::cout << "[Error] Failed to write " << outPath << "\n";
+            return 1;
+        }
+        printRate("Converted", frames, in.size(), start);
+        return 0;
+    }
+
+    int binaryToText(const std::string &inPath, const std::string &outPath)
+    {
+        auto start = std::chrono::steady_clock::now();
+        MappedFile in;
+        if (!in.openRead(inPath))
+        {
+            std::cout << "[Error] Failed to open " << inPath << "\n";
+            return 1;
+        }
+        RecordingBinaryHeader hdr = {};
+        if (in.size() < sizeof(hdr))
+        {
+            std::cout << "[Error] " << inPath << " is not a binary recording.\n";
+            return 1;
+        }
+        std::memcpy(&hdr, in.data(), sizeof(hdr));
+        if (std::memcmp(hdr.magic, kBinaryMagic, sizeof(hdr.magic)) != 0 || hdr.version != kBinaryVersion ||
+            hdr.packetSize != kPacketSize || !binarySizeMatches(hdr.frameCount, in.size()))
+        {
+            std::cout << "[Error] " << inPath << " is not a valid binary recording.\n";
+            return 1;
+        }
+        const unsigned char *packets = in.data() + sizeof(hdr);
+        const unsigned char *versions = packets + hdr.frameCount * kPacketSize;
+
+        std::ofstream out(outPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!out.is_open())
+        {
+            std::cout << "[Error] Failed to create " << outPath << "\n";
+            return 1;
+        }
+
+        // 行长度不定：分段并行格式化，再按顺序写出
+        const uint64_t framesPerBlock = 1 << 16;
+        const uint64_t blocks = (hdr.frameCount + framesPerBlock - 1) / framesPerBlock;
+        const size_t inFlight = threadCount();
+        std::vector<std::string> text(inFlight);
+        uint64_t bytes = 0;
+        for (uint64_t base = 0; base < blocks; base += inFlight)
+        {
+            const size_t n = static_cast<size_t>(std::min<uint64_t>(inFlight, blocks - base));
+            parallelFor(n, [&](size_t i)
+                        {
+                const uint64_t first = (base + i) * framesPerBlock;
+                const uint64_t last = std::min(hdr.frameCount, first + framesPerBlock);
+                std::string &s = text[i];
+                s.resize(static_cast<size_t>(last - first) * kMaxLineSize);
+                char *p = s.data();
+                for (uint64_t f = first; f < last; ++f)
+                {
+                    uint64_t version;
+                    std::memcpy(&version, versions + f * sizeof(uint64_t), sizeof(version));
+                    p += formatLine(packets + f * kPacketSize, kPacketSize, version, p);
+                }
+                s.resize(static_cast<size_t>(p - s.data())); });
+            for (size_t i = 0; i < n; ++i)
+            {
+                out.write(text[i].data(), static_cast<std::streamsize>(text[i].size()));
+                bytes += text[i].size();
+            }
+        }
+        if (!out.good())
+        {
+            std::cout << "[Error] Failed to write " << outPath << "\n";
+            return 1;
+        }
+        printRate("Restored", hdr.frameCount, bytes, start);
+        return 0;
+    }
+}
+
+int runConvertTool(const std::vector<std::string> &args)
+{
+    if (args.size() == 3)
+        return textToBinary(args[1], args[2]);
+    if (args.size() == 4 && args[1] == "-r")
+        return binaryToText(args[2], args[3]);
+    std::cout << "[Usage] convert <in.txt> <out.bin>  |  convert -r <in.bin> <out.txt>\n";
+    return 1;
+}
@@ -0,0 +1,216 @@
+#include "RecordingFormat.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <string>
+
+namespace RecordingFormat
+{
+    namespace
+    {
+        constexpr unsigned char kInvalid = 0xFF;
+
+        constexpr std::array<unsigned char, 256> makeHexTable()
+        {
+            std::array<unsigned char, 256> t{};
+            for (auto &v : t)
+                v = kInvalid;
+            for (int c = '0'; c <= '9'; ++c)
+                t[c] = static_cast<unsigned char>(c - '0');
+            for (int c = 'A'; c <= 'F'; ++c)
+                t[c] = static_cast<unsigned char>(c - 'A' + 10);
+            for (int c = 'a'; c <= 'f'; ++c)
+                t[c] = static_cast<unsigned char>(c - 'a' + 10);
+            return t;
+        }
+        constexpr auto kHex = makeHexTable();
+        constexpr char kDigits[] = "0123456789ABCDEF";
+
+        inline bool isSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+    }
+
+    namespace
+    {
+        // " @<sobol|halton>/<seed>/<index>" after the frame version
+        bool parseTag(const char *p, const char *end, SampleTag &tag, const char *&error)
+        {
+            const char *slash = std::find(p, end, '/');
+            if (!LowDiscrepancySequence::parse(std::string(p, slash), tag.kind) || slash == end)
+            {
+                error = "invalid sample tag";
+                return false;
+            }
+            auto res = std::from_chars(slash + 1, end, tag.seed);
+            if (res.ec != std::errc() || res.ptr == end || *res.ptr != '/')
+            {
+                error = "invalid sample tag";
+                return false;
+            }
+            res = std::from_chars(res.ptr + 1, end, tag.index);
+            if (res.ec != std::errc())
+            {
+                error = "invalid sample tag";
+                return false;
+            }
+            for (p = res.ptr; p < end && *p != ';'; ++p)
+            {
+                if (!isSpace(*p))
+                {
+                    error = "unexpected text after sample tag";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Whitespace, an optional "#<version>" after the last byte, an optional sample tag after that and
+        // an optional "; <comment>" to the end of the line
+        bool parseTail(const char *p, const char *end, uint64_t &version, const char *&error, SampleTag *tag,
+                       bool *hasTag)
+        {
+            while (p < end && isSpace(*p))
+                ++p;
+            if (p == end)
+                return true;
+            if (*p != '#')
+            {
+                error = "more than 32 bytes";
+                return false;
+            }
+            auto res = std::from_chars(p + 1, end, version);
+            if (res.ec != std::errc())
+            {
+                error = "invalid frame version";
+                return false;
+            }
+            for (p = res.ptr; p < end && *p != ';'; ++p)
+            {
+                if (*p == '@')
+                {
+                    SampleTag parsed{};
+                    if (!parseTag(p + 1, end, parsed, error))
+                        return false;
+                    if (tag)
+                        *tag = parsed;
+                    if (hasTag)
+                        *hasTag = true;
+                    return true;
+                }
+                if (!isSpace(*p))
+                {
+                    error = "unexpected text after frame version";
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Canonical "XX XX ... XX" layout written by formatLine: fixed offsets, no branches per byte
+        constexpr size_t kCanonicalSize = kPacketSize * 3 - 1;
+
+        bool parseCanonical(const char *p, unsigned char *packet)
+        {
+            unsigned char bad = 0;
+            for (size_t i = 0; i < kPacketSize; ++i)
+            {
+                const char *q = p + i * 3;
+                const unsigned char hi = kHex[static_cast<unsigned char>(q[0])];
+                const unsigned char lo = kHex[static_cast<unsigned char>(q[1])];
+                bad |= static_cast<unsigned char>((hi | lo) & 0xF0);
+                packet[i] = static_cast<unsigned char>((hi << 4) | (lo & 0x0F));
+            }
+            for (size_t i = 2; i < kCanonicalSize; i += 3)
+                bad |= static_cast<unsigned char>(p[i] != ' ');
+            return bad == 0;
+        }
+    }
+
+    bool parseLine(const char *p, const char *end, unsigned char *packet, uint64_t &version, const char *&error,
+                   SampleTag *tag, bool *hasTag)
+    {
+        version = 0;
+        if (hasTag)
+            *hasTag = false;
+        if (end - p >= static_cast<ptrdiff_t>(kCanonicalSize) && parseCanonical(p, packet) &&
+            (end - p == static_cast<ptrdiff_t>(kCanonicalSize) || isSpace(p[kCanonicalSize]) || p[kCanonicalSize] == '#'))
+            return parseTail(p + kCanonicalSize, end, version, error, tag, hasTag);
+
+        // 通用路径：任意空白分隔的1~2位十六进制数
+        size_t n = 0;
+        while (p < end && n < kPacketSize)
+        {
+            const char c = *p;
+            if (isSpace(c))
+            {
+                ++p;
+                continue;
+            }
+            if (c == '#')
+                break;
+            unsigned char v = kHex[static_cast<unsigned char>(c)];
+            if (v == kInvalid)
+            {
+                error = "invalid hex digit";
+                return false;
+            }
+            ++p;
+            if (p < end && kHex[static_cast<unsigned char>(*p)] != kInvalid)
+            {
+                v = static_cast<unsigned char>((v << 4) | kHex[static_cast<unsigned char>(*p)]);
+                ++p;
+            }
+            if (p < end && !isSpace(*p) && *p != '#')
+            {
+                error = "invalid hex byte";
+                return false;
+            }
+            packet[n++] = v;
+        }
+        if (n != kPacketSize)
+        {
+            error = "expected 32 bytes";
+            return false;
+        }
+        return parseTail(p, end, version, error, tag, hasTag);
+    }
+
+    size_t formatLine(const unsigned char *packet, size_t size, uint64_t version, char *out, const SampleTag *tag)
+    {
+        char *p = out;
+        for (size_t i = 0; i < size && i < kPacketSize; ++i)
+        {
+            if (i)
+                *p++ = ' ';
+            *p++ = kDigits[packet[i] >> 4];
+            *p++ = kDigits[packet[i] & 0x0F];
+        }
+        *p++ = ' ';
+        *p++ = '#';
+        p = std::to_chars(p, out + kMaxLineSize - 1, version).ptr;
+        if (tag)
+        {
+            *p++ = ' ';
+            *p++ = '@';
+            for (const char *name = LowDiscrepancySequence::name(tag->kind); *name;)
+                *p++ = *name++;
+            *p++ = '/';
+            p = std::to_chars(p, out + kMaxLineSize - 1, tag->seed).ptr;
+            *p++ = '/';
+            p = std::to_chars(p, out + kMaxLineSize - 1, tag->index).ptr;
+        }
+        *p++ = '\n';
+        return static_cast<size_t>(p - out);
+    }
+
+    bool binarySizeMatches(uint64_t frameCount, uint64_t fileSize)
+    {
+        constexpr uint64_t frameBytes = kPacketSize + sizeof(uint64_t);
+        if (fileSize < sizeof(RecordingBinaryHeader))
+            return false;
+        const uint64_t body = fileSize - sizeof(RecordingBinaryHeader);
+        return frameCount <= body / frameBytes && body == frameCount * frameBytes;
+    }
+}
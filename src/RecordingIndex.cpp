@@ -0,0 +1,240 @@
+#include "RecordingIndex.h"
+#include "RecordingFormat.h"
+#include "ParallelChunks.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+using namespace RecordingFormat;
+using ParallelChunks::parallelFor;
+
+namespace
+{
+    constexpr size_t kChannels = kPacketSize - 2; // 包头 DA AD 不入列
+
+    bool sourceStat(const std::string &path, uint64_t &size, int64_t &time)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(path, ec);
+        if (ec)
+            return false;
+        time = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+        return !ec;
+    }
+}
+
+std::string RecordingIndex::indexPathFor(const std::string &recordingPath)
+{
+    return recordingPath + ".idx";
+}
+
+bool RecordingIndex::open(const std::string &recordingPath, bool rebuild, std::string &error)
+{
+    close();
+    uint64_t sourceSize = 0;
+    int64_t sourceTime = 0;
+    if (!sourceStat(recordingPath, sourceSize, sourceTime))
+    {
+        error = "cannot open " + recordingPath;
+        return false;
+    }
+    const std::string indexPath = indexPathFor(recordingPath);
+    bool fresh = false;
+    if (!rebuild && file_.openRead(indexPath) && file_.size() >= sizeof(RecordingIndexHeader))
+    {
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+        // 先用文件大小约束帧数，再做乘法，损坏的头不会溢出
+        const uint64_t frames = header_.frameCount;
+        const bool bounded = frames <= file_.size() / kChannels;
+        const uint64_t blocks = bounded ? (frames + kBlockFrames - 1) / kBlockFrames : 0;
+        fresh = std::memcmp(header_.magic, kMagic, sizeof(kMagic)) == 0 && header_.version == kVersion &&
+                header_.channels == kChannels && header_.blockFrames == kBlockFrames &&
+                header_.sourceSize == sourceSize && header_.sourceTime == sourceTime && bounded &&
+                file_.size() == sizeof(header_) + frames * kChannels + blocks * kChannels * 2;
+    }
+    if (!fresh)
+    {
+        file_.close();
+        if (!build(recordingPath, indexPath, sourceSize, sourceTime, error))
+            return false;
+        built_ = true;
+        if (!file_.openRead(indexPath))
+        {
+            error = "cannot map " + indexPath;
+            return false;
+        }
+        std::memcpy(&header_, file_.data(), sizeof(header_));
+    }
+    columns_ = file_.data() + sizeof(header_);
+    zones_ = columns_ + header_.frameCount * kChannels;
+    return true;
+}
+
+bool RecordingIndex::build(const std::string &recordingPath, const std::string &indexPath, uint64_t sourceSize,
+                           int64_t sourceTime, std::string &error)
+{
+    MappedFile in;
+    if (!in.openRead(recordingPath))
+    {
+        error = "cannot open " + recordingPath;
+        return false;
+    }
+
+    // 二进制录制：包数组直接可用；文本录制：按行并行解析
+    RecordingBinaryHeader bin = {};
+    const bool binary = in.size() >= sizeof(bin) && std::memcmp(in.data(), kBinaryMagic, sizeof(kBinaryMagic)) == 0;
+    uint64_t frames = 0;
+    std::vector<ParallelChunks::LineChunk> chunks;
+    const char *text = reinterpret_cast<const char *>(in.data());
+    const char *textEnd = text + in.size();
+    if (binary)
+    {
+        std::memcpy(&bin, in.data(), sizeof(bin));
+        if (bin.version != kBinaryVersion || bin.packetSize != kPacketSize ||
+            !binarySizeMatches(bin.frameCount, in.size()))
+        {
+            error = recordingPath + " is not a valid binary recording";
+            return false;
+        }
+        frames = bin.frameCount;
+    }
+    else
+    {
+        chunks = ParallelChunks::splitLines(text, textEnd, ParallelChunks::threadCount() * 8);
+        frames = ParallelChunks::numberLines(chunks, textEnd);
+    }
+
+    const uint64_t blocks = (frames + kBlockFrames - 1) / kBlockFrames;
+    MappedFile out;
+    if (!out.create(indexPath, sizeof(RecordingIndexHeader) + frames * kChannels + blocks * kChannels * 2))
+    {
+        error = "cannot create " + indexPath;
+        return false;
+    }
+    RecordingIndexHeader hdr = {};
+    std::memcpy(hdr.magic, kMagic, sizeof(kMagic));
+    hdr.version = kVersion;
+    hdr.channels = kChannels;
+    hdr.blockFrames = kBlockFrames;
+    hdr.frameCount = frames;
+    hdr.sourceSize = sourceSize;
+    hdr.sourceTime = sourceTime;
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+    unsigned char *columns = out.data() + sizeof(hdr);
+    unsigned char *zones = columns + frames * kChannels;
+
+    if (binary)
+    {
+        const unsigned char *packets = in.data() + sizeof(bin);
+        parallelFor(static_cast<size_t>(blocks), [&](size_t b)
+                    {
+            const uint64_t first = b * kBlockFrames;
+            const uint64_t last = std::min(frames, first + kBlockFrames);
+            for (uint64_t f = first; f < last; ++f)
+                for (size_t c = 0; c < kChannels; ++c)
+                    columns[c * frames + f] = packets[f * kPacketSize + 2 + c]; });
+    }
+    else
+    {
+        parallelFor(chunks.size(), [&](size_t i)
+                    {
+            auto &c = chunks[i];
+            const char *p = c.begin;
+            unsigned char packet[kPacketSize];
+            for (uint64_t line = 0; line < c.lines; ++line)
+            {
+                const char *nl = static_cast<const char *>(std::memchr(p, '\n', static_cast<size_t>(c.end - p)));
+                const char *eol = nl ? nl : c.end;
+                const uint64_t frame = c.firstLine + line;
+                uint64_t version = 0;
+                if (!parseLine(p, eol, packet, version, c.error))
+                {
+                    c.errorLine = frame + 1;
+                    return;
+                }
+                for (size_t ch = 0; ch < kChannels; ++ch)
+                    columns[ch * frames + frame] = packet[2 + ch];
+                p = eol + 1;
+            } });
+        for (const auto &c : chunks)
+        {
+            if (c.errorLine)
+            {
+                error = recordingPath + ":" + std::to_string(c.errorLine) + ": " + c.error;
+                out.close();
+                std::remove(indexPath.c_str());
+                return false;
+            }
+        }
+    }
+
+    // 区块摘要：每块每列的最小/最大值
+    parallelFor(static_cast<size_t>(blocks), [&](size_t b)
+                {
+        const uint64_t first = b * kBlockFrames;
+        const uint64_t last = std::min(frames, first + kBlockFrames);
+        for (size_t c = 0; c < kChannels; ++c)
+        {
+            const unsigned char *col = columns + c * frames;
+            unsigned char mn = 255, mx = 0;
+            for (uint64_t f = first; f < last; ++f)
+            {
+                mn = std::min(mn, col[f]);
+                mx = std::max(mx, col[f]);
+            }
+            zones[(b * kChannels + c) * 2] = mn;
+            zones[(b * kChannels + c) * 2 + 1] = mx;
+        } });
+
+    if (!out.flush())
+    {
+        error = "cannot write " + indexPath;
+        return false;
+    }
+    return true;
+}
+
+void RecordingIndex::close()
+{
+    file_.close();
+    header_ = {};
+    columns_ = nullptr;
+    zones_ = nullptr;
+    built_ = false;
+}
+
+bool RecordingIndex::wasBuilt() const
+{
+    return built_;
+}
+
+uint64_t RecordingIndex::getFrameCount() const
+{
+    return header_.frameCount;
+}
+
+size_t RecordingIndex::getChannelCount() const
+{
+    return header_.channels;
+}
+
+uint64_t RecordingIndex::getBlockCount() const
+{
+    return header_.blockFrames ? (header_.frameCount + header_.blockFrames - 1) / header_.blockFrames : 0;
+}
+
+const unsigned char *RecordingIndex::column(size_t channel) const
+{
+    return columns_ + channel * header_.frameCount;
+}
+
+unsigned char RecordingIndex::zoneMin(uint64_t block, size_t channel) const
+{
+    return zones_[(block * header_.channels + channel) * 2];
+}
+
+unsigned char RecordingIndex::zoneMax(uint64_t block, size_t channel) const
+{
+    return zones_[(block * header_.channels + channel) * 2 + 1];
+}
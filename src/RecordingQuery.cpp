@@ -0,0 +1,549 @@
+#include "RecordingQuery.h"
+#include "ParallelChunks.h"
+#include "RecordingFormat.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RECORDINGQUERY_SSE2 1
+#endif
+
+namespace
+{
+    enum : uint8_t
+    {
+        kNone,
+        kAll,
+        kSome
+    };
+
+    // mask[i] = 0xFF if lo <= col[i] <= hi else 0
+    void rangeMask(const unsigned char *col, size_t n, unsigned char lo, unsigned char hi, unsigned char *mask)
+    {
+        size_t i = 0;
+#ifdef RECORDINGQUERY_SSE2
+        const __m128i vlo = _mm_set1_epi8(static_cast<char>(lo));
+        const __m128i vhi = _mm_set1_epi8(static_cast<char>(hi));
+        for (; i + 16 <= n; i += 16)
+        {
+            // 无符号比较：max(x, lo) == x 即 x >= lo；min(x, hi) == x 即 x <= hi
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(col + i));
+            __m128i ge = _mm_cmpeq_epi8(_mm_max_epu8(x, vlo), x);
+            __m128i le = _mm_cmpeq_epi8(_mm_min_epu8(x, vhi), x);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(mask + i), _mm_and_si128(ge, le));
+        }
+#endif
+        for (; i < n; ++i)
+            mask[i] = (col[i] >= lo && col[i] <= hi) ? 0xFF : 0;
+    }
+
+    struct Tokenizer
+    {
+        explicit Tokenizer(const std::string &text) : s(text) {}
+
+        const std::string &s;
+        size_t pos = 0;
+        std::string token;
+
+        bool next()
+        {
+            while (pos < s.size() && std::isspace(static_cast<unsigned char>(s[pos])))
+                ++pos;
+            token.clear();
+            if (pos >= s.size())
+                return false;
+            const char c = s[pos];
+            if (std::isalnum(static_cast<unsigned char>(c)))
+            {
+                while (pos < s.size() && std::isalnum(static_cast<unsigned char>(s[pos])))
+                    token += s[pos++];
+                return true;
+            }
+            static const char *twoChar[] = {">=", "<=", "==", "!=", "&&", "||"};
+            for (auto op : twoChar)
+            {
+                if (s.compare(pos, 2, op) == 0)
+                {
+                    token = op;
+                    pos += 2;
+                    return true;
+                }
+            }
+            token = std::string(1, c);
+            ++pos;
+            return true;
+        }
+    };
+
+    struct BlockResult
+    {
+        uint64_t matches = 0;
+        bool scanned = false;
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        std::vector<uint64_t> histogram;
+        std::vector<unsigned char> minimum;
+        std::vector<unsigned char> maximum;
+        std::vector<uint64_t> sum;
+    };
+}
+
+bool RecordingQuery::compile(const std::string &expression, size_t channels, std::string &error)
+{
+    program_.clear();
+    Tokenizer tok(expression);
+    if (!tok.next())
+        return true;
+
+    // 递归下降，直接生成后缀指令
+    std::function<bool()> parseExpr, parseTerm, parseFactor;
+    auto fail = [&](const std::string &what)
+    {
+        error = what + (tok.token.empty() ? std::string(" at end of expression") : " at '" + tok.token + "'");
+        return false;
+    };
+    parseFactor = [&]() -> bool
+    {
+        if (tok.token == "not" || tok.token == "!")
+        {
+            tok.next();
+            if (!parseFactor())
+                return false;
+            program_.push_back({Op::Not, 0, 0, 0});
+            return true;
+        }
+        if (tok.token == "(")
+        {
+            tok.next();
+            if (!parseExpr())
+                return false;
+            if (tok.token != ")")
+                return fail("expected ')'");
+            tok.next();
+            return true;
+        }
+        if (tok.token.size() < 2 || (tok.token[0] != 'l' && tok.token[0] != 'L') ||
+            !std::all_of(tok.token.begin() + 1, tok.token.end(), ::isdigit))
+            return fail("expected l<id>");
+        const int id = std::stoi(tok.token.substr(1));
+        if (id < 1 || static_cast<size_t>(id) > channels)
+            return fail("LED id out of range 1-" + std::to_string(channels));
+        tok.next();
+        const std::string op = tok.token;
+        tok.next();
+        if (tok.token.empty() || !std::all_of(tok.token.begin(), tok.token.end(), ::isdigit) || tok.token.size() > 3 ||
+            std::stoi(tok.token) > 255)
+            return fail("expected a value 0-255");
+        const int v = std::stoi(tok.token);
+        tok.next();
+        const uint8_t ch = static_cast<uint8_t>(id - 1);
+        auto range = [&](int lo, int hi)
+        {
+            if (lo > hi) // 空区间（如 > 255）编码为 lo > hi，不匹配任何值
+                lo = 1, hi = 0;
+            program_.push_back({Op::Range, ch, static_cast<unsigned char>(lo), static_cast<unsigned char>(hi)});
+        };
+        if (op == ">")
+            range(v + 1, 255);
+        else if (op == ">=")
+            range(v, 255);
+        else if (op == "<")
+            range(0, v - 1);
+        else if (op == "<=")
+            range(0, v);
+        else if (op == "==" || op == "=")
+            range(v, v);
+        else if (op == "!=")
+        {
+            range(v, v);
+            program_.push_back({Op::Not, 0, 0, 0});
+        }
+        else
+        {
+            error = "expected a comparison after l" + std::to_string(id) + " at '" + op + "'";
+            return false;
+        }
+        return true;
+    };
+    parseTerm = [&]() -> bool
+    {
+        if (!parseFactor())
+            return false;
+        while (tok.token == "and" || tok.token == "&&")
+        {
+            tok.next();
+            if (!parseFactor())
+                return false;
+            program_.push_back({Op::And, 0, 0, 0});
+        }
+        return true;
+    };
+    parseExpr = [&]() -> bool
+    {
+        if (!parseTerm())
+            return false;
+        while (tok.token == "or" || tok.token == "||")
+        {
+            tok.next();
+            if (!parseTerm())
+                return false;
+            program_.push_back({Op::Or, 0, 0, 0});
+        }
+        return true;
+    };
+    if (!parseExpr())
+        return false;
+    if (!tok.token.empty())
+        return fail("unexpected token");
+
+    // 求值栈深度受限于 kMaxDepth
+    size_t depth = 0, maxDepth = 0;
+    for (const auto &in : program_)
+    {
+        if (in.op == Op::Range)
+            ++depth;
+        else if (in.op != Op::Not)
+            --depth;
+        maxDepth = std::max(maxDepth, depth);
+    }
+    if (maxDepth > kMaxDepth)
+    {
+        error = "expression nests too deeply";
+        return false;
+    }
+    return true;
+}
+
+void RecordingQuery::setHistogramChannel(int channel)
+{
+    histogramChannel_ = channel;
+}
+
+void RecordingQuery::setStatistics(bool enabled)
+{
+    statistics_ = enabled;
+}
+
+RecordingQuery::Result RecordingQuery::run(const RecordingIndex &index) const
+{
+    const uint64_t frames = index.getFrameCount();
+    const size_t channels = index.getChannelCount();
+    const uint64_t blocks = index.getBlockCount();
+    std::vector<BlockResult> perBlock(static_cast<size_t>(blocks));
+
+    ParallelChunks::parallelFor(static_cast<size_t>(blocks), [&](size_t b)
+                                {
+        BlockResult &r = perBlock[b];
+        const uint64_t first = b * static_cast<uint64_t>(RecordingIndex::kBlockFrames);
+        const size_t n = static_cast<size_t>(std::min<uint64_t>(frames - first, RecordingIndex::kBlockFrames));
+
+        // 1. 只看区块摘要：整块不匹配 / 全部匹配 / 需要扫描
+        uint8_t states[kMaxDepth];
+        size_t sp = 0;
+        for (const auto &in : program_)
+        {
+            switch (in.op)
+            {
+            case Op::Range:
+            {
+                const unsigned char mn = index.zoneMin(b, in.channel), mx = index.zoneMax(b, in.channel);
+                states[sp++] = (mx < in.lo || mn > in.hi) ? kNone : (in.lo <= mn && mx <= in.hi) ? kAll : kSome;
+                break;
+            }
+            case Op::And:
+                --sp;
+                states[sp - 1] = (states[sp - 1] == kNone || states[sp] == kNone) ? kNone
+                                 : (states[sp - 1] == kAll && states[sp] == kAll) ? kAll : kSome;
+                break;
+            case Op::Or:
+                --sp;
+                states[sp - 1] = (states[sp - 1] == kAll || states[sp] == kAll) ? kAll
+                                 : (states[sp - 1] == kNone && states[sp] == kNone) ? kNone : kSome;
+                break;
+            case Op::Not:
+                states[sp - 1] = states[sp - 1] == kAll ? kNone : states[sp - 1] == kNone ? kAll : kSome;
+                break;
+            }
+        }
+        const uint8_t state = program_.empty() ? static_cast<uint8_t>(kAll) : states[0];
+        if (state == kNone)
+            return;
+
+        // 2. 逐帧掩码（后缀求值，每层一个字节掩码）
+        thread_local std::vector<unsigned char> stack;
+        unsigned char *mask = nullptr;
+        if (state == kSome)
+        {
+            r.scanned = true;
+            stack.resize(RecordingIndex::kBlockFrames * kMaxDepth);
+            sp = 0;
+            for (const auto &in : program_)
+            {
+                unsigned char *top = stack.data() + sp * RecordingIndex::kBlockFrames;
+                unsigned char *below = top - RecordingIndex::kBlockFrames;
+                switch (in.op)
+                {
+                case Op::Range:
+                    rangeMask(index.column(in.channel) + first, n, in.lo, in.hi, top);
+                    ++sp;
+                    break;
+                case Op::And:
+                    below -= RecordingIndex::kBlockFrames;
+                    for (size_t i = 0; i < n; ++i)
+                        below[i] &= below[i + RecordingIndex::kBlockFrames];
+                    --sp;
+                    break;
+                case Op::Or:
+                    below -= RecordingIndex::kBlockFrames;
+                    for (size_t i = 0; i < n; ++i)
+                        below[i] |= below[i + RecordingIndex::kBlockFrames];
+                    --sp;
+                    break;
+                case Op::Not:
+                    for (size_t i = 0; i < n; ++i)
+                        below[i] = static_cast<unsigned char>(~below[i]);
+                    break;
+                }
+            }
+            mask = stack.data();
+        }
+
+        // 3. 匹配区间与聚合
+        auto matches = [&](size_t i)
+        { return !mask || mask[i]; };
+        for (size_t i = 0; i < n;)
+        {
+            if (!matches(i))
+            {
+                ++i;
+                continue;
+            }
+            size_t j = i;
+            while (j < n && matches(j))
+                ++j;
+            r.ranges.push_back({first + i, first + j - 1});
+            r.matches += j - i;
+            i = j;
+        }
+        if (r.matches == 0)
+            return;
+        if (histogramChannel_ >= 0)
+        {
+            r.histogram.assign(256, 0);
+            const unsigned char *col = index.column(histogramChannel_) + first;
+            for (size_t i = 0; i < n; ++i)
+                if (matches(i))
+                    ++r.histogram[col[i]];
+        }
+        if (statistics_)
+        {
+            r.minimum.assign(channels, 255);
+            r.maximum.assign(channels, 0);
+            r.sum.assign(channels, 0);
+            for (size_t c = 0; c < channels; ++c)
+            {
+                const unsigned char *col = index.column(c) + first;
+                unsigned char mn = 255, mx = 0;
+                uint64_t sum = 0;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (!matches(i))
+                        continue;
+                    mn = std::min(mn, col[i]);
+                    mx = std::max(mx, col[i]);
+                    sum += col[i];
+                }
+                r.minimum[c] = mn;
+                r.maximum[c] = mx;
+                r.sum[c] = sum;
+            }
+        } });
+
+    // 按块顺序合并；跨块连续的区间拼接
+    Result result;
+    if (histogramChannel_ >= 0)
+        result.histogram.assign(256, 0);
+    std::vector<uint64_t> sum;
+    if (statistics_)
+    {
+        result.minimum.assign(channels, 255);
+        result.maximum.assign(channels, 0);
+        sum.assign(channels, 0);
+    }
+    for (const auto &r : perBlock)
+    {
+        result.matches += r.matches;
+        (r.scanned ? result.blocksScanned : result.blocksSkipped) += 1;
+        for (const auto &range : r.ranges)
+        {
+            if (!result.ranges.empty() && result.ranges.back().second + 1 == range.first)
+                result.ranges.back().second = range.second;
+            else
+                result.ranges.push_back(range);
+        }
+        for (size_t v = 0; v < r.histogram.size(); ++v)
+            result.histogram[v] += r.histogram[v];
+        for (size_t c = 0; c < r.sum.size(); ++c)
+        {
+            result.minimum[c] = std::min(result.minimum[c], r.minimum[c]);
+            result.maximum[c] = std::max(result.maximum[c], r.maximum[c]);
+            sum[c] += r.sum[c];
+        }
+    }
+    if (statistics_)
+    {
+        result.mean.resize(channels);
+        for (size_t c = 0; c < channels; ++c)
+            result.mean[c] = result.matches ? static_cast<double>(sum[c]) / result.matches : 0;
+    }
+    return result;
+}
+
+int runQueryTool(const std::vector<std::string> &args)
+{
+    // query <recording> [expression] [--hist l<x>] [--stats] [--limit n] [--ranges file] [--rebuild]
+    auto usage = []
+    {
+        std::cout << "[Usage] query <recording> [expression] [--hist l<x>] [--stats] [--limit n] [--ranges file] "
+                     "[--rebuild]\n"
+                     "        e.g. query record.txt \"l14 > 200 and l3 == 0\" --hist l14\n";
+        return 1;
+    };
+    if (args.size() < 2)
+        return usage();
+    std::string expression, rangesFile;
+    int histogram = -1;
+    bool statistics = false, rebuild = false;
+    size_t limit = 20;
+    for (size_t i = 2; i < args.size(); ++i)
+    {
+        if (args[i] == "--hist" && i + 1 < args.size())
+        {
+            const std::string &a = args[++i];
+            if (a.size() < 2 || (a[0] != 'l' && a[0] != 'L') || !std::all_of(a.begin() + 1, a.end(), ::isdigit) ||
+                a.size() > 4)
+                return usage();
+            histogram = std::stoi(a.substr(1)) - 1;
+        }
+        else if (args[i] == "--stats")
+            statistics = true;
+        else if (args[i] == "--rebuild")
+            rebuild = true;
+        else if (args[i] == "--limit" && i + 1 < args.size())
+        {
+            try
+            {
+                limit = std::stoul(args[++i]);
+            }
+            catch (...)
+            {
+                return usage();
+            }
+        }
+        else if (args[i] == "--ranges" && i + 1 < args.size())
+            rangesFile = args[++i];
+        else if (args[i].rfind("--", 0) == 0)
+            return usage();
+        else
+            expression += (expression.empty() ? "" : " ") + args[i];
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    RecordingIndex index;
+    std::string error;
+    if (!index.open(args[1], rebuild, error))
+    {
+        std::cout << "[Error] " << error << "\n";
+        return 1;
+    }
+    double openMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    std::cout << "[Info] Index " << RecordingIndex::indexPathFor(args[1]) << ": " << index.getFrameCount()
+              << " frames, " << index.getBlockCount() << " blocks (" << (index.wasBuilt() ? "built" : "loaded")
+              << " in " << openMs << " ms)\n";
+    if (histogram >= static_cast<int>(index.getChannelCount()))
+    {
+        std::cout << "[Error] --hist LED id out of range 1-" << index.getChannelCount() << "\n";
+        return 1;
+    }
+
+    RecordingQuery query;
+    if (!query.compile(expression, index.getChannelCount(), error))
+    {
+        std::cout << "[Error] " << error << "\n";
+        return 1;
+    }
+    query.setHistogramChannel(histogram);
+    query.setStatistics(statistics);
+    start = Clock::now();
+    RecordingQuery::Result result = query.run(index);
+    double queryMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    std::cout << "[Info] " << result.matches << " matching frames in " << result.ranges.size() << " ranges; "
+              << result.blocksScanned << " blocks scanned, " << result.blocksSkipped
+              << " decided by zone maps; " << queryMs << " ms\n";
+    for (size_t i = 0; i < result.ranges.size() && i < limit; ++i)
+    {
+        const auto &r = result.ranges[i];
+        if (r.first == r.second)
+            std::cout << "  frame " << r.first << "\n";
+        else
+            std::cout << "  frames " << r.first << "-" << r.second << " (" << (r.second - r.first + 1) << ")\n";
+    }
+    if (result.ranges.size() > limit)
+        std::cout << "  ... " << (result.ranges.size() - limit) << " more ranges (--limit n, --ranges file)\n";
+    if (!result.ranges.empty())
+    {
+        // 回放只读文本录制；二进制录制需先 convert -r
+        char magic[4] = {};
+        std::ifstream(args[1], std::ios::binary).read(magic, sizeof(magic));
+        const bool binary = std::memcmp(magic, RecordingFormat::kBinaryMagic, sizeof(magic)) == 0;
+        std::cout << "[Info] Replay the first range: " << (binary ? "convert -r it to text, then " : "")
+                  << "replay -s " << (binary ? "<text>" : args[1]) << " --from " << result.ranges[0].first << " --to "
+                  << result.ranges[0].second << "\n";
+    }
+
+    if (!rangesFile.empty())
+    {
+        std::ofstream ofs(rangesFile, std::ios::out | std::ios::trunc);
+        for (const auto &r : result.ranges)
+            ofs << r.first << " " << r.second << "\n";
+        if (!ofs.good())
+        {
+            std::cout << "[Error] Failed to write " << rangesFile << "\n";
+            return 1;
+        }
+        std::cout << "[Info] Ranges written to " << rangesFile << " (from to, inclusive)\n";
+    }
+
+    if (histogram >= 0)
+    {
+        std::cout << "[Info] Histogram of l" << (histogram + 1) << " over matching frames:\n";
+        uint64_t peak = 1;
+        uint64_t bins[16] = {};
+        for (size_t v = 0; v < 256; ++v)
+            bins[v / 16] += result.histogram[v];
+        for (auto b : bins)
+            peak = std::max(peak, b);
+        for (size_t b = 0; b < 16; ++b)
+        {
+            char label[16];
+            std::snprintf(label, sizeof(label), "%3zu-%3zu", b * 16, b * 16 + 15);
+            std::cout << "  " << label << " " << std::string(static_cast<size_t>(40 * bins[b] / peak), '#') << " "
+                      << bins[b] << "\n";
+        }
+    }
+    if (statistics && result.matches)
+    {
+        std::cout << "ID\tMin\tMax\tMean\n";
+        for (size_t c = 0; c < index.getChannelCount(); ++c)
+            std::cout << (c + 1) << "\t" << int(result.minimum[c]) << "\t" << int(result.maximum[c]) << "\t"
+                      << result.mean[c] << "\n";
+    }
+    return 0;
+}
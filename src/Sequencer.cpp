@@ -0,0 +1,194 @@
+#include "Sequencer.h"
+#include "Logger.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+Sequencer::Sequencer() {}
+
+Sequencer::~Sequencer()
+{
+    stop();
+}
+
+void Sequencer::setClock(Clock &clock)
+{
+    clock_ = &clock;
+}
+
+double Sequencer::microsecondsSince(Clock::TimePoint from) const
+{
+    return std::chrono::duration<double, std::micro>(clock_->now() - from).count();
+}
+
+bool Sequencer::start(std::vector<unsigned char> packets, size_t packetSize, std::vector<uint64_t> versions,
+                      const std::string &trigger, uint32_t holdUs, SendHandler onSend)
+{
+    stop();
+    if (packetSize == 0 || packets.empty() || packets.size() % packetSize != 0)
+        return false;
+    if (!versions.empty() && versions.size() != packets.size() / packetSize)
+        return false;
+    if (!trigger.empty() && !trigger_.open(trigger))
+        return false;
+
+    packets_ = std::move(packets);
+    versions_ = std::move(versions);
+    packetSize_ = packetSize;
+    holdUs_ = holdUs;
+    triggered_ = !trigger.empty();
+    onSend_ = std::move(onSend);
+    position_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats_ = Stats();
+        latencies_.clear();
+        latencies_.reserve(getFrameCount());
+    }
+    running_ = true;
+    thread_ = std::thread(&Sequencer::run, this);
+    return true;
+}
+
+void Sequencer::stop()
+{
+    running_ = false;
+    if (thread_.joinable())
+        thread_.join();
+    trigger_.close();
+}
+
+bool Sequencer::isRunning() const
+{
+    return running_;
+}
+
+bool Sequencer::isTriggered() const
+{
+    return triggered_;
+}
+
+std::string Sequencer::getTrigger() const
+{
+    return trigger_.getSpec();
+}
+
+uint32_t Sequencer::getHoldTime() const
+{
+    return holdUs_;
+}
+
+size_t Sequencer::getFrameCount() const
+{
+    return packetSize_ ? packets_.size() / packetSize_ : 0;
+}
+
+uint64_t Sequencer::getPosition() const
+{
+    return position_;
+}
+
+Sequencer::Stats Sequencer::getStats() const
+{
+    Stats stats;
+    std::vector<float> sorted;
+    {
+        // 只在锁内复制，排序在锁外，不拖慢发送线程的 record()
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        stats = stats_;
+        sorted = latencies_;
+    }
+    if (!sorted.empty())
+    {
+        size_t rank = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+        std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(rank), sorted.end());
+        stats.p99Us = sorted[rank];
+    }
+    return stats;
+}
+
+void Sequencer::record(double latencyUs, bool ok, bool overrun)
+{
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    if (!ok)
+    {
+        ++stats_.errors;
+        return;
+    }
+    if (stats_.frames == 0 || latencyUs < stats_.minUs)
+        stats_.minUs = latencyUs;
+    stats_.maxUs = std::max(stats_.maxUs, latencyUs);
+    stats_.meanUs += (latencyUs - stats_.meanUs) / static_cast<double>(stats_.frames + 1);
+    ++stats_.frames;
+    if (overrun)
+        ++stats_.overruns;
+    latencies_.push_back(static_cast<float>(latencyUs));
+}
+
+void Sequencer::run()
+{
+    Tracer::instance().setThreadName("sequencer");
+    if (triggered_)
+        runTriggered();
+    else
+        runTimed();
+
+    Stats stats = getStats();
+    char summary[256];
+    std::snprintf(summary, sizeof(summary),
+                  "Sequence %s after %llu/%zu frames, latency min %.0f / mean %.0f / p99 %.0f / max %.0f us, %llu %s, %llu errors.",
+                  position_ == getFrameCount() ? "finished" : "stopped", static_cast<unsigned long long>(position_.load()),
+                  getFrameCount(), stats.minUs, stats.meanUs, stats.p99Us, stats.maxUs,
+                  static_cast<unsigned long long>(stats.overruns), triggered_ ? "missed triggers" : "overruns",
+                  static_cast<unsigned long long>(stats.errors));
+    LOG_TEXT(General, Info, summary);
+    running_ = false;
+}
+
+void Sequencer::runTriggered()
+{
+    // 等待触发 -> 立即写出下一帧；短超时只为响应 stop()
+    const size_t count = getFrameCount();
+    while (running_ && position_ < count)
+    {
+        {
+            TRACE_SPAN("trigger wait");
+            if (!trigger_.wait(100))
+                continue;
+        }
+        const auto woke = clock_->now();
+        const size_t i = position_;
+        bool ok = onSend_(packets_.data() + i * packetSize_, packetSize_, versions_.empty() ? 0 : versions_[i]);
+        const double latency = microsecondsSince(woke);
+        // 写完时已有排队的触发：相机比灯板快，该帧曝光已错过
+        record(latency, ok, trigger_.getPending() > 0);
+        ++position_;
+    }
+}
+
+void Sequencer::runTimed()
+{
+    // 按绝对时间表推进，单帧延迟不会累积到后续帧
+    const size_t count = getFrameCount();
+    const auto hold = std::chrono::microseconds(holdUs_);
+    const auto start = clock_->now();
+    while (running_ && position_ < count)
+    {
+        const size_t i = position_;
+        const auto deadline = start + hold * static_cast<int64_t>(i);
+        {
+            TRACE_SPAN("hold sleep");
+            // 分段睡眠以便 stop() 及时生效
+            if (!clock_->waitUntil(deadline, running_))
+                break;
+        }
+
+        bool ok = onSend_(packets_.data() + i * packetSize_, packetSize_, versions_.empty() ? 0 : versions_[i]);
+        const double late = microsecondsSince(deadline);
+        record(late, ok, late >= holdUs_);
+        ++position_;
+    }
+    // 最后一帧也保持完整的曝光时间
+    clock_->waitUntil(start + hold * static_cast<int64_t>(count), running_);
+}
@@ -1,6 +1,21 @@
 #include "SerialInterface.h"
+#include "Tracer.h"
 #include <windows.h>
 #include <string>
+#include <cctype>
+
+namespace
+{
+    // COM1..COM256；其他名称按文件或命名管道打开
+    bool isComPort(const std::string &port)
+    {
+        if (port.size() < 4 || std::toupper(static_cast<unsigned char>(port[0])) != 'C' ||
+            std::toupper(static_cast<unsigned char>(port[1])) != 'O' ||
+            std::toupper(static_cast<unsigned char>(port[2])) != 'M')
+            return false;
+        return port.find_first_not_of("0123456789", 3) == std::string::npos;
+    }
+}
 
 class SerialInterface::SerialInterfaceImpl
 {
@@ -20,6 +35,16 @@ bool SerialInterface::open(const std::string &port)
 {
     if (isOpen())
         close();
+    if (!isComPort(port))
+    {
+        // 文件或管道（如 simspec 的输入）：没有串口参数，追加写入，允许其他进程同时读取
+        impl_->hSerial = CreateFileA(port.c_str(), GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                                     FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (impl_->hSerial == INVALID_HANDLE_VALUE)
+            return false;
+        SetFilePointer(impl_->hSerial, 0, nullptr, FILE_END); // 管道上无效，忽略结果
+        return true;
+    }
     std::string fullPort = "\\\\.\\" + port;
     impl_->hSerial = CreateFileA(
         fullPort.c_str(),
@@ -77,11 +102,17 @@ void SerialInterface::close()
 
 bool SerialInterface::sendData(const std::vector<unsigned char> &data)
 {
-    if (!isOpen() || data.empty())
+    return sendData(data.data(), data.size());
+}
+
+bool SerialInterface::sendData(const unsigned char *data, size_t size)
+{
+    if (!isOpen() || size == 0)
         return false;
+    TRACE_SPAN("serial write");
     DWORD bytesWritten = 0;
-    BOOL ok = WriteFile(impl_->hSerial, data.data(), static_cast<DWORD>(data.size()), &bytesWritten, nullptr);
-    return ok && bytesWritten == data.size();
+    BOOL ok = WriteFile(impl_->hSerial, data, static_cast<DWORD>(size), &bytesWritten, nullptr);
+    return ok && bytesWritten == size;
 }
 
 bool SerialInterface::isOpen() const
@@ -0,0 +1,100 @@
+#include "SpectralModel.h"
+#include "LEDController.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPECTRALMODEL_SSE2 1
+#endif
+
+namespace
+{
+    constexpr size_t kSimdWidth = 4;
+}
+
+SpectralModel::SpectralModel(const LEDController &controller, float startNm, float stepNm, size_t points)
+    : start_(startNm), step_(stepNm), points_(points),
+      stride_((points + kSimdWidth - 1) / kSimdWidth * kSimdWidth), channels_(controller.getLedCount())
+{
+    for (size_t c = 0; c < channels_; ++c)
+    {
+        const LED &led = controller.getById(static_cast<int>(c + 1));
+        const float peak = led.getPeakWavelength();
+        const float maxRad = led.getMaxRadiation();
+        // 未注册灯和 RGB/白光灯没有辐射数据
+        if (peak <= 0 || maxRad <= 0)
+            continue;
+        const double sigma = fwhmFor(peak) / 2.354820045;
+        const size_t base = columns_.size();
+        columns_.resize(base + stride_, 0.0f); // padding stays 0
+        for (size_t p = 0; p < points_; ++p)
+        {
+            const double d = (getWavelength(p) - peak) / sigma;
+            columns_[base + p] = static_cast<float>(std::exp(-0.5 * d * d) * maxRad / 255.0);
+        }
+        columnChannel_.push_back(c);
+    }
+}
+
+float SpectralModel::getStart() const
+{
+    return start_;
+}
+
+float SpectralModel::getStep() const
+{
+    return step_;
+}
+
+size_t SpectralModel::getPointCount() const
+{
+    return points_;
+}
+
+size_t SpectralModel::getChannelCount() const
+{
+    return channels_;
+}
+
+float SpectralModel::getWavelength(size_t point) const
+{
+    return start_ + step_ * static_cast<float>(point);
+}
+
+float SpectralModel::getWeight(size_t point, size_t channel) const
+{
+    auto it = std::find(columnChannel_.begin(), columnChannel_.end(), channel);
+    if (it == columnChannel_.end() || point >= points_)
+        return 0.0f;
+    return columns_[static_cast<size_t>(it - columnChannel_.begin()) * stride_ + point];
+}
+
+void SpectralModel::evaluate(const unsigned char *frame, float *out) const
+{
+    std::fill(out, out + points_, 0.0f);
+    for (size_t k = 0; k < columnChannel_.size(); ++k)
+    {
+        const unsigned char x = frame[columnChannel_[k]];
+        if (x == 0)
+            continue; // 熄灭的灯不参与计算
+        const float *col = &columns_[k * stride_];
+        size_t p = 0;
+#ifdef SPECTRALMODEL_SSE2
+        const __m128 vx = _mm_set1_ps(static_cast<float>(x));
+        for (; p + kSimdWidth <= points_; p += kSimdWidth)
+        {
+            __m128 acc = _mm_loadu_ps(out + p);
+            acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(col + p), vx));
+            _mm_storeu_ps(out + p, acc);
+        }
+#endif
+        for (; p < points_; ++p)
+            out[p] += col[p] * x;
+    }
+}
+
+float SpectralModel::fwhmFor(float peakNm)
+{
+    // 典型LED线宽约为峰位的5%（405nm约20nm，1550nm约80nm）
+    return 0.05f * peakNm;
+}
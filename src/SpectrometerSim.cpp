@@ -0,0 +1,112 @@
+#include "SpectrometerSim.h"
+#include "FrameProtocol.h"
+#include "LEDController.h"
+#include "SpectralModel.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+int runSpectrometerSim(const std::vector<std::string> &args)
+{
+    if (args.size() < 3 || args.size() > 5)
+    {
+        std::cout << "[Usage] simspec <serial-in> <measure-out> [gain] [noise%]\n";
+        return 1;
+    }
+    float gain = 1.0f, noise = 0.0f;
+    try
+    {
+        if (args.size() > 3)
+            gain = std::stof(args[3]);
+        if (args.size() > 4)
+            noise = std::stof(args[4]) / 100.0f;
+    }
+    catch (...)
+    {
+        gain = 0;
+    }
+    if (gain <= 0 || noise < 0)
+    {
+        std::cout << "[Usage] simspec <serial-in> <measure-out> [gain] [noise%]\n";
+        return 1;
+    }
+
+    std::ifstream in(args[1], std::ios::in | std::ios::binary);
+    std::ofstream out(args[2], std::ios::out | std::ios::app);
+    if (!in.is_open() || !out.is_open())
+    {
+        std::cout << "[Error] Failed to open " << (in.is_open() ? args[2] : args[1]) << "\n";
+        return 1;
+    }
+
+    LEDController controller;
+    const SpectralModel &model = controller.getSpectralModel();
+    const size_t channels = controller.getLedCount();
+    const size_t points = model.getPointCount();
+    std::mt19937 rng(1);
+    std::vector<float> efficiency(channels);
+    for (auto &e : efficiency)
+        e = gain * (0.85f + 0.3f * static_cast<float>(rng() % 1000) / 1000.0f);
+    std::normal_distribution<float> gaussian(0.0f, 1.0f);
+
+    std::cout << "[Info] Simulating spectrometer: " << args[1] << " -> " << args[2] << " (" << points
+              << " points). Press Ctrl+C to stop.\n";
+    std::vector<unsigned char> frame(channels), packet;
+    std::vector<float> spectrum(points);
+    const FrameProtocol::EncoderOps *op = nullptr; // 当前包的格式，由包头第二字节决定
+    int state = 0; // 0: 等待包头0, 1: 等待包头1, 2: 读取包体
+    size_t filled = 0;
+    char byte;
+    while (true)
+    {
+        if (!in.get(byte))
+        {
+            in.clear();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        const unsigned char b = static_cast<unsigned char>(byte);
+        if (state == 0)
+        {
+            state = (b == FrameProtocol::kHeader0) ? 1 : 0;
+            continue;
+        }
+        if (state == 1)
+        {
+            op = FrameProtocol::findByHeader(b);
+            if (!op)
+            {
+                state = (b == FrameProtocol::kHeader0) ? 1 : 0;
+                continue;
+            }
+            packet.resize(op->packetSize(channels));
+            packet[0] = FrameProtocol::kHeader0;
+            packet[1] = b;
+            filled = 2;
+            state = 2;
+            continue;
+        }
+        packet[filled++] = b;
+        if (filled < packet.size())
+            continue;
+        state = 0;
+        if (!op->decode8(packet.data(), channels, frame.data()))
+            continue; // CRC 不符，丢弃该帧
+
+        for (size_t p = 0; p < points; ++p)
+        {
+            // 模拟 5 nm 红移：使用前一个波长点的权重
+            const size_t source = p > 0 ? p - 1 : 0;
+            float v = 0;
+            for (size_t c = 0; c < channels; ++c)
+                v += model.getWeight(source, c) * efficiency[c] * frame[c];
+            spectrum[p] = noise > 0 ? v * (1.0f + noise * gaussian(rng)) : v;
+        }
+        for (size_t p = 0; p < points; ++p)
+            out << (p ? " " : "") << spectrum[p];
+        out << "\n";
+        out.flush();
+    }
+}
@@ -0,0 +1,335 @@
+#include "StateJournal.h"
+#include "LEDController.h"
+#include "FrameProtocol.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    constexpr char kMagic[4] = {'L', 'D', 'J', 'L'};
+    constexpr uint32_t kVersion = 1;
+
+#pragma pack(push, 1)
+    struct JournalHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t ledCount;
+        uint32_t reserved;
+    };
+    struct SnapshotSlot
+    {
+        uint64_t sequence; // 0 = empty
+        uint16_t crc;
+        uint16_t reserved[3];
+        StateJournal::State state;
+    };
+    struct Record
+    {
+        uint64_t sequence;
+        uint32_t value;
+        uint8_t field;
+        uint8_t channel;
+        uint16_t crc; // over the first 14 bytes
+    };
+#pragma pack(pop)
+    static_assert(sizeof(Record) == 16, "Record must be 16 bytes");
+
+    constexpr size_t kSlotOffset = sizeof(JournalHeader);
+    constexpr size_t kLogOffset = (kSlotOffset + 2 * sizeof(SnapshotSlot) + 63) / 64 * 64;
+    constexpr size_t kLogCapacity = (StateJournal::kFileSize - kLogOffset) / sizeof(Record);
+
+    uint16_t crc16(const void *data, size_t size)
+    {
+        uint16_t crc = 0xFFFF;
+        const auto *p = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; ++i)
+            crc = FrameProtocol::crcUpdate(crc, p[i]);
+        return crc;
+    }
+
+    uint16_t slotCrc(const SnapshotSlot &slot)
+    {
+        uint16_t crc = crc16(&slot.sequence, sizeof(slot.sequence));
+        for (size_t i = 0; i < sizeof(slot.state); ++i)
+            crc = FrameProtocol::crcUpdate(crc, reinterpret_cast<const unsigned char *>(&slot.state)[i]);
+        return crc;
+    }
+
+    SnapshotSlot *slots(MappedFile &file)
+    {
+        return reinterpret_cast<SnapshotSlot *>(file.data() + kSlotOffset);
+    }
+
+    Record *records(MappedFile &file)
+    {
+        return reinterpret_cast<Record *>(file.data() + kLogOffset);
+    }
+}
+
+StateJournal::~StateJournal()
+{
+    close();
+}
+
+bool StateJournal::open(const std::string &path, size_t ledCount)
+{
+    close();
+    if (ledCount > kMaxLeds || !file_.openReadWrite(path, kFileSize) || file_.size() < kFileSize)
+    {
+        file_.close();
+        return false;
+    }
+    auto *header = reinterpret_cast<JournalHeader *>(file_.data());
+    if (std::memcmp(header->magic, kMagic, 4) != 0 || header->version != kVersion || header->ledCount != ledCount)
+    {
+        // 新文件或不兼容/损坏的旧文件：整个文件清零后重新初始化。序号从 0 重新开始，
+        // 残留的旧记录若保留会带着有效的校验和连续的序号被回放
+        std::memset(file_.data(), 0, static_cast<size_t>(kFileSize));
+        std::memcpy(header->magic, kMagic, 4);
+        header->version = kVersion;
+        header->ledCount = static_cast<uint32_t>(ledCount);
+    }
+    path_ = path;
+    sequence_ = logStart_ = logRecords_ = snapshots_ = 0;
+    newestSlot_ = 0;
+    hasRecovered_ = false;
+    baseline_ = false;
+
+    // 取序号最大且校验通过的快照
+    SnapshotSlot *slot = slots(file_);
+    int newest = -1;
+    for (int i = 0; i < 2; ++i)
+    {
+        if (slot[i].sequence == 0 || slot[i].crc != slotCrc(slot[i]) || slot[i].state.ledCount != ledCount)
+            continue;
+        if (newest < 0 || slot[i].sequence > slot[newest].sequence)
+            newest = i;
+    }
+    if (newest < 0)
+        return true;
+
+    recovered_ = slot[newest].state;
+    uint64_t sequence = slot[newest].sequence;
+    const Record *log = records(file_);
+    for (size_t i = 0; i < kLogCapacity; ++i)
+    {
+        // 序号不连续（上一轮的旧记录）或校验失败（写到一半）即为日志末尾
+        const Record &record = log[i];
+        if (record.sequence != sequence + 1 || record.crc != crc16(&record, 14) ||
+            !applyRecord(recovered_, record.field, record.channel, record.value))
+            break;
+        sequence = record.sequence;
+        ++logRecords_;
+    }
+    // 新记录接在日志末尾之后，新快照写入另一个槽位
+    newestSlot_ = newest;
+    logStart_ = slot[newest].sequence;
+    sequence_ = sequence;
+    hasRecovered_ = true;
+    return true;
+}
+
+void StateJournal::close()
+{
+    if (file_.isOpen())
+    {
+        file_.flush();
+        file_.close();
+    }
+    path_.clear();
+}
+
+bool StateJournal::isOpen() const
+{
+    return file_.isOpen();
+}
+
+std::string StateJournal::getPath() const
+{
+    return path_;
+}
+
+StateJournal::State StateJournal::read(const LEDController &controller)
+{
+    State state = {};
+    state.ledCount = static_cast<uint32_t>(std::min(controller.getLedCount(), kMaxLeds));
+    state.powerBudget = controller.getPowerBudget();
+    state.integrationUs = controller.getIntegrationTime();
+    state.settleUs = controller.getSettleTime();
+    for (size_t i = 0; i < state.ledCount; ++i)
+    {
+        const LED &led = controller.getByIndex(i);
+        state.leds[i] = {led.getIntensity(), led.getMaxIntensity(), led.getMinIntensity(),
+                         static_cast<uint8_t>(led.isLocked())};
+    }
+    return state;
+}
+
+void StateJournal::apply(const State &state, LEDController &controller)
+{
+    controller.setPowerBudget(state.powerBudget);
+    controller.setIntegrationTime(state.integrationUs);
+    controller.setSettleTime(state.settleUs);
+    for (size_t i = 0; i < state.ledCount && i < controller.getLedCount(); ++i)
+    {
+        LED &led = controller.getByIndex(i);
+        led.unlock(); // 先解锁才能写强度
+        led.setIntensity(state.leds[i].intensity);
+        led.setMaxIntensity(state.leds[i].maxIntensity);
+        led.setMinIntensity(state.leds[i].minIntensity);
+        if (state.leds[i].locked)
+            led.lock();
+    }
+}
+
+bool StateJournal::applyRecord(State &state, uint8_t field, uint8_t channel, uint32_t value)
+{
+    if (field >= Intensity && field <= Locked && channel >= state.ledCount)
+        return false;
+    switch (field)
+    {
+    case Intensity:
+        state.leds[channel].intensity = static_cast<uint8_t>(value);
+        return true;
+    case MaxIntensity:
+        state.leds[channel].maxIntensity = static_cast<uint8_t>(value);
+        return true;
+    case MinIntensity:
+        state.leds[channel].minIntensity = static_cast<uint8_t>(value);
+        return true;
+    case Locked:
+        state.leds[channel].locked = static_cast<uint8_t>(value != 0);
+        return true;
+    case PowerBudget:
+        std::memcpy(&state.powerBudget, &value, sizeof(value));
+        return true;
+    case IntegrationUs:
+        state.integrationUs = value;
+        return true;
+    case SettleUs:
+        state.settleUs = value;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool StateJournal::recover(LEDController &controller, uint64_t &replayed)
+{
+    replayed = logRecords_;
+    if (!isOpen() || !hasRecovered_)
+        return false;
+    apply(recovered_, controller);
+    last_ = read(controller);
+    baseline_ = true;
+    return true;
+}
+
+bool StateJournal::hasState() const
+{
+    return hasRecovered_;
+}
+
+void StateJournal::snapshot(const LEDController &controller)
+{
+    if (!isOpen())
+        return;
+    // 写入较旧的槽位，写完前另一个槽位仍然完整可用
+    const int target = 1 - newestSlot_;
+    SnapshotSlot &slot = slots(file_)[target];
+    slot.sequence = 0;
+    slot.state = read(controller);
+    slot.sequence = ++sequence_;
+    slot.crc = slotCrc(slot);
+    newestSlot_ = target;
+    logStart_ = sequence_;
+    logRecords_ = 0;
+    ++snapshots_;
+    last_ = slot.state;
+    baseline_ = true;
+}
+
+void StateJournal::append(Field field, uint8_t channel, uint32_t value)
+{
+    if (logRecords_ >= kLogCapacity / 2)
+        return; // capture() 会先做快照，这里不会发生
+    Record record;
+    record.sequence = sequence_ + 1;
+    record.value = value;
+    record.field = field;
+    record.channel = channel;
+    record.crc = crc16(&record, 14);
+    records(file_)[logRecords_] = record;
+    ++sequence_;
+    ++logRecords_;
+}
+
+size_t StateJournal::capture(const LEDController &controller)
+{
+    if (!isOpen())
+        return 0;
+    if (!baseline_)
+    {
+        // 未恢复也未做过快照：差分没有基准，先写完整快照
+        snapshot(controller);
+        return 1;
+    }
+    const State now = read(controller);
+    if (std::memcmp(&now, &last_, sizeof(State)) == 0)
+        return 0;
+
+    // 变化太多放不进日志剩余空间时，直接写快照
+    size_t changes = 0;
+    for (size_t i = 0; i < now.ledCount; ++i)
+        changes += (now.leds[i].intensity != last_.leds[i].intensity) +
+                   (now.leds[i].maxIntensity != last_.leds[i].maxIntensity) +
+                   (now.leds[i].minIntensity != last_.leds[i].minIntensity) +
+                   (now.leds[i].locked != last_.leds[i].locked);
+    changes += 3;
+    if (logRecords_ + changes > kLogCapacity / 2)
+    {
+        snapshot(controller);
+        return 1;
+    }
+
+    size_t written = 0;
+    auto put = [&](Field field, uint8_t channel, uint32_t before, uint32_t after)
+    {
+        if (before == after)
+            return;
+        append(field, channel, after);
+        ++written;
+    };
+    for (size_t i = 0; i < now.ledCount; ++i)
+    {
+        const auto channel = static_cast<uint8_t>(i);
+        put(Intensity, channel, last_.leds[i].intensity, now.leds[i].intensity);
+        put(MaxIntensity, channel, last_.leds[i].maxIntensity, now.leds[i].maxIntensity);
+        put(MinIntensity, channel, last_.leds[i].minIntensity, now.leds[i].minIntensity);
+        put(Locked, channel, last_.leds[i].locked, now.leds[i].locked);
+    }
+    uint32_t budgetBefore, budgetAfter;
+    std::memcpy(&budgetBefore, &last_.powerBudget, sizeof(budgetBefore));
+    std::memcpy(&budgetAfter, &now.powerBudget, sizeof(budgetAfter));
+    put(PowerBudget, 0, budgetBefore, budgetAfter);
+    put(IntegrationUs, 0, last_.integrationUs, now.integrationUs);
+    put(SettleUs, 0, last_.settleUs, now.settleUs);
+    last_ = now;
+    return written;
+}
+
+uint64_t StateJournal::getSequence() const
+{
+    return sequence_;
+}
+
+uint64_t StateJournal::getRecordsInLog() const
+{
+    return logRecords_;
+}
+
+uint64_t StateJournal::getSnapshotCount() const
+{
+    return snapshots_;
+}
@@ -0,0 +1,136 @@
+#include "TemporalDither.h"
+#include "Calibration.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <cmath>
+
+TemporalDither::TemporalDither(size_t channels)
+    : channels_(channels), error_(channels, 0.0f), target_(channels, 0.0f), active_(channels, 0.0f),
+      level_(channels, 0), frames_(channels, 0), sum_(channels, 0.0), sumSquares_(channels, 0.0),
+      lo_(channels, 255), hi_(channels, 0)
+{
+    targets_.store(std::make_shared<const Targets>(channels, -1.0f));
+}
+
+void TemporalDither::setTarget(size_t channel, float level)
+{
+    if (channel >= channels_)
+        return;
+    // 复制-修改-替换，流线程在下一帧看到新目标
+    auto targets = std::make_shared<Targets>(*targets_.load());
+    (*targets)[channel] = level < 0 ? -1.0f : std::min(level, 255.0f);
+    targets_.store(std::move(targets));
+    // 只重置这个通道的统计，其他通道不受影响
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    resetChannelStats(channel);
+}
+
+void TemporalDither::clear()
+{
+    targets_.store(std::make_shared<const Targets>(channels_, -1.0f));
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    for (size_t i = 0; i < channels_; ++i)
+        resetChannelStats(i);
+}
+
+bool TemporalDither::isActive() const
+{
+    const auto targets = targets_.load();
+    return std::any_of(targets->begin(), targets->end(), [](float t)
+                       { return t >= 0; });
+}
+
+std::vector<float> TemporalDither::getTargets() const
+{
+    return *targets_.load();
+}
+
+void TemporalDither::next(unsigned char *frame, size_t size, const Calibration &calibration)
+{
+    TRACE_SPAN("dither");
+    auto targets = targets_.load();
+    if (targets != applied_)
+    {
+        // 目标改变的通道清零误差累加器
+        for (size_t i = 0; i < channels_; ++i)
+        {
+            const float t = (*targets)[i];
+            if (!applied_ || (*applied_)[i] != t)
+                error_[i] = 0;
+            active_[i] = t >= 0 ? 1.0f : 0.0f;
+            target_[i] = t >= 0 ? t : 0.0f;
+        }
+        applied_ = std::move(targets);
+    }
+
+    // 所有通道一起计算，无分支（非抖动通道目标与误差恒为 0）
+    const size_t n = std::min(size, channels_);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const float v = target_[i] + error_[i];
+        const float q = std::clamp(std::floor(v + 0.5f), 0.0f, 255.0f);
+        error_[i] = (v - q) * active_[i];
+        level_[i] = static_cast<unsigned char>(q);
+    }
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (active_[i] != 0.0f)
+            frame[i] = calibration.getTable(i)[level_[i]];
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    if (resetStats_.exchange(false))
+    {
+        for (size_t i = 0; i < channels_; ++i)
+            resetChannelStats(i);
+    }
+    // 本帧计算期间目标又变了：这一帧按旧目标生成，不计入新目标的统计
+    if (targets_.load() != applied_)
+        return;
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (active_[i] == 0.0f)
+            continue;
+        const double deviation = level_[i] - target_[i];
+        ++frames_[i];
+        sum_[i] += level_[i];
+        sumSquares_[i] += deviation * deviation;
+        lo_[i] = std::min(lo_[i], level_[i]);
+        hi_[i] = std::max(hi_[i], level_[i]);
+    }
+}
+
+std::vector<TemporalDither::ChannelStats> TemporalDither::getStats() const
+{
+    const auto targets = targets_.load();
+    std::vector<ChannelStats> stats(channels_);
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    for (size_t i = 0; i < channels_; ++i)
+    {
+        auto &s = stats[i];
+        s.target = (*targets)[i];
+        s.frames = frames_[i];
+        if (s.frames == 0)
+            continue;
+        s.mean = sum_[i] / static_cast<double>(s.frames);
+        s.ripple = std::sqrt(sumSquares_[i] / static_cast<double>(s.frames));
+        s.lo = lo_[i];
+        s.hi = hi_[i];
+    }
+    return stats;
+}
+
+void TemporalDither::resetStats()
+{
+    resetStats_ = true;
+}
+
+void TemporalDither::resetChannelStats(size_t channel)
+{
+    frames_[channel] = 0;
+    sum_[channel] = 0;
+    sumSquares_[channel] = 0;
+    lo_[channel] = 255;
+    hi_[channel] = 0;
+}
@@ -0,0 +1,114 @@
+#include "TerminalView.h"
+#include <windows.h>
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    // 两段变化之间未变的字符少于这个数时直接重写，比再发一次光标定位（约 8 字节）更短
+    constexpr size_t kMaxGap = 6;
+
+    void moveTo(std::string &out, size_t row, size_t col)
+    {
+        char seq[24];
+        const int n = std::snprintf(seq, sizeof(seq), "\x1b[%zu;%zuH", row + 1, col + 1);
+        out.append(seq, static_cast<size_t>(n));
+    }
+}
+
+TerminalView::TerminalView(size_t rows, size_t cols)
+    : rows_(rows), cols_(cols), next_(rows * cols, ' '), shown_(rows * cols, ' ')
+{
+}
+
+size_t TerminalView::rows() const
+{
+    return rows_;
+}
+
+size_t TerminalView::cols() const
+{
+    return cols_;
+}
+
+void TerminalView::put(size_t row, size_t col, const std::string &text)
+{
+    if (row >= rows_ || col >= cols_)
+        return;
+    const size_t n = std::min(text.size(), cols_ - col);
+    std::copy_n(text.begin(), n, next_.begin() + static_cast<std::ptrdiff_t>(row * cols_ + col));
+}
+
+void TerminalView::fill(size_t row, size_t col, size_t count, char c)
+{
+    if (row >= rows_ || col >= cols_)
+        return;
+    std::fill_n(next_.begin() + static_cast<std::ptrdiff_t>(row * cols_ + col), std::min(count, cols_ - col), c);
+}
+
+void TerminalView::clear()
+{
+    std::fill(next_.begin(), next_.end(), ' ');
+}
+
+void TerminalView::present(std::string &out)
+{
+    const size_t start = out.size();
+    for (size_t row = 0; row < rows_; ++row)
+    {
+        const char *next = next_.data() + row * cols_;
+        char *shown = shown_.data() + row * cols_;
+        size_t col = 0;
+        while (col < cols_)
+        {
+            if (!full_ && next[col] == shown[col])
+            {
+                ++col;
+                continue;
+            }
+            // 一段变化：向后延伸，吸收短的未变间隙
+            size_t end = col + 1;
+            for (size_t gap = 0; end < cols_ && gap <= kMaxGap; ++end)
+            {
+                if (full_ || next[end] != shown[end])
+                    gap = 0;
+                else
+                    ++gap;
+            }
+            while (end > col + 1 && !full_ && next[end - 1] == shown[end - 1])
+                --end;
+            if (out.size() == start)
+                out += "\x1b" "7"; // 保存光标
+            moveTo(out, row, col);
+            out.append(next + col, end - col);
+            std::copy(next + col, next + end, shown + col);
+            col = end;
+        }
+    }
+    full_ = false;
+    if (out.size() != start)
+        out += "\x1b" "8"; // 恢复光标
+}
+
+void TerminalView::invalidate()
+{
+    full_ = true;
+}
+
+bool TerminalView::enableAnsi()
+{
+    HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (out == INVALID_HANDLE_VALUE || !GetConsoleMode(out, &mode))
+        return false;
+    if (mode & ENABLE_VIRTUAL_TERMINAL_PROCESSING)
+        return true;
+    return SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING) != FALSE;
+}
+
+void TerminalView::write(const std::string &data)
+{
+    // 与 std::cout 同步的 stdio 一次写出，命令输出最多插在两次刷新之间
+    std::fwrite(data.data(), 1, data.size(), stdout);
+    std::fflush(stdout);
+}
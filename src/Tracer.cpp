@@ -0,0 +1,142 @@
+#include "Tracer.h"
+#include <algorithm>
+#include <cstdio>
+
+Tracer &Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+namespace
+{
+    // 线程名只记下指针，缓冲区到真正记录时才分配
+    thread_local const char *t_threadName = nullptr;
+}
+
+Tracer::ThreadBuffer *Tracer::localBuffer(bool create)
+{
+    // 缓冲区由 Tracer 共同持有，线程退出后其事件仍可导出
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer && create)
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+        buffer->events.reset(new Event[kEventsPerThread]);
+        buffer->name.store(t_threadName, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(buffersMutex_);
+        buffer->tid = ++nextTid_;
+        buffers_.push_back(buffer);
+    }
+    return buffer.get();
+}
+
+void Tracer::start()
+{
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    originNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count();
+    dropped_ = 0;
+    // 各线程在下次记录时发现会话号变化，自行清空自己的缓冲区
+    session_.fetch_add(1, std::memory_order_release);
+    enabled_.store(true, std::memory_order_release);
+}
+
+void Tracer::setThreadName(const char *name)
+{
+    t_threadName = name;
+    if (ThreadBuffer *buffer = localBuffer(false))
+        buffer->name.store(name, std::memory_order_relaxed);
+}
+
+void Tracer::record(const char *name, std::chrono::steady_clock::time_point begin,
+                    std::chrono::steady_clock::time_point end)
+{
+    if (!isEnabled())
+        return;
+    ThreadBuffer &buffer = *localBuffer(true);
+    const uint64_t session = session_.load(std::memory_order_acquire);
+    if (buffer.session.load(std::memory_order_relaxed) != session)
+    {
+        buffer.count.store(0, std::memory_order_relaxed);
+        buffer.session.store(session, std::memory_order_release);
+    }
+    const size_t n = buffer.count.load(std::memory_order_relaxed);
+    if (n == kEventsPerThread)
+    {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    Event &event = buffer.events[n];
+    event.name = name;
+    event.beginNs = std::chrono::duration_cast<std::chrono::nanoseconds>(begin.time_since_epoch()).count() -
+                    originNs_.load(std::memory_order_relaxed);
+    event.durationNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+    buffer.count.store(n + 1, std::memory_order_release); // 导出方只读取已发布的事件
+}
+
+bool Tracer::stop(const std::string &path)
+{
+    enabled_.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    const uint64_t session = session_.load(std::memory_order_acquire);
+
+    FILE *file = std::fopen(path.c_str(), "w");
+    if (!file)
+        return false;
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    auto separator = [&]()
+    {
+        if (!first)
+            std::fputs(",\n", file);
+        first = false;
+    };
+    exported_ = 0;
+    for (const auto &buffer : buffers_)
+    {
+        // 旧会话遗留的缓冲区（该线程本次未记录）不导出
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        if (buffer->session.load(std::memory_order_acquire) != session || count == 0)
+            continue;
+        if (const char *name = buffer->name.load(std::memory_order_relaxed))
+        {
+            separator();
+            std::fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                         buffer->tid, name);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Event &event = buffer->events[i];
+            separator();
+            std::fprintf(file, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                         event.name, buffer->tid, event.beginNs / 1000.0, event.durationNs / 1000.0);
+        }
+        exported_ += count;
+    }
+    std::fputs("\n]}\n", file);
+    // 只剩这里持有的缓冲区属于已退出的线程，导出后释放
+    buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(),
+                                  [](const std::shared_ptr<ThreadBuffer> &buffer)
+                                  { return buffer.use_count() == 1; }),
+                   buffers_.end());
+    return std::fclose(file) == 0;
+}
+
+uint64_t Tracer::getEventCount() const
+{
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    if (!isEnabled())
+        return exported_;
+    const uint64_t session = session_.load(std::memory_order_acquire);
+    uint64_t total = 0;
+    for (const auto &buffer : buffers_)
+        if (buffer->session.load(std::memory_order_acquire) == session)
+            total += buffer->count.load(std::memory_order_acquire);
+    return total;
+}
+
+uint64_t Tracer::getDropped() const
+{
+    return dropped_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,174 @@
+#include "TriggerSource.h"
+#include <windows.h>
+#include <chrono>
+
+class TriggerSource::TriggerSourceImpl
+{
+public:
+    HANDLE event = nullptr;                 // event:<name>
+    HANDLE file = INVALID_HANDLE_VALUE;     // port, pipe or file
+    HANDLE readDone = nullptr;              // overlapped completion
+    bool seekable = false;                  // plain file: track the read offset
+    uint64_t offset = 0;
+    uint64_t pending = 0;                   // newlines read but not yet consumed
+    char buffer[256];
+
+    // Reads whatever is available and counts newlines; false on timeout or error
+    bool readSome(uint32_t timeoutMs)
+    {
+        OVERLAPPED ov = {};
+        ov.hEvent = readDone;
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        if (!ReadFile(file, buffer, sizeof(buffer), &got, &ov))
+        {
+            if (GetLastError() != ERROR_IO_PENDING)
+            {
+                // 文件读到末尾或管道对端断开：等待写入方追加/重连，避免空转
+                Sleep(timeoutMs < 1 ? timeoutMs : 1);
+                return false;
+            }
+            if (WaitForSingleObject(readDone, timeoutMs) != WAIT_OBJECT_0)
+            {
+                CancelIo(file);
+                GetOverlappedResult(file, &ov, &got, TRUE); // 等取消完成后再复用缓冲区
+                if (got == 0)
+                    return false;
+            }
+            else if (!GetOverlappedResult(file, &ov, &got, FALSE))
+                return false;
+        }
+        if (seekable)
+            offset += got;
+        for (DWORD i = 0; i < got; ++i)
+            if (buffer[i] == '\n')
+                ++pending;
+        return got > 0;
+    }
+};
+
+TriggerSource::TriggerSource() : impl_(new TriggerSourceImpl) {}
+
+TriggerSource::~TriggerSource()
+{
+    close();
+    delete impl_;
+}
+
+bool TriggerSource::open(const std::string &spec)
+{
+    close();
+    if (spec.rfind("event:", 0) == 0)
+    {
+        impl_->event = CreateEventA(nullptr, FALSE, FALSE, spec.substr(6).c_str());
+        if (!impl_->event)
+            return false;
+        spec_ = spec;
+        return true;
+    }
+
+    std::string path = spec;
+    const bool port = spec.rfind("COM", 0) == 0;
+    if (port)
+        path = "\\\\.\\" + spec;
+    impl_->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_OVERLAPPED, nullptr);
+    if (impl_->file == INVALID_HANDLE_VALUE)
+        return false;
+    impl_->readDone = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    if (!impl_->readDone)
+    {
+        close();
+        return false;
+    }
+    if (port)
+    {
+        // 有任何字节到达即返回
+        COMMTIMEOUTS timeouts = {};
+        timeouts.ReadIntervalTimeout = MAXDWORD;
+        timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+        timeouts.ReadTotalTimeoutConstant = MAXDWORD - 1;
+        SetCommTimeouts(impl_->file, &timeouts);
+    }
+    else
+    {
+        // 普通文件：从末尾开始，只响应打开之后追加的触发
+        LARGE_INTEGER size = {};
+        if (GetFileSizeEx(impl_->file, &size))
+        {
+            impl_->seekable = true;
+            impl_->offset = static_cast<uint64_t>(size.QuadPart);
+        }
+    }
+    spec_ = spec;
+    return true;
+}
+
+void TriggerSource::close()
+{
+    if (impl_->event)
+    {
+        CloseHandle(impl_->event);
+        impl_->event = nullptr;
+    }
+    if (impl_->file != INVALID_HANDLE_VALUE)
+    {
+        CancelIo(impl_->file);
+        CloseHandle(impl_->file);
+        impl_->file = INVALID_HANDLE_VALUE;
+    }
+    if (impl_->readDone)
+    {
+        CloseHandle(impl_->readDone);
+        impl_->readDone = nullptr;
+    }
+    impl_->seekable = false;
+    impl_->offset = 0;
+    impl_->pending = 0;
+    spec_.clear();
+}
+
+bool TriggerSource::isOpen() const
+{
+    return impl_->event || impl_->file != INVALID_HANDLE_VALUE;
+}
+
+std::string TriggerSource::getSpec() const
+{
+    return spec_;
+}
+
+bool TriggerSource::wait(uint32_t timeoutMs)
+{
+    if (impl_->event)
+    {
+        if (impl_->pending > 0)
+        {
+            --impl_->pending; // getPending() 已经取走的信号
+            return true;
+        }
+        return WaitForSingleObject(impl_->event, timeoutMs) == WAIT_OBJECT_0;
+    }
+    if (impl_->file == INVALID_HANDLE_VALUE)
+        return false;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (impl_->pending == 0)
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0)
+            return false;
+        impl_->readSome(static_cast<uint32_t>(left.count()));
+    }
+    --impl_->pending;
+    return true;
+}
+
+uint64_t TriggerSource::getPending() const
+{
+    // 自动重置事件没有计数：查询时取走已置位的信号，记为一个待处理触发，下次 wait() 立即返回
+    if (impl_->event && impl_->pending == 0 && WaitForSingleObject(impl_->event, 0) == WAIT_OBJECT_0)
+        impl_->pending = 1;
+    return impl_->pending;
+}
@@ -1,11 +1,69 @@
 #include <iostream>
+#include <string>
+#include <vector>
 #include "SerialInterface.h"
 #include "LEDController.h"
 #include "CLIApp.h"
+#include "LoadTest.h"
+#include "RecordingConverter.h"
+#include "DatasetGenerator.h"
+#include "EncoderBenchmark.h"
+#include "SpectrometerSim.h"
+#include "RecordingQuery.h"
+#include "CoroutineStress.h"
+#include "BoardBenchmark.h"
+#include "Clock.h"
 
-int main()
+int main(int argc, char *argv[])
 {
-    CLIApp app;
+    // 带参数时运行工具模式，否则进入交互命令行（可带 --fresh / --virtual-clock）
+    bool fresh = false, virtualClock = false;
+    int first = 1;
+    for (; first < argc; ++first)
+    {
+        const std::string flag = argv[first];
+        if (flag == "--fresh")
+            fresh = true;
+        else if (flag == "--virtual-clock")
+            virtualClock = true;
+        else
+            break;
+    }
+    if (first < argc)
+    {
+        std::vector<std::string> args(argv + first, argv + argc);
+        if (args[0] == "loadtest")
+            return runLoadTest(args);
+        if (args[0] == "convert")
+            return runConvertTool(args);
+        if (args[0] == "gen")
+            return runGenTool(args);
+        if (args[0] == "encbench")
+            return runEncoderBenchmark(args);
+        if (args[0] == "simspec")
+            return runSpectrometerSim(args);
+        if (args[0] == "query")
+            return runQueryTool(args);
+        if (args[0] == "costress")
+            return runCoroutineStress(args);
+        if (args[0] == "boardbench")
+            return runBoardBenchmark(args);
+        std::cout << "Usage: LightsDebugger [tool]\n"
+                     "  loadtest [port] [clients] [seconds] [batch]\n"
+                     "  convert <in.txt> <out.bin>  |  convert -r <in.bin> <out.txt>\n"
+                     "  gen <count> <file> [seed] [threads]\n"
+                     "  encbench [leds] [frames]\n"
+                     "  simspec <serial-in> <measure-out> [gain] [noise%]\n"
+                     "  query <recording> [expression] [--hist l<x>] [--stats] [--limit n] [--ranges file] [--rebuild]\n"
+                     "  costress [max sequences] [seconds per step]\n"
+                     "  boardbench [frames] [power budget]\n"
+                     "  --fresh     start the console without restoring the previous session\n"
+                     "  --virtual-clock  run do/seq timing in simulated time (instant, reproducible; no stream)\n";
+        return 1;
+    }
+
+    VirtualClock simulated;
+    CLIApp app(!fresh, virtualClock ? static_cast<Clock &>(simulated) : Clock::system());
     app.run();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,124 @@
+#include "LowDiscrepancy.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    using Kind = LowDiscrepancySequence::Kind;
+    constexpr size_t kDims = LowDiscrepancySequence::kMaxDims;
+
+    std::vector<std::vector<float>> points(Kind kind, uint32_t seed, uint64_t start, size_t count)
+    {
+        LowDiscrepancySequence sequence(kind, seed, start);
+        std::vector<std::vector<float>> out(count, std::vector<float>(kDims));
+        for (auto &p : out)
+            sequence.next(p.data(), kDims);
+        return out;
+    }
+
+    // The i-th smallest coordinate along dim lies in the i-th of cells equal
+    // intervals, i.e. every interval holds one point (up to float rounding)
+    bool stratified(const std::vector<std::vector<float>> &pts, size_t dim, size_t cells)
+    {
+        std::vector<double> x;
+        for (const auto &p : pts)
+            x.push_back(p[dim]);
+        if (x.size() != cells)
+            return false;
+        std::sort(x.begin(), x.end());
+        for (size_t i = 0; i < cells; ++i)
+        {
+            const double lo = static_cast<double>(i) / static_cast<double>(cells);
+            const double hi = static_cast<double>(i + 1) / static_cast<double>(cells);
+            if (x[i] < lo - 1e-6 || x[i] > hi + 1e-6)
+                return false;
+        }
+        return true;
+    }
+
+    // Resuming at any index continues the sequence exactly
+    void checkSeek(Kind kind, uint64_t start)
+    {
+        const auto all = points(kind, 7, 0, static_cast<size_t>(start) + 5);
+        const auto resumed = points(kind, 7, start, 5);
+        for (size_t i = 0; i < 5; ++i)
+            CHECK(all[static_cast<size_t>(start) + i] == resumed[i]);
+
+        LowDiscrepancySequence sequence(kind, 7);
+        sequence.seek(start);
+        CHECK_EQ(sequence.index(), start);
+        std::vector<float> p(kDims);
+        sequence.next(p.data(), kDims);
+        CHECK(p == resumed[0]);
+        CHECK_EQ(sequence.index(), start + 1);
+    }
+}
+
+int main()
+{
+    for (Kind kind : {Kind::Sobol, Kind::Halton})
+    {
+        const auto pts = points(kind, 1, 0, 4096);
+        bool inRange = true;
+        for (const auto &p : pts)
+            for (float x : p)
+                inRange &= x >= 0.0f && x < 1.0f;
+        CHECK(inRange);
+
+        // 同一种子可复现，不同种子给出不同的扰乱
+        CHECK(points(kind, 1, 0, 64) == std::vector<std::vector<float>>(pts.begin(), pts.begin() + 64));
+        CHECK(points(kind, 2, 0, 64) != std::vector<std::vector<float>>(pts.begin(), pts.begin() + 64));
+
+        // 跨过进位（Halton 3^6、Sobol 2^10）处续接
+        for (uint64_t start : {1ull, 728ull, 729ull, 1023ull, 1024ull, 3000ull})
+            checkSeek(kind, start);
+
+        // 每维均值接近 1/2
+        bool centred = true;
+        for (size_t d = 0; d < kDims; ++d)
+        {
+            double sum = 0;
+            for (const auto &p : pts)
+                sum += p[d];
+            centred &= std::fabs(sum / static_cast<double>(pts.size()) - 0.5) < 0.01;
+        }
+        CHECK(centred);
+    }
+
+    // Sobol：前 2^m 个点每维都是分层的；扰乱后前两维仍是 (0,m,2)-网
+    {
+        const auto pts = points(Kind::Sobol, 3, 0, 256);
+        bool everyDim = true;
+        for (size_t d = 0; d < kDims; ++d)
+            everyDim &= stratified(pts, d, 256);
+        CHECK(everyDim);
+        for (size_t rows : {1u, 2u, 4u, 16u, 64u, 256u})
+        {
+            const size_t cols = 256 / rows;
+            std::vector<int> hits(256, 0);
+            for (const auto &p : pts)
+                ++hits[static_cast<size_t>(p[0] * static_cast<float>(rows)) * cols +
+                       static_cast<size_t>(p[1] * static_cast<float>(cols))];
+            bool net = true;
+            for (int h : hits)
+                net &= h == 1;
+            CHECK(net);
+        }
+    }
+
+    // Halton：前 b^k 个点在 b 进制的 b^k 个区间中各占一个
+    {
+        const auto pts = points(Kind::Halton, 5, 0, 3125);
+        const std::vector<std::pair<size_t, size_t>> dims = {{0, 2048}, {1, 2187}, {2, 3125}, {3, 2401}, {9, 841}};
+        for (auto [dim, cells] : dims)
+            CHECK(stratified(std::vector<std::vector<float>>(pts.begin(), pts.begin() + cells), dim, cells));
+    }
+
+    Kind kind = Kind::Sobol;
+    CHECK(LowDiscrepancySequence::parse("halton", kind) && kind == Kind::Halton);
+    CHECK(LowDiscrepancySequence::parse(LowDiscrepancySequence::name(Kind::Sobol), kind) && kind == Kind::Sobol);
+    CHECK(!LowDiscrepancySequence::parse("random", kind));
+    return TestCheck::failures;
+}
@@ -0,0 +1,41 @@
+# Runs the virtual clock replay script once on the real clock: the same 105
+# frames must go out, and the timed sequence must keep its deadlines. The
+# 'clock' command is rejected on the real clock and leaves no frames behind.
+#
+#   cmake -DLIGHTS_DEBUGGER=<exe> -DSCRIPT=<commands> -DWORK_DIR=<dir> [-DMAX_P99_US=<us>] -P RealClockReplay.cmake
+
+if(NOT DEFINED MAX_P99_US)
+    set(MAX_P99_US 20000) # a fifth of the 101 ms hold; generous for a loaded machine
+endif()
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+execute_process(
+    COMMAND ${LIGHTS_DEBUGGER} --fresh
+    INPUT_FILE ${SCRIPT}
+    OUTPUT_FILE ${WORK_DIR}/console.txt
+    ERROR_FILE ${WORK_DIR}/log.txt
+    WORKING_DIRECTORY ${WORK_DIR}
+    RESULT_VARIABLE result
+    TIMEOUT 60)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "run exited with '${result}', see ${WORK_DIR}/console.txt")
+endif()
+
+file(STRINGS ${WORK_DIR}/record.txt lines)
+list(LENGTH lines frames)
+if(NOT frames EQUAL 105)
+    message(FATAL_ERROR "expected 105 recorded frames, got ${frames}")
+endif()
+
+# 'seq -w' prints: 30/30 frames, deadline lateness min a / mean b / p99 c / max d us, n overruns, ...
+file(STRINGS ${WORK_DIR}/console.txt stats REGEX "30/30 frames, deadline lateness")
+if(NOT stats MATCHES "p99 ([0-9]+) / max [0-9]+ us, ([0-9]+) overruns")
+    message(FATAL_ERROR "no lateness summary for the 30-frame sequence, see ${WORK_DIR}/console.txt")
+endif()
+set(p99 ${CMAKE_MATCH_1})
+set(overruns ${CMAKE_MATCH_2})
+message(STATUS "sequence lateness p99 ${p99} us, ${overruns} overruns")
+if(p99 GREATER MAX_P99_US OR NOT overruns EQUAL 0)
+    message(FATAL_ERROR "sequence lateness p99 ${p99} us (limit ${MAX_P99_US}), ${overruns} overruns")
+endif()
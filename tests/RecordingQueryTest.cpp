@@ -0,0 +1,139 @@
+#include "RecordingQuery.h"
+#include "RecordingFormat.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <vector>
+
+namespace
+{
+    using Frame = std::vector<unsigned char>; // 30 LED bytes
+    using Predicate = std::function<bool(const Frame &)>;
+
+    constexpr size_t kChannels = RecordingFormat::kPacketSize - 2;
+    constexpr uint64_t kFrames = 3 * RecordingIndex::kBlockFrames + 123;
+
+    // l1 counts up, l2 is constant per block (0, 255, 7) so zone maps decide
+    // whole blocks, l3 scatters, the rest are zero
+    Frame makeFrame(uint64_t f)
+    {
+        Frame frame(kChannels, 0);
+        const uint64_t block = f / RecordingIndex::kBlockFrames;
+        frame[0] = static_cast<unsigned char>(f);
+        frame[1] = block == 0 ? 0 : block == 1 ? 255 : 7;
+        frame[2] = static_cast<unsigned char>(f * 37 % 256);
+        return frame;
+    }
+
+    bool writeRecording(const std::string &path, std::vector<Frame> &frames)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        char line[RecordingFormat::kMaxLineSize];
+        for (uint64_t f = 0; f < kFrames; ++f)
+        {
+            frames.push_back(makeFrame(f));
+            unsigned char packet[RecordingFormat::kPacketSize] = {0xDA, 0xAD};
+            std::copy(frames.back().begin(), frames.back().end(), packet + 2);
+            out.write(line, static_cast<std::streamsize>(RecordingFormat::formatLine(packet, sizeof(packet), f + 1, line)));
+        }
+        return out.good();
+    }
+
+    // Compares a query with a plain scan of the frames
+    void checkQuery(const RecordingIndex &index, const std::vector<Frame> &frames, const std::string &expression,
+                    const Predicate &predicate)
+    {
+        RecordingQuery query;
+        std::string error;
+        CHECK(query.compile(expression, kChannels, error));
+        query.setHistogramChannel(2);
+        query.setStatistics(true);
+        const auto result = query.run(index);
+
+        std::vector<std::pair<uint64_t, uint64_t>> ranges;
+        std::vector<uint64_t> histogram(256, 0);
+        uint64_t matches = 0;
+        unsigned char minimum = 255, maximum = 0;
+        for (uint64_t f = 0; f < frames.size(); ++f)
+        {
+            if (!predicate(frames[f]))
+                continue;
+            ++matches;
+            ++histogram[frames[f][2]];
+            minimum = std::min(minimum, frames[f][0]);
+            maximum = std::max(maximum, frames[f][0]);
+            if (!ranges.empty() && ranges.back().second + 1 == f)
+                ranges.back().second = f;
+            else
+                ranges.push_back({f, f});
+        }
+        CHECK_EQ(result.matches, matches);
+        CHECK(result.ranges == ranges);
+        CHECK(result.histogram == histogram);
+        CHECK_EQ(result.blocksScanned + result.blocksSkipped, index.getBlockCount());
+        if (matches)
+        {
+            CHECK_EQ(result.minimum[0], minimum);
+            CHECK_EQ(result.maximum[0], maximum);
+        }
+        if (result.matches != matches)
+            std::cout << "[Info] expression: " << expression << "\n";
+    }
+}
+
+int main()
+{
+    const std::string path = "recording_query_test.txt";
+    std::vector<Frame> frames;
+    CHECK(writeRecording(path, frames));
+
+    RecordingIndex index;
+    std::string error;
+    CHECK(index.open(path, true, error));
+    CHECK(index.wasBuilt());
+    CHECK_EQ(index.getFrameCount(), kFrames);
+    CHECK_EQ(index.getChannelCount(), kChannels);
+    CHECK_EQ(index.getBlockCount(), uint64_t(4));
+
+    checkQuery(index, frames, "", [](const Frame &) { return true; });
+    checkQuery(index, frames, "l1 > 200", [](const Frame &f) { return f[0] > 200; });
+    checkQuery(index, frames, "l1 >= 200 and l3 < 50", [](const Frame &f) { return f[0] >= 200 && f[2] < 50; });
+    checkQuery(index, frames, "l1 == 0 || l1 = 255", [](const Frame &f) { return f[0] == 0 || f[0] == 255; });
+    checkQuery(index, frames, "!(l3 <= 127)", [](const Frame &f) { return f[2] > 127; });
+    checkQuery(index, frames, "not l1 != 9", [](const Frame &f) { return f[0] == 9; });
+    checkQuery(index, frames, "l2 == 255 and (l1 < 10 or l3 > 250)",
+               [](const Frame &f) { return f[1] == 255 && (f[0] < 10 || f[2] > 250); });
+    checkQuery(index, frames, "l4 > 0", [](const Frame &) { return false; });
+
+    // 常量块应由区间图直接判定，不读数据
+    {
+        RecordingQuery query;
+        CHECK(query.compile("l2 == 255", kChannels, error));
+        const auto result = query.run(index);
+        CHECK_EQ(result.matches, uint64_t(RecordingIndex::kBlockFrames));
+        CHECK_EQ(result.blocksScanned, uint64_t(0));
+        CHECK_EQ(result.blocksSkipped, uint64_t(4));
+    }
+
+    // 语法错误与越界的灯号
+    for (const char *bad : {"l1 >", "l31 > 3", "l0 == 1", "l1 > 256", "(l1 > 3", "l1 > 3 and", "x > 3"})
+    {
+        RecordingQuery query;
+        error.clear();
+        CHECK(!query.compile(bad, kChannels, error));
+        CHECK(!error.empty());
+    }
+
+    // 未改动的录制应复用已有索引
+    index.close();
+    RecordingIndex reopened;
+    CHECK(reopened.open(path, false, error));
+    CHECK(!reopened.wasBuilt());
+    reopened.close();
+
+    std::remove(RecordingIndex::indexPathFor(path).c_str());
+    std::remove(path.c_str());
+    return TestCheck::failures;
+}
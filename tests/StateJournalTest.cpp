@@ -0,0 +1,148 @@
+#include "StateJournal.h"
+#include "LEDController.h"
+#include "TestCheck.h"
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    // File layout as written by StateJournal.cpp: 16-byte header, snapshot
+    // slots A and B (288 bytes each), log of 16-byte records from offset 640
+    constexpr std::streamoff kSlotOffset = 16;
+    constexpr std::streamoff kLogOffset = 640;
+    constexpr std::streamoff kRecordSize = 16;
+
+    void flipByte(const std::string &path, std::streamoff offset)
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(offset);
+        char c = 0;
+        file.read(&c, 1);
+        c = static_cast<char>(c ^ 0x5A);
+        file.seekp(offset);
+        file.write(&c, 1);
+    }
+
+    void checkSame(const LEDController &a, const LEDController &b)
+    {
+        CHECK_EQ(a.getPowerBudget(), b.getPowerBudget());
+        CHECK_EQ(a.getIntegrationTime(), b.getIntegrationTime());
+        CHECK_EQ(a.getSettleTime(), b.getSettleTime());
+        for (size_t i = 0; i < a.getLedCount(); ++i)
+        {
+            const LED &x = a.getByIndex(i), &y = b.getByIndex(i);
+            CHECK_EQ(x.getIntensity(), y.getIntensity());
+            CHECK_EQ(x.getMaxIntensity(), y.getMaxIntensity());
+            CHECK_EQ(x.getMinIntensity(), y.getMinIntensity());
+            CHECK_EQ(x.isLocked(), y.isLocked());
+        }
+    }
+
+    // Opens path and recovers it into a fresh controller
+    bool recoverInto(const std::string &path, LEDController &controller, uint64_t &replayed)
+    {
+        StateJournal journal;
+        if (!journal.open(path, controller.getLedCount()))
+            return false;
+        return journal.recover(controller, replayed);
+    }
+}
+
+int main()
+{
+    const std::string path = "state_journal_test.bin";
+    std::remove(path.c_str());
+    LEDController live;
+    const size_t leds = live.getLedCount();
+    uint64_t replayed = 0;
+
+    // 新文件：没有状态，首次 capture 写完整快照
+    {
+        StateJournal journal;
+        CHECK(journal.open(path, leds));
+        CHECK(!journal.hasState());
+        CHECK_EQ(journal.capture(live), size_t(1));
+        CHECK_EQ(journal.getSnapshotCount(), uint64_t(1));
+        CHECK_EQ(journal.capture(live), size_t(0));
+
+        live.getByIndex(0).setIntensity(10);
+        CHECK_EQ(journal.capture(live), size_t(1));
+        live.getByIndex(1).setIntensity(20);
+        live.getByIndex(1).setMaxIntensity(200);
+        CHECK_EQ(journal.capture(live), size_t(2));
+        live.getByIndex(2).lock();
+        live.setPowerBudget(12.5f);
+        live.setIntegrationTime(3000);
+        CHECK_EQ(journal.capture(live), size_t(3));
+        CHECK_EQ(journal.getRecordsInLog(), uint64_t(6));
+    }
+
+    // 快照 + 完整日志回放
+    {
+        LEDController restored;
+        CHECK(recoverInto(path, restored, replayed));
+        CHECK_EQ(replayed, uint64_t(6));
+        checkSame(live, restored);
+    }
+
+    // 第 4 条记录损坏：回放停在第 3 条，之后的记录不生效
+    {
+        flipByte(path, kLogOffset + 3 * kRecordSize + 8);
+        LEDController restored;
+        CHECK(recoverInto(path, restored, replayed));
+        CHECK_EQ(replayed, uint64_t(3));
+        CHECK_EQ(restored.getByIndex(0).getIntensity(), 10);
+        CHECK_EQ(restored.getByIndex(1).getMaxIntensity(), 200);
+        CHECK(!restored.getByIndex(2).isLocked());
+        CHECK_EQ(restored.getPowerBudget(), LEDController().getPowerBudget());
+        CHECK_EQ(restored.getIntegrationTime(), LEDController().getIntegrationTime());
+    }
+
+    // 恢复后继续写：新记录覆盖损坏处，序号接着已回放的部分
+    {
+        StateJournal journal;
+        CHECK(journal.open(path, leds));
+        LEDController restored;
+        CHECK(journal.recover(restored, replayed));
+        CHECK_EQ(journal.capture(live), size_t(3));
+        journal.close();
+        LEDController again;
+        CHECK(recoverInto(path, again, replayed));
+        CHECK_EQ(replayed, uint64_t(6));
+        checkSame(live, again);
+    }
+
+    // 较新的快照损坏：退回另一个槽位，旧槽位之后的日志已被新一轮覆盖，不再回放
+    {
+        StateJournal journal;
+        CHECK(journal.open(path, leds));
+        LEDController restored;
+        CHECK(journal.recover(restored, replayed));
+        journal.snapshot(live); // 首个快照在槽位 B，这次写入槽位 A
+        live.getByIndex(5).setIntensity(55);
+        CHECK_EQ(journal.capture(live), size_t(1));
+        journal.close();
+
+        flipByte(path, kSlotOffset + 20); // 槽位 A 的状态
+        LEDController fallback;
+        CHECK(recoverInto(path, fallback, replayed));
+        CHECK_EQ(replayed, uint64_t(0));
+        CHECK_EQ(fallback.getByIndex(0).getIntensity(), 0); // 槽位 B 是最初的默认状态
+        CHECK_EQ(fallback.getByIndex(5).getIntensity(), 0);
+    }
+
+    // 灯数不符时整个文件清零重建，旧快照和旧记录都不再可见
+    {
+        StateJournal journal;
+        CHECK(journal.open(path, leds - 1));
+        CHECK(!journal.hasState());
+        journal.close();
+        CHECK(journal.open(path, leds));
+        CHECK(!journal.hasState());
+        CHECK_EQ(journal.getSequence(), uint64_t(0));
+        journal.close();
+    }
+
+    std::remove(path.c_str());
+    return TestCheck::failures;
+}
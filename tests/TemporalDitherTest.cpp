@@ -0,0 +1,122 @@
+#include "TemporalDither.h"
+#include "Calibration.h"
+#include "TestCheck.h"
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    constexpr size_t kChannels = 30;
+    constexpr unsigned char kUntouched = 77; // value of channels that are not dithered
+}
+
+int main()
+{
+    const Calibration identity(kChannels);
+    std::vector<unsigned char> frame(kChannels);
+
+    // 12.37：只发 12 和 13，任意前缀的累计误差不超过半级，均值收敛到目标
+    {
+        TemporalDither dither(kChannels);
+        CHECK(!dither.isActive());
+        dither.setTarget(0, 12.37f);
+        CHECK(dither.isActive());
+        double sum = 0;
+        bool onlyNeighbours = true, bounded = true, untouched = true;
+        for (int k = 1; k <= 1000; ++k)
+        {
+            std::fill(frame.begin(), frame.end(), kUntouched);
+            dither.next(frame.data(), frame.size(), identity);
+            onlyNeighbours &= frame[0] == 12 || frame[0] == 13;
+            sum += frame[0];
+            bounded &= std::fabs(sum - k * 12.37) <= 0.5 + 1e-3;
+            for (size_t i = 1; i < kChannels; ++i)
+                untouched &= frame[i] == kUntouched;
+        }
+        CHECK(onlyNeighbours);
+        CHECK(bounded);
+        CHECK(untouched);
+        const auto stats = dither.getStats();
+        CHECK_EQ(stats[0].frames, uint64_t(1000));
+        CHECK(std::fabs(stats[0].mean - 12.37) < 1e-3);
+        CHECK_EQ(stats[0].lo, 12);
+        CHECK_EQ(stats[0].hi, 13);
+        CHECK(stats[0].ripple > 0.4 && stats[0].ripple < 0.5); // sqrt(0.37 * 0.63) ≈ 0.48
+        CHECK_EQ(stats[1].frames, uint64_t(0));
+        CHECK(stats[1].target < 0);
+    }
+
+    // 整数目标与越界目标：不抖动，纹波为 0
+    {
+        TemporalDither dither(kChannels);
+        dither.setTarget(3, 40.0f);
+        dither.setTarget(4, 300.0f);
+        for (int k = 0; k < 50; ++k)
+        {
+            dither.next(frame.data(), frame.size(), identity);
+            CHECK_EQ(frame[3], 40);
+            CHECK_EQ(frame[4], 255);
+        }
+        const auto stats = dither.getStats();
+        CHECK_EQ(stats[3].ripple, 0.0);
+        CHECK_EQ(stats[4].target, 255.0f);
+    }
+
+    // 输出经过校准表
+    {
+        Calibration inverted(kChannels);
+        unsigned char table[256];
+        for (int v = 0; v < 256; ++v)
+            table[v] = static_cast<unsigned char>(255 - v);
+        inverted.setTable(2, table);
+        TemporalDither dither(kChannels);
+        dither.setTarget(2, 100.5f);
+        for (int k = 0; k < 20; ++k)
+        {
+            dither.next(frame.data(), frame.size(), inverted);
+            CHECK(frame[2] == 155 || frame[2] == 154);
+        }
+        CHECK(std::fabs(dither.getStats()[2].mean - 100.5) < 0.05);
+    }
+
+    // 改另一个通道的目标不影响本通道的误差与统计；停止后通道不再被覆盖
+    {
+        TemporalDither changed(kChannels), reference(kChannels);
+        changed.setTarget(0, 7.3f);
+        reference.setTarget(0, 7.3f);
+        std::vector<unsigned char> other(kChannels);
+        bool same = true;
+        for (int k = 0; k < 200; ++k)
+        {
+            if (k == 61)
+                changed.setTarget(1, 3.5f);
+            if (k == 130)
+                changed.setTarget(1, -1.0f);
+            changed.next(frame.data(), frame.size(), identity);
+            reference.next(other.data(), other.size(), identity);
+            same &= frame[0] == other[0];
+        }
+        CHECK(same);
+        const auto stats = changed.getStats();
+        CHECK_EQ(stats[0].frames, uint64_t(200));
+        CHECK_EQ(stats[1].frames, uint64_t(0));
+        CHECK(stats[1].target < 0);
+
+        frame[1] = kUntouched;
+        changed.next(frame.data(), frame.size(), identity);
+        CHECK_EQ(frame[1], kUntouched);
+
+        // 重新设置本通道：只有它的统计从头开始
+        changed.setTarget(0, 7.3f);
+        changed.setTarget(5, 1.5f);
+        changed.next(frame.data(), frame.size(), identity);
+        CHECK_EQ(changed.getStats()[0].frames, uint64_t(1));
+
+        changed.clear();
+        CHECK(!changed.isActive());
+        CHECK_EQ(changed.getStats()[0].frames, uint64_t(0));
+        CHECK_EQ(changed.getStats()[5].frames, uint64_t(0));
+    }
+
+    return TestCheck::failures;
+}
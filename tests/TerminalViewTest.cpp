@@ -0,0 +1,153 @@
+#include "TerminalView.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+    // Applies the subset of ANSI that present() emits (ESC 7, ESC 8,
+    // ESC [ row ; col H and plain text) to a screen of rows x cols
+    struct Screen
+    {
+        Screen(size_t rows, size_t cols) : cols(cols), cells(rows * cols, ' ') {}
+
+        bool feed(const std::string &data)
+        {
+            for (size_t i = 0; i < data.size();)
+            {
+                if (data[i] != '\x1b')
+                {
+                    if (row * cols + col >= cells.size())
+                        return false;
+                    cells[row * cols + col++] = data[i++];
+                    continue;
+                }
+                if (i + 1 >= data.size())
+                    return false;
+                if (data[i + 1] == '7' || data[i + 1] == '8')
+                {
+                    if (data[i + 1] == '7')
+                        saved = {row, col};
+                    else
+                        std::tie(row, col) = saved;
+                    i += 2;
+                    continue;
+                }
+                size_t r = 0, c = 0;
+                int consumed = 0;
+                if (std::sscanf(data.c_str() + i, "\x1b[%zu;%zuH%n", &r, &c, &consumed) != 2 || consumed == 0)
+                    return false;
+                row = r - 1;
+                col = c - 1;
+                i += static_cast<size_t>(consumed);
+            }
+            return true;
+        }
+
+        size_t cols;
+        std::string cells;
+        size_t row = 30, col = 0; // the real cursor sits below the view
+        std::pair<size_t, size_t> saved;
+    };
+
+    size_t count(const std::string &text, const std::string &what)
+    {
+        size_t n = 0;
+        for (size_t pos = text.find(what); pos != std::string::npos; pos = text.find(what, pos + 1))
+            ++n;
+        return n;
+    }
+}
+
+int main()
+{
+    constexpr size_t kRows = 5, kCols = 40;
+    TerminalView view(kRows, kCols);
+    Screen screen(kRows, kCols);
+    std::string out;
+
+    // 首次 present 整屏重绘，前后保存/恢复光标
+    view.put(0, 0, "hello");
+    view.present(out);
+    CHECK(out.compare(0, 2, "\x1b" "7") == 0);
+    CHECK(out.compare(out.size() - 2, 2, "\x1b" "8") == 0);
+    CHECK(screen.feed(out));
+    CHECK(screen.cells.compare(0, 5, "hello") == 0);
+    CHECK_EQ(screen.row, size_t(30));
+
+    // 没有变化时什么也不输出
+    out.clear();
+    view.present(out);
+    CHECK(out.empty());
+
+    // 相隔很近的两处变化合成一段，相隔很远的分两段定位
+    view.put(1, 2, "a");
+    view.put(1, 6, "b");
+    out.clear();
+    view.present(out);
+    CHECK_EQ(count(out, "\x1b["), size_t(1));
+    CHECK(out.find("a   b") != std::string::npos);
+    CHECK(screen.feed(out));
+    view.put(2, 0, "x");
+    view.put(2, 30, "y");
+    out.clear();
+    view.present(out);
+    CHECK_EQ(count(out, "\x1b["), size_t(2));
+    CHECK(screen.feed(out));
+
+    // 超出网格的文本被裁掉
+    view.put(3, 35, "0123456789");
+    view.put(kRows, 0, "outside");
+    view.fill(4, 38, 10, '#');
+    out.clear();
+    view.present(out);
+    CHECK(screen.feed(out));
+    CHECK(screen.cells.compare(3 * kCols + 35, 5, "01234") == 0);
+    CHECK(screen.cells.compare(4 * kCols + 38, 2, "##") == 0);
+
+    // 随机编辑：每次 present 之后屏幕与期望内容一致
+    std::mt19937 rng(42);
+    std::string expected = screen.cells;
+    bool matches = true, restored = true;
+    for (int frame = 0; frame < 500; ++frame)
+    {
+        const int edits = static_cast<int>(rng() % 6);
+        for (int e = 0; e < edits; ++e)
+        {
+            const size_t row = rng() % kRows, col = rng() % kCols;
+            std::string text(1 + rng() % 8, ' ');
+            for (auto &ch : text)
+                ch = static_cast<char>('a' + rng() % 3);
+            view.put(row, col, text);
+            expected.replace(row * kCols + col, std::min(text.size(), kCols - col), text, 0,
+                             std::min(text.size(), kCols - col));
+        }
+        out.clear();
+        view.present(out);
+        matches &= screen.feed(out) && screen.cells == expected;
+        restored &= screen.row == 30 && screen.col == 0;
+    }
+    CHECK(matches);
+    CHECK(restored);
+
+    // 清屏后 invalidate：下一次重绘每个格子
+    view.invalidate();
+    screen.cells.assign(kRows * kCols, ' ');
+    out.clear();
+    view.present(out);
+    CHECK(screen.feed(out));
+    CHECK(screen.cells == expected);
+    CHECK_EQ(count(out, "\x1b["), kRows);
+
+    // clear() 之后下一帧把屏幕擦空
+    view.clear();
+    out.clear();
+    view.present(out);
+    CHECK(screen.feed(out));
+    CHECK(screen.cells == std::string(kRows * kCols, ' '));
+    return TestCheck::failures;
+}
@@ -0,0 +1,35 @@
+#ifndef TESTCHECK_H
+#define TESTCHECK_H
+#include <iostream>
+
+// Minimal checks for the unit tests. A failed check prints its location and
+// counts; main returns TestCheck::failures so ctest marks the test failed.
+namespace TestCheck
+{
+    inline int failures = 0;
+}
+
+#define CHECK(cond)                                                                                 \
+    do                                                                                              \
+    {                                                                                               \
+        if (!(cond))                                                                                \
+        {                                                                                           \
+            ++TestCheck::failures;                                                                  \
+            std::cout << "[Error] " << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+        }                                                                                           \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                              \
+    do                                                                                              \
+    {                                                                                               \
+        const auto checkA_ = (a);                                                                   \
+        const auto checkB_ = (b);                                                                   \
+        if (!(checkA_ == checkB_))                                                                  \
+        {                                                                                           \
+            ++TestCheck::failures;                                                                  \
+            std::cout << "[Error] " << __FILE__ << ":" << __LINE__ << ": " #a " == " #b " failed (" \
+                      << +checkA_ << " vs " << +checkB_ << ")\n";                                   \
+        }                                                                                           \
+    } while (0)
+
+#endif // TESTCHECK_H
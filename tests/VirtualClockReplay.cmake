@@ -0,0 +1,45 @@
+# Runs the console twice under --virtual-clock with the same seeded script and
+# requires byte-identical serial output, recording and black box dump (the
+# dump carries simulated timestamps). Log lines go to the console
+# asynchronously, so the console text itself is not compared.
+#
+#   cmake -DLIGHTS_DEBUGGER=<exe> -DSCRIPT=<commands> -DWORK_DIR=<dir> -P VirtualClockReplay.cmake
+
+set(outputs port.bin record.txt blackbox.txt)
+
+foreach(run first second)
+    set(dir ${WORK_DIR}/${run})
+    file(REMOVE_RECURSE ${dir})
+    file(MAKE_DIRECTORY ${dir})
+    execute_process(
+        COMMAND ${LIGHTS_DEBUGGER} --fresh --virtual-clock
+        INPUT_FILE ${SCRIPT}
+        OUTPUT_FILE ${dir}/console.txt
+        ERROR_FILE ${dir}/log.txt
+        WORKING_DIRECTORY ${dir}
+        RESULT_VARIABLE result
+        TIMEOUT 60)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${run} run exited with '${result}', see ${dir}/console.txt")
+    endif()
+    foreach(output ${outputs})
+        if(NOT EXISTS ${dir}/${output})
+            message(FATAL_ERROR "${run} run did not write ${output}")
+        endif()
+    endforeach()
+endforeach()
+
+foreach(output ${outputs})
+    file(SHA256 ${WORK_DIR}/first/${output} first)
+    file(SHA256 ${WORK_DIR}/second/${output} second)
+    if(NOT first STREQUAL second)
+        message(FATAL_ERROR "${output} differs between runs with the same seed")
+    endif()
+endforeach()
+
+# 105 sent frames: 50 + 20 from 'do', 30 from 'seq', 5 more after the clock jump
+file(STRINGS ${WORK_DIR}/first/record.txt lines)
+list(LENGTH lines frames)
+if(NOT frames EQUAL 105)
+    message(FATAL_ERROR "expected 105 recorded frames, got ${frames}")
+endif()